@@ -3,24 +3,21 @@
 // проверка поля: генерирование новой фигуры, уничтожение заполненных линий
 // (+сдвиг), подсчет уничтоженных линий, обновление счета и рекорда, повышение
 // скорости, проверка на окончание игры (проверка верхней строки)
-void check_field(GameInfo_t *game) {
+void check_field(TetrisContext *ctx) {
+  GameInfo_t *game = &ctx->game;
+  Board_t *board = &ctx->board;
   game->pause = next_figure;
-  int counter_of_completed_place = 0, flag_for_counter = 1,
-      counter_for_score = 0;
-  for (int i = 0; i < FIELD_HEIGHT; ++i) {
-    counter_of_completed_place = 0, flag_for_counter = 1;
-    for (int j = 0; j < FIELD_WIDTH && flag_for_counter; ++j) {
-      if (game->field[i][j] != EMPTY_PLACE) {
-        counter_of_completed_place++;
-      } else {
-        flag_for_counter = 0;
-      }
-    }
-    if (counter_of_completed_place == REAL_FIELD_WIDTH) {
-      clear_and_shift(game, i);
-      counter_for_score++;
-    }
+  uint32_t lines = board_full_rows(board);
+  int counter_for_score = 0;
+  for (uint32_t rest = lines; rest; rest &= rest - 1) {
+    counter_for_score++;
+  }
+  if (lines) {
+    clear_lines(ctx, lines);
   }
+  ctx->cleared = lines;
+  ctx->pieces++;
+  ctx->lines += counter_for_score;
   switch (counter_for_score) {
     case 1:
       game->score += ONE_LINE;
@@ -42,107 +39,116 @@ void check_field(GameInfo_t *game) {
     game->high_score = game->score;
   }
   // check the highest line
-  for (int i = 0; i < FIELD_WIDTH; ++i) {
-    if (game->field[0][i] != 0) {
-      game->pause = game_over;
-    }
+  if (board->rows[HIGHEST_LINE] != 0) {
+    game->pause = game_over;
   }
 }
 
-// уничтожение полностью заполненного ряда со сдвигом всех тетромино, лежащих
-// выше, на позицию вниз
-void clear_and_shift(GameInfo_t *game, int line) {
-  for (int i = line; i > 0; --i) {
-    for (int j = 0; j < FIELD_WIDTH; ++j) {
-      game->field[i][j] = game->field[i - 1][j];
+// уничтожение всех заполненных рядов за один проход снизу вверх: каждый
+// оставшийся ряд сдвигается вниз один раз (переставляется только указатель на
+// ряд), освободившиеся ряды очищаются и становятся верхними
+void clear_lines(TetrisContext *ctx, uint32_t lines) {
+  int **field = ctx->game.field;
+  int *removed[FIELD_HEIGHT];
+  int count = 0, dst = FIELD_HEIGHT - 1;
+  STATS_ADD(clears, 1);
+  for (int src = FIELD_HEIGHT - 1; src >= 0; --src) {
+    if (lines >> src & 1u) {
+      removed[count++] = field[src];
+    } else {
+      field[dst--] = field[src];
     }
   }
-  for (int i = 0; i < FIELD_WIDTH; ++i) {  // fill the highest line by zeros
-    game->field[0][i] = EMPTY_PLACE;
+  for (int i = 0; i < count; ++i) {
+    memset(removed[i], EMPTY_PLACE, FIELD_WIDTH * sizeof(int));
+    field[i] = removed[i];
   }
+  STATS_ADD(lines, count);
+  board_remove_rows(&ctx->board, lines);
+  features_remove_rows(&ctx->features, &ctx->board, lines);
 }
 
-// массив с базовыми положениями фигур
+// координата части фигуры из таблицы базовых положений
 int figures_mass(int type_figure, int rotation, int part, int coord) {
-  int figures[COUNT_OF_FIGURES][COUNT_OF_ROTATIONS][FIGURE_PART][2] = {
-      {{{0, 3}, {0, 4}, {0, 5}, {0, 6}},
-       {{-1, 5}, {0, 5}, {1, 5}, {2, 5}},
-       {{1, 3}, {1, 4}, {1, 5}, {1, 6}},
-       {{-1, 4}, {0, 4}, {1, 4}, {2, 4}}},  // I
-      {{{0, 4}, {1, 4}, {2, 4}, {2, 5}},
-       {{2, 3}, {1, 3}, {1, 4}, {1, 5}},
-       {{0, 3}, {0, 4}, {1, 4}, {2, 4}},
-       {{1, 3}, {1, 4}, {1, 5}, {0, 5}}},  // L
-      {{{0, 4}, {1, 4}, {2, 4}, {2, 3}},
-       {{0, 3}, {1, 3}, {1, 4}, {1, 5}},
-       {{0, 5}, {0, 4}, {1, 4}, {2, 4}},
-       {{1, 3}, {1, 4}, {1, 5}, {2, 5}}},  // J
-      {{{0, 4}, {1, 4}, {0, 5}, {1, 5}},
-       {{0, 4}, {1, 4}, {0, 5}, {1, 5}},
-       {{0, 4}, {1, 4}, {0, 5}, {1, 5}},
-       {{0, 4}, {1, 4}, {0, 5}, {1, 5}}},  // O
-      {{{1, 3}, {1, 4}, {0, 4}, {0, 5}},
-       {{0, 4}, {1, 4}, {1, 5}, {2, 5}},
-       {{2, 3}, {2, 4}, {1, 4}, {1, 5}},
-       {{0, 3}, {1, 3}, {1, 4}, {2, 4}}},  // S
-      {{{0, 3}, {0, 4}, {1, 4}, {1, 5}},
-       {{0, 5}, {1, 5}, {1, 4}, {2, 4}},
-       {{1, 3}, {1, 4}, {2, 4}, {2, 5}},
-       {{0, 4}, {1, 4}, {1, 3}, {2, 3}}},  // Z
-      {{{0, 4}, {1, 4}, {1, 3}, {1, 5}},
-       {{0, 4}, {1, 4}, {2, 4}, {1, 5}},
-       {{1, 3}, {1, 4}, {1, 5}, {2, 4}},
-       {{0, 4}, {1, 4}, {2, 4}, {1, 3}}}  // T
-  };
-  return figures[type_figure][rotation][part][coord];
+  return shape_get(type_figure, rotation)->cells[part][coord];
 }
 
-// сдвиг фигуры вниз с проверкой на возможность совершения этого дейстия
-bool shift_figure(Figure_position *figure, GameInfo_t *game) {
-  bool flag = true;
-  int curr_figure = figure->figure;
-  if (can_move(figure, game, MOVE_DOWN)) {
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      game->field[figure->x + figures_mass(curr_figure, figure->rotation, i, 0)]
-                 [figure->y + figures_mass(curr_figure, figure->rotation, i,
-                                           1)] = EMPTY_PLACE;
-    }
+// сдвиг фигуры вниз с проверкой на возможность совершения этого дейстия;
+// падающая фигура на поле не рисуется, меняется только ее положение, а
+// упавшую фигуру один раз фиксирует tetris_step
+bool shift_figure(TetrisContext *ctx) {
+  Figure_position *figure = &ctx->figure;
+  bool flag = can_move(ctx, MOVE_DOWN);
+  if (flag) {
     figure->x += 1;
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      game->field[figure->x + figures_mass(curr_figure, figure->rotation, i, 0)]
-                 [figure->y + figures_mass(curr_figure, figure->rotation, i,
-                                           1)] = MOVING_PLACE + curr_figure + 1;
-    }
-  } else {
-    fix_figure(figure, game);
-    flag = false;
   }
   return flag;
 }
 
 // "фиксируем" фигуру на поле
-void fix_figure(Figure_position *figure, GameInfo_t *game) {
+void fix_figure(TetrisContext *ctx) {
+  GameInfo_t *game = &ctx->game;
+  Figure_position *figure = &ctx->figure;
+  Board_t *board = &ctx->board;
+  const Shape_t *shape = shape_get(figure->figure, figure->rotation);
   for (int i = 0; i < FIGURE_PART; ++i) {
-    game->field[figure->x +
-                figures_mass(figure->figure, figure->rotation, i, 0)]
-               [figure->y + figures_mass(figure->figure, figure->rotation, i,
-                                         1)] = figure->figure + 1;
+    game->field[figure->x + shape->cells[i][0]]
+               [figure->y + shape->cells[i][1]] = figure->figure + 1;
+  }
+  uint16_t overlap = 0;
+  for (int i = shape->min_row; i <= shape->max_row; ++i) {
+    uint16_t mask = shape_row_mask(shape, i - shape->min_row, figure->y);
+    overlap |= board->rows[figure->x + i] & mask;
+    board->rows[figure->x + i] |= mask;
+  }
+  // признаки по одной фигуре считаются только для свободных клеток; фигура,
+  // появившаяся поверх занятых (конец игры), пересчитывает их по доске
+  if (overlap) {
+    features_load(&ctx->features, board);
+  } else {
+    features_place(&ctx->features, shape, figure->x, figure->y);
   }
 }
 
-// максимальный сдвиг фигуры вниз (сброс)
-void fall_figure(Figure_position *figure, GameInfo_t *game) {
-  // если что-то пойдет не так, счетчик ограничит количество итераций
-  int counter = 0;
-  while (shift_figure(figure, game) && counter < 20) {
-    counter++;
+// расстояние до места падения: под каждым столбцом фигуры ближайшая занятая
+// клетка берется из высоты столбца, и только если фигура уже ниже верха
+// столбца (под навесом), она ищется по маскам рядов
+int drop_distance(const TetrisContext *ctx) {
+  const Figure_position *figure = &ctx->figure;
+  const Shape_t *shape = shape_get(figure->figure, figure->rotation);
+  int distance = FIELD_HEIGHT;
+  for (int col = shape->min_col; col <= shape->max_col; ++col) {
+    int j = col + figure->y;
+    int bottom = figure->x + shape->bottom[col - shape->min_col];
+    int below = BOARD_FLOOR - ctx->features.height[j];
+    if (below <= bottom) {
+      below = bottom + 1;
+      while (below < BOARD_FLOOR && !(ctx->board.rows[below] >> j & 1u)) {
+        below++;
+      }
+    }
+    if (below - bottom - 1 < distance) {
+      distance = below - bottom - 1;
+    }
   }
+  return distance;
+}
+
+// максимальный сдвиг фигуры вниз (сброс): фигура сразу переносится на место
+// падения и фиксируется в конце того же шага
+void fall_figure(TetrisContext *ctx) {
+  Figure_position *figure = &ctx->figure;
+  figure->x += drop_distance(ctx);
 }
 
-// проверка на возможность сдвига влево/вправо/вниз/поворота
-bool can_move(Figure_position *figure, GameInfo_t *game, int type_move) {
+// проверка на возможность сдвига влево/вправо/вниз/поворота: границы
+// проверяются по габаритам фигуры, пересечения - по маскам рядов
+bool can_move(TetrisContext *ctx, int type_move) {
+  const Figure_position *figure = &ctx->figure;
+  const Board_t *board = &ctx->board;
   bool flag = true;
   int change_x = 0, change_y = 0, rotation = figure->rotation;
+  STATS_ADD(collisions, 1);
   if (type_move == MOVE_LEFT) {
     change_y = -1;
   }
@@ -155,16 +161,18 @@ bool can_move(Figure_position *figure, GameInfo_t *game, int type_move) {
   if (type_move == ROTATING) {
     rotation = (figure->rotation + 1) % COUNT_OF_ROTATIONS;
   }
-  int curr_figure = figure->figure;
-  for (int i = 0; i < FIGURE_PART && flag; ++i) {
-    int new_x = figure->x + change_x;
-    int new_y = figure->y + change_y;
-    new_x += figures_mass(curr_figure, rotation, i, 0);
-    new_y += figures_mass(curr_figure, rotation, i, 1);
-    if (new_x >= FIELD_HEIGHT - 1 || new_x <= ZERO_X ||
-        new_y >= FIELD_WIDTH - 1 || new_y < ZERO_Y ||
-        (game->field[new_x][new_y] > EMPTY_PLACE &&
-         game->field[new_x][new_y] <= COUNT_OF_FIGURES)) {
+  const Shape_t *shape = shape_get(figure->figure, rotation);
+  int new_x = figure->x + change_x;
+  int new_y = figure->y + change_y;
+  if (new_x + shape->max_row >= FIELD_HEIGHT - 1 ||
+      new_x + shape->min_row <= ZERO_X ||
+      new_y + shape->max_col >= FIELD_WIDTH - 1 ||
+      new_y + shape->min_col < ZERO_Y) {
+    flag = false;
+  }
+  for (int i = shape->min_row; i <= shape->max_row && flag; ++i) {
+    if (board->rows[new_x + i] &
+        shape_row_mask(shape, i - shape->min_row, new_y)) {
       flag = false;
     }
   }
@@ -172,27 +180,16 @@ bool can_move(Figure_position *figure, GameInfo_t *game, int type_move) {
 }
 
 // поворот с проверкой возможности действия на месте и со сдвигом
-void rotate(Figure_position *figure, GameInfo_t *game) {
-  int old_y = figure->y, old_x = figure->x;
-  if (can_move(figure, game, ROTATING) || can_shift_and_rotate(figure, game)) {
-    int curr_figure = figure->figure;
-    int rotation = figure->rotation;
+void rotate(TetrisContext *ctx) {
+  Figure_position *figure = &ctx->figure;
+  if (can_move(ctx, ROTATING) || can_shift_and_rotate(ctx)) {
     figure->rotation = (figure->rotation + 1) % COUNT_OF_ROTATIONS;
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      int x = old_x + figures_mass(curr_figure, rotation, i, 0);
-      int y = old_y + figures_mass(curr_figure, rotation, i, 1);
-      game->field[x][y] = EMPTY_PLACE;
-    }
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      int new_x = figure->x + figures_mass(curr_figure, figure->rotation, i, 0);
-      int new_y = figure->y + figures_mass(curr_figure, figure->rotation, i, 1);
-      game->field[new_x][new_y] = MOVING_PLACE + curr_figure + 1;
-    }
   }
 }
 
 // сдвиг вправо/влево, учитывая возможность этого действия
-void move_figure(Figure_position *figure, GameInfo_t *game, int type_move) {
+void move_figure(TetrisContext *ctx, int type_move) {
+  Figure_position *figure = &ctx->figure;
   int change_y = 0;
   if (type_move == MOVE_RIGHT) {
     change_y = 1;
@@ -200,31 +197,21 @@ void move_figure(Figure_position *figure, GameInfo_t *game, int type_move) {
   if (type_move == MOVE_LEFT) {
     change_y = -1;
   }
-  if (can_move(figure, game, type_move)) {
-    int curr_figure = figure->figure;
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      game->field[figure->x + figures_mass(curr_figure, figure->rotation, i, 0)]
-                 [figure->y + figures_mass(curr_figure, figure->rotation, i,
-                                           1)] = EMPTY_PLACE;
-    }
+  if (can_move(ctx, type_move)) {
     figure->y += change_y;
-    for (int i = 0; i < FIGURE_PART; ++i) {
-      game->field[figure->x + figures_mass(curr_figure, figure->rotation, i, 0)]
-                 [figure->y + figures_mass(curr_figure, figure->rotation, i,
-                                           1)] = MOVING_PLACE + curr_figure + 1;
-    }
   }
 }
 
 // проверка на возможность поворота со сдвигом
-bool can_shift_and_rotate(Figure_position *figure, GameInfo_t *game) {
+bool can_shift_and_rotate(TetrisContext *ctx) {
+  Figure_position *figure = &ctx->figure;
   bool flag = false;
   figure->y += 1;
-  if (can_move(figure, game, ROTATING)) {
+  if (can_move(ctx, ROTATING)) {
     flag = true;
   } else {
     figure->y -= 2;
-    if (can_move(figure, game, ROTATING)) {
+    if (can_move(ctx, ROTATING)) {
       flag = true;
     } else {
       figure->y += 1;
@@ -232,11 +219,11 @@ bool can_shift_and_rotate(Figure_position *figure, GameInfo_t *game) {
   }
   if (figure->figure == 0 && flag == false) {
     figure->y += 2;
-    if (can_move(figure, game, ROTATING)) {
+    if (can_move(ctx, ROTATING)) {
       flag = true;
     } else {
       figure->y -= 4;
-      if (can_move(figure, game, ROTATING)) {
+      if (can_move(ctx, ROTATING)) {
         flag = true;
       } else {
         figure->y += 2;
@@ -248,36 +235,114 @@ bool can_shift_and_rotate(Figure_position *figure, GameInfo_t *game) {
 
 // извлекаем из массива со всеми фигурами рандомную
 void random_figure(int digit, GameInfo_t *game) {
+  const Shape_t *shape = shape_get(digit, 0);
   for (int i = 0; i < FIGURE_PART; ++i) {
-    game->next[i][0] = figures_mass(digit, 0, i, 0);
-    game->next[i][1] = figures_mass(digit, 0, i, 1);
+    game->next[i][0] = shape->cells[i][0];
+    game->next[i][1] = shape->cells[i][1];
   }
 }
 
-// для хранения состояния фигуры
-Figure_position *set_figure_info(void) {
-  static Figure_position figure;
-  return &figure;
+// кадр для интерфейса: клетки поля подряд, поверх них падающая фигура в
+// своем цвете (только что появившаяся фигура над полем не видна)
+void build_frame(TetrisContext *ctx) {
+  Frame_t *frame = &ctx->frame;
+  const Figure_position *figure = &ctx->figure;
+  unsigned char *cell = frame->cells;
+  for (int i = 0; i < FRAME_HEIGHT; ++i) {
+    const int *row = ctx->game.field[i];
+    for (int j = 0; j < FRAME_WIDTH; ++j) {
+      *cell++ = (unsigned char)row[j];
+    }
+  }
+  const Shape_t *shape = shape_get(figure->figure, figure->rotation);
+  if (figure->x + shape->min_row > ZERO_X) {
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      frame->cells[(figure->x + shape->cells[i][0]) * FRAME_WIDTH +
+                   figure->y + shape->cells[i][1]] =
+          (unsigned char)(figure->figure + 1);
+    }
+  }
+  int ghost[FIGURE_PART][2];
+  if (tetris_ghost(ctx, ghost)) {
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      unsigned char *place =
+          &frame->cells[ghost[i][0] * FRAME_WIDTH + ghost[i][1]];
+      if (*place == EMPTY_PLACE) {
+        *place = FRAME_GHOST;
+      }
+    }
+  }
+  frame->version = ctx->version;
 }
 
-double *delay(void) {
-  static double delay;
-  return &delay;
+// следующая фигура: равновероятно или из перемешанного набора всех фигур
+int next_piece(TetrisContext *ctx) {
+  int piece = 0;
+  if (ctx->randomizer == RANDOMIZER_BAG) {
+    piece = (int)rng_bag(&ctx->rng, ctx->bag, &ctx->bag_size,
+                         COUNT_OF_FIGURES);
+  } else {
+    piece = (int)rng_below(&ctx->rng, COUNT_OF_FIGURES);
+  }
+  return piece;
 }
 
-clock_t *last_update(void) {
-  static clock_t time_update;
-  return &time_update;
+// контекст игры по умолчанию для userInput и updateCurrentState
+TetrisContext *tetris_default(void) {
+  static TetrisContext ctx;
+  return &ctx;
 }
 
+// для хранения состояния игры
+GameInfo_t *set_game_info(void) { return &tetris_default()->game; }
+
+// для хранения состояния фигуры
+Figure_position *set_figure_info(void) { return &tetris_default()->figure; }
+
+// для хранения занятых клеток поля в виде битовых масок рядов
+Board_t *set_board_info(void) { return &tetris_default()->board; }
+
 // инициализируем структуру, в которой хранится состояние игры базовыми
 // значениями
-void init_game(GameInfo_t *game, Figure_position *figure) {
-  game->field = (int **)calloc(FIELD_HEIGHT, sizeof(int *));
+void init_game(TetrisContext *ctx) {
+  GameInfo_t *game = &ctx->game;
+  Figure_position *figure = &ctx->figure;
+  memset(ctx->cells, 0, sizeof(ctx->cells));
   for (int i = 0; i < FIELD_HEIGHT; i++) {
-    game->field[i] = (int *)calloc(FIELD_WIDTH, sizeof(int));
+    ctx->rows[i] = ctx->cells[i];
   }
+  game->field = ctx->rows;
+  board_clear(&ctx->board);
+  features_load(&ctx->features, &ctx->board);
   game->score = 0;
+  game->high_score = ctx->headless ? 0 : load_high_score();
+  ctx->pieces = 0, ctx->lines = 0, ctx->cleared = 0;
+  figure->x = 0, figure->y = 0, figure->rotation = 0;
+  if (!ctx->seeded) {
+    tetris_seed(ctx, RNG_DEFAULT_SEED);
+  }
+  ctx->bag_size = 0;
+  figure->figure = next_piece(ctx);
+  figure->next_figure = next_piece(ctx);
+  game->level = 1;
+  memset(ctx->next_cells, 0, sizeof(ctx->next_cells));
+  for (int i = 0; i < FIGURE_PART; ++i) {
+    ctx->next_rows[i] = ctx->next_cells[i];
+  }
+  game->next = ctx->next_rows;
+  random_figure(figure->next_figure, game);
+  game->next[2][2] = figure->figure + 1,
+  game->next[3][2] = figure->next_figure + 1;
+  game->pause = 0;
+  game->speed = START_SPEED / game->level;
+  game->pause = ready_to_start;
+  ctx->delay = (double)START_TIMEOUT / game->level * 0.5;
+  ctx->last_update = timer_now(&ctx->timer);
+}
+
+// чтение рекорда из файла (файл создается, если его нет)
+int load_high_score(void) {
+  int high_score = 0;
   FILE *file = fopen("high_score.txt", "r");
   if (file) {
     char score[20] = {0}, symbol;
@@ -286,37 +351,19 @@ void init_game(GameInfo_t *game, Figure_position *figure) {
       score[symbol_counter++] = symbol;
     }
     score[symbol_counter] = '\0';
-    game->high_score = atoi(score);
+    high_score = atoi(score);
     fclose(file);
   } else {
     FILE *new_file = fopen("high_score.txt", "w");
     if (new_file) {
       fclose(new_file);
     }
-    game->high_score = 0;
-  }
-  figure->x = 0, figure->y = 0, figure->rotation = 0,
-  figure->figure = rand() % COUNT_OF_FIGURES,
-  figure->next_figure = rand() % COUNT_OF_FIGURES;
-  game->level = 1;
-  game->next = (int **)calloc(FIGURE_PART, sizeof(int *));
-  for (int i = 0; i < FIGURE_PART; ++i) {
-    game->next[i] = (int *)calloc(3, sizeof(int));  // 2
   }
-  random_figure(figure->next_figure, game);
-  game->next[2][2] = figure->figure + 1,
-  game->next[3][2] = figure->next_figure + 1;
-  game->pause = 0;
-  game->speed = START_SPEED / game->level;
-  game->pause = ready_to_start;
-  double *start_delay = delay();
-  *start_delay = (double)START_TIMEOUT / game->level * 0.5;
-  clock_t *time_update = last_update();
-  *time_update = clock();
+  return high_score;
 }
 
-// очищаем игру
-void free_game(GameInfo_t *game) {
+// сохранение рекорда, если он побит в этой игре
+void save_high_score(const GameInfo_t *game) {
   if (game->score >= game->high_score) {
     FILE *file = fopen("high_score.txt", "w");
     if (file) {
@@ -324,64 +371,50 @@ void free_game(GameInfo_t *game) {
       fclose(file);
     }
   }
-  for (int i = 0; i < FIELD_HEIGHT; ++i) {
-    free(game->field[i]);
-  }
-  free(game->field);
+}
+
+// очищаем игру
+// массивы хранятся в контексте, игра только отсоединяется от них
+void free_game(GameInfo_t *game) {
   game->field = NULL;
-  for (int i = 0; i < FIGURE_PART; ++i) {
-    free(game->next[i]);
-  }
-  free(game->next);
   game->next = NULL;
 }
 
-bool time_passed(int level) {
+bool time_passed(TetrisContext *ctx) {
   bool flag = false;
-  double *time_delay = delay();
-  clock_t *time_update = last_update();
-  clock_t now = clock();  // запоминаем нынешнее время
-  double elapsed_time_ms =
-      (double)(now - *time_update) / CLOCKS_PER_SEC * START_TIMEOUT;
-  if (elapsed_time_ms >= *time_delay) {
-    *time_update = now;
+  double now = timer_now(&ctx->timer);  // запоминаем нынешнее время
+  double elapsed_time_ms = now - ctx->last_update;
+  if (elapsed_time_ms >= ctx->delay) {
+    STATS_TIME(tick_late, elapsed_time_ms - ctx->delay);
+    ctx->last_update = now;
     flag = true;
   }
-  *time_delay = (double)START_TIMEOUT / level;
+  ctx->delay = (double)START_TIMEOUT / ctx->game.level;
   return flag;
 }
 
-// для хранения состояния игры
-GameInfo_t *set_game_info(void) {
-  static GameInfo_t game;
-  return &game;
-}
-
-void game_active(GameInfo_t *game, Figure_position *figure) {
-  bool check_flag = (game->pause != pause && game->pause != ready_to_start &&
-                     game->pause != terminate && game->pause != game_over);
-  if (check_flag && time_passed(game->level)) {
-    game->pause = shift;
-  }
-  switch (game->pause) {
+// действие, соответствующее состоянию игры
+static void handle_state(TetrisContext *ctx, int state, bool check_flag) {
+  GameInfo_t *game = &ctx->game;
+  switch (state) {
     case move_left:
-      move_figure(figure, game, MOVE_LEFT);
+      move_figure(ctx, MOVE_LEFT);
       game->pause = no_signal;
       break;
     case move_right:
-      move_figure(figure, game, MOVE_RIGHT);
+      move_figure(ctx, MOVE_RIGHT);
       game->pause = no_signal;
       break;
     case fall:
-      fall_figure(figure, game);
+      fall_figure(ctx);
       game->pause = no_signal;
       break;
     case rotation:
-      rotate(figure, game);
+      rotate(ctx);
       game->pause = no_signal;
       break;
     case shift:
-      shift_figure(figure, game);  // move figure, if its possible
+      shift_figure(ctx);  // move figure, if its possible
       game->pause = no_signal;
       break;
     default:
@@ -391,3 +424,24 @@ void game_active(GameInfo_t *game, Figure_position *figure) {
       break;
   }
 }
+
+void game_active(TetrisContext *ctx) {
+  GameInfo_t *game = &ctx->game;
+  bool check_flag = (game->pause != pause && game->pause != ready_to_start &&
+                     game->pause != terminate && game->pause != game_over);
+  // действие игрока не теряется, если совпало со сдвигом по таймеру: фигура
+  // сдвигается вниз после него на том же шаге
+  bool action = game->pause == move_left || game->pause == move_right ||
+                game->pause == fall || game->pause == rotation;
+  bool due = check_flag && time_passed(ctx);
+  if (due && !action) {
+    game->pause = shift;
+  }
+  int state = game->pause;
+  STATS_BEGIN(start);
+  handle_state(ctx, state, check_flag);
+  if (due && action) {
+    shift_figure(ctx);
+  }
+  STATS_END(state_time[state], start);
+}
@@ -2,9 +2,17 @@
 #define H_FILE_BACKEND
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "./../../tetris.h"
+#include "board.h"
 #include "common.h"
+#include "feed.h"
+#include "replay.h"
+#include "rng.h"
+#include "shapes.h"
+#include "stats.h"
+#include "timer.h"
 
 /**
  * @brief Structure containing information about the position and state of the
@@ -34,6 +42,85 @@ typedef struct {
   int next_figure;
 } Figure_position;
 
+/**
+ * @brief The whole state of one game.
+ *
+ * The `TetrisContext` structure (declared as an opaque type in `common.h`)
+ * combines everything that was previously kept in static variables, so any
+ * number of games can be played in one process:
+ *   - `game`: The `GameInfo_t` view of the game for the interface.
+ *   - `figure`: The position and state of the current figure.
+ *   - `board`: The bitboard with the cells of fixed figures.
+ *   - `timer`: The source of time of the gravity timer.
+ *   - `delay`: The delay between figure shifts down by the timer (ms).
+ *   - `last_update`: The time of the last shift down by the timer (ms).
+ *   - `accumulator`: The wall time given to `tetris_advance` that has not
+ * made a whole tick yet (ms).
+ *   - `initialized`: `true` if the game was initialized by `init_game`.
+ *   - `headless`: `true` for games without a player (simulations). Such games
+ * never read or write the "high_score.txt" file.
+ *   - `pieces`: The number of figures fixed since the start of the game.
+ *   - `lines`: The number of lines removed since the start of the game.
+ *   - `version`: The number of steps that changed what the interface shows.
+ *   - `digest`: The packed visible state after the last step, used to detect
+ * changes.
+ *   - `cleared`: The set of rows (bit `i` for row `i`) removed when the last
+ * figure was fixed.
+ *   - `features`: Row fill counts, column heights and holes of the board.
+ *   - `rng`: The generator of the figures of the game.
+ *   - `seeded`: `true` if the generator was seeded; otherwise `init_game`
+ * seeds it with `RNG_DEFAULT_SEED`.
+ *   - `randomizer`: The way to choose the next figure.
+ *   - `bag`, `bag_size`: The figures left in the current set of the
+ * `RANDOMIZER_BAG` mode.
+ *   - `replay`: The replay the steps of the game are recorded to or `NULL`.
+ *   - `feed`: The feed the frames of the game are published to or `NULL`.
+ *   - `input`: The last action given to the game since the last step (`Up`
+ * if there was none).
+ *   - `frame`: The snapshot of the field for the interface, built at the end
+ * of the steps that change `version`.
+ *   - `cells`, `rows`: The storage of `game.field` and the row pointers into
+ * it.
+ *   - `next_cells`, `next_rows`: The storage of `game.next` and the row
+ * pointers into it.
+ *
+ * The context does not own any heap memory: the arrays of `GameInfo_t` point
+ * into the context itself, so starting or restarting a game does not allocate.
+ *
+ * A zero-initialized context is a valid context of a game that has not
+ * started yet.
+ */
+struct TetrisContext {
+  GameInfo_t game;
+  Figure_position figure;
+  Board_t board;
+  Timer_t timer;
+  double delay;
+  double last_update;
+  double accumulator;
+  bool initialized;
+  bool headless;
+  int pieces;
+  int lines;
+  unsigned long version;
+  unsigned long long digest;
+  uint32_t cleared;
+  Features_t features;
+  Rng_t rng;
+  bool seeded;
+  Randomizer_t randomizer;
+  unsigned char bag[COUNT_OF_FIGURES];
+  int bag_size;
+  Replay_t *replay;
+  FrameFeed_t *feed;
+  UserAction_t input;
+  Frame_t frame;
+  int cells[FIELD_HEIGHT][FIELD_WIDTH];
+  int *rows[FIELD_HEIGHT];
+  int next_cells[FIGURE_PART][3];
+  int *next_rows[FIGURE_PART];
+};
+
 /**
  * @brief Checks the game field for completed lines, removes them, shifts upper
  * lines down, and updates the score.
@@ -41,59 +128,50 @@ typedef struct {
  * The `check_field` function performs the following actions:
  *   - Sets the game state to `next_figure` to indicate that the next figure
  * needs to be generated.
- *   - Iterates through each row of the game field and checks if it is
- * completely filled.
- *   - If a row is filled, it calls the `clear_and_shift` function to remove it
- * and shift the upper rows down.
+ *   - Finds all completely filled rows of the board (`ctx->board`) at once
+ * with `board_full_rows`.
+ *   - Removes them with one call of the `clear_lines` function and remembers
+ * them in `ctx->cleared`.
  *   - Updates the player's score depending on the number of lines removed at
  * once.
  *   - Increases the game level when a certain number of points is reached.
  *   - Updates the high score if the current score exceeds it.
- *   - Checks if the figure has reached the upper boundary of the field, which
- * means the end of the game.
+ *   - Checks if the figure has reached the upper boundary of the field (the
+ * highest row mask is not empty), which means the end of the game.
  *
- * @param game  A pointer to the `GameInfo_t` structure containing game
- * information.
- *              - `game->field`: A two-dimensional array representing the game
- * field.
- *              - `game->pause`: The current game state.
- *              - `game->score`: The player's current score.
- *              - `game->level`: The current game level.
- *              - `game->high_score`: The player's high score.
- *              - `game->next`: A two-dimensional array representing the initial
- * coordinates of the next figure
- *              - `game->speed`: The current speed of falling figures
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-void check_field(GameInfo_t *game);
+void check_field(TetrisContext *ctx);
 
 /**
- * @brief Removes the specified line in the game field and shifts all upper
- * lines down.
- *
- * The `clear_and_shift` function clears the specified line (`line`) in the game
- * field, shifting all lines above it down by one position. The top line is
- * filled with `EMPTY_PLACE` values.
- *
- * @param game  A pointer to the `GameInfo_t` structure containing game
- * information.
- *              - `game->field`: A two-dimensional array representing the game
- * field.
- * @param line  The index of the line to clear and shift.
- *              Line numbering starts from 0 (the top line).
+ * @brief Removes a set of lines of the game field and shifts the upper lines
+ * down.
+ *
+ * The `clear_lines` function compacts the game field in one pass from the
+ * bottom up: every remaining line is moved down only once, by moving the
+ * pointer to the line, however many lines are removed. The freed lines are
+ * filled with `EMPTY_PLACE` values and become the top lines. The same rows are
+ * removed from the board masks (`ctx->board`), so the view and the board stay
+ * consistent.
+ *
+ * @param ctx    A pointer to the `TetrisContext` of the game.
+ * @param lines  A mask with bit `i` set for every line `i` to remove.
+ *               Line numbering starts from 0 (the top line).
  */
-void clear_and_shift(GameInfo_t *game, int line);
+void clear_lines(TetrisContext *ctx, uint32_t lines);
 
 /**
  * @brief Returns the coordinate of a specified part of a figure, given its type
  * and rotation.
  *
  * The `figures_mass` function provides access to the coordinates of individual
- * parts of various Tetris figures. The coordinates are stored in an internal
- * array called `figures`. The function takes the figure type, rotation, part
- * number, and coordinate index (x or y) as input parameters and returns the
- * corresponding coordinate value.
+ * parts of various Tetris figures. The coordinates are read from the constant
+ * shape table (`shape_get`), which is built at compile time. The function
+ * takes the figure type, rotation, part number, and coordinate index (x or y)
+ * as input parameters and returns the corresponding coordinate value. The
+ * movement functions use `shape_get` directly.
  *
- * @param type_figure  The type of figure (index in the `figures` array).
+ * @param type_figure  The type of figure (index in the shape table).
  * @param rotation     The rotation of the figure (index in the array of
  * rotations for this figure). Must be in the range of 0 to 4.
  * @param part         The number of the figure's part (index in the array of
@@ -107,67 +185,60 @@ int figures_mass(int type_figure, int rotation, int part, int coord);
  *
  * The `shift_figure` function attempts to shift the current figure (`figure`)
  * down one position in the game field (`field`). If the shift is possible
- * (there are no obstacles below), the function performs the following actions:
- *   - Clears the figure's current position on the field (fills with
- * `EMPTY_PLACE` values).
- *   - Updates the figure's `x` coordinate (shifts it down).
- *   - Displays the figure in the new position (fills with `MOVING_PLACE`
- * values).
+ * (there are no obstacles below), the function updates the figure's `x`
+ * coordinate (shifts it down). The falling figure is not written to the field:
+ * only its position changes, and `build_frame` draws it over the field.
  *
  * If the shift is not possible (the figure has reached the bottom or collided
- * with another figure), the function calls `fix_figure` to fix the figure on
- * the field and sets `flag` to `false`.
- *
- * @param figure  A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                - `figure->x`: The X coordinate of the figure.
- *                - `figure->y`: The Y coordinate of the figure.
- *                - `figure->figure`: The type of figure.
- *                - `figure->rotation`: The rotation of the figure.
- * @param game    A pointer to the `GameInfo_t` structure containing game
- * information.
- *                - `game->field`: A two-dimensional array representing the game
- * field.
+ * with another figure), the figure stays where it is and the function returns
+ * `false`; `tetris_step` then fixes it with `fix_figure`, so every figure is
+ * fixed exactly once.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ *
+ * @return `true` if the figure moved down.
  */
-bool shift_figure(Figure_position *figure, GameInfo_t *game);
+bool shift_figure(TetrisContext *ctx);
 
 /**
  * @brief Fixes the current figure on the game field.
  *
  * The `fix_figure` function sets the values of the elements in the game field
  * (`game->field`) according to the type of the current figure
- * (`figure->figure`). This means that the figure is no longer "moving" and
- * becomes part of the static landscape of the game field.
- *
- * @param figure  A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                - `figure->x`: The X coordinate of the top-left corner of the
- * figure.
- *                - `figure->y`: The Y coordinate of the top-left corner of the
- * figure.
- *                - `figure->figure`: The type of figure.
- *                - `figure->rotation`: The rotation of the figure.
- * @param game    A pointer to the `GameInfo_t` structure containing game
- * information.
- *                - `game->field`: A two-dimensional array representing the game
- * field.
+ * (`figure->figure`), updates the features of the board (`ctx->features`)
+ * and sets the corresponding bits of the board masks. This means that the
+ * figure is no longer "moving" and becomes part of the static landscape of the
+ * game field.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-void fix_figure(Figure_position *figure, GameInfo_t *game);  //
+void fix_figure(TetrisContext *ctx);
 
 /**
  * @brief Forces the current figure to fall down until it reaches the bottom.
  *
- * The `fall_figure` function repeatedly calls the `shift_figure` function to
- * move the figure down until it reaches the bottom of the game field or
- * collides with another figure. The function also contains an iteration counter
- * to limit the number of shift attempts in case of unforeseen situations.
+ * The `fall_figure` function finds the landing position with `drop_distance`
+ * and moves the figure there; `tetris_step` fixes it with `fix_figure` at the
+ * end of the same step.
  *
- * @param figure  A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- * @param game    A pointer to the `GameInfo_t` structure containing game
- * information.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ */
+void fall_figure(TetrisContext *ctx);
+
+/**
+ * @brief Returns how far the current figure can fall.
+ *
+ * For every column of the figure the nearest occupied cell below it is the top
+ * of the column (`ctx->features`), unless the figure is already below the top
+ * of the column (under an overhang); only in that case the board masks are
+ * scanned. The features must match the board.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ *
+ * @return The number of rows the figure can move down (0 if it lies on the
+ * bottom or on another figure).
  */
-void fall_figure(Figure_position *figure, GameInfo_t *game);
+int drop_distance(const TetrisContext *ctx);
 
 /**
  * @brief Checks if it is possible to move or rotate the figure in the specified
@@ -175,20 +246,12 @@ void fall_figure(Figure_position *figure, GameInfo_t *game);
  *
  * The `can_move` function determines whether the figure (`figure`) can be moved
  * or rotated in the specified direction (`type_move`) without colliding with
- * the boundaries of the game field (`game`) or other figures.
- *
- * @param figure    A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                  - `figure->x`: The X coordinate of the top-left corner of
- * the figure.
- *                  - `figure->y`: The Y coordinate of the top-left corner of
- * the figure.
- *                  - `figure->figure`: The type of figure.
- *                  - `figure->rotation`: The rotation of the figure.
- * @param game      A pointer to the `GameInfo_t` structure containing game
- * information.
- *                  - `game->field`: A two-dimensional array representing the
- * game field.
+ * the boundaries of the game field (`game`) or other figures. Fixed figures are
+ * looked up in the board masks (`ctx->board`): the field boundaries are
+ * checked against the bounding box of the figure and every row of the figure
+ * costs one AND of its precomputed mask with the board row.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  * @param type_move The type of movement:
  *                  - `MOVE_LEFT`: Check if it's possible to move left.
  *                  - `MOVE_RIGHT`: Check if it's possible to move right.
@@ -199,7 +262,7 @@ void fall_figure(Figure_position *figure, GameInfo_t *game);
  * movement or rotation is not possible due to collision with the field
  * boundaries or other figures.
  */
-bool can_move(Figure_position *figure, GameInfo_t *game, int type_move);
+bool can_move(TetrisContext *ctx, int type_move);
 
 /**
  * @brief Rotates the current figure on the game field.
@@ -208,27 +271,13 @@ bool can_move(Figure_position *figure, GameInfo_t *game, int type_move);
  * game field (`game`). The function first checks if it is possible to perform
  * the rotation without colliding with the field boundaries or other figures,
  * using the `can_move` function and, if necessary, `can_shift_and_rotate`. If
- * the rotation is possible, the function performs the following actions:
- *   - Saves the current coordinates of the figure.
- *   - Calculates the new rotation of the figure.
- *   - Clears the figure's current position on the field.
- *   - Displays the figure in the new position, taking into account the new
- * rotation.
- *
- * @param figure  A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                - `figure->x`: The X coordinate of the top-left corner of the
- * figure.
- *                - `figure->y`: The Y coordinate of the top-left corner of the
- * figure.
- *                - `figure->figure`: The type of figure.
- *                - `figure->rotation`: The rotation of the figure.
- * @param game    A pointer to the `GameInfo_t` structure containing game
- * information.
- *                - `game->field`: A two-dimensional array representing the game
- * field.
+ * the rotation is possible, the function calculates the new rotation of the
+ * figure (`can_shift_and_rotate` may also have moved it sideways). The field
+ * is not changed.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-void rotate(Figure_position *figure, GameInfo_t *game);
+void rotate(TetrisContext *ctx);
 
 /**
  * @brief Moves the current figure left or right, if possible.
@@ -236,31 +285,16 @@ void rotate(Figure_position *figure, GameInfo_t *game);
  * The `move_figure` function attempts to move the current figure (`figure`)
  * left or right in the game field (`game`) depending on the value of the
  * `type_move` parameter. If the movement is possible (there are no collisions
- * with the field boundaries or other figures), the function performs the
- * following actions:
- *   - Determines the change in the Y coordinate depending on the type of
- * movement.
- *   - Clears the figure's current position on the field.
- *   - Updates the figure's Y coordinate.
- *   - Displays the figure in the new position.
- *
- * @param figure    A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                  - `figure->x`: The X coordinate of the top-left corner of
- * the figure.
- *                  - `figure->y`: The Y coordinate of the top-left corner of
- * the figure.
- *                  - `figure->figure`: The type of figure.
- *                  - `figure->rotation`: The rotation of the figure.
- * @param game      A pointer to the `GameInfo_t` structure containing game
- * information.
- *                  - `game->field`: A two-dimensional array representing the
- * game field.
+ * with the field boundaries or other figures), the function updates the
+ * figure's Y coordinate depending on the type of movement. The field is not
+ * changed.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  * @param type_move The type of movement:
  *                  - `MOVE_LEFT`: Move left.
  *                  - `MOVE_RIGHT`: Move right.
  */
-void move_figure(Figure_position *figure, GameInfo_t *game, int type_move);
+void move_figure(TetrisContext *ctx, int type_move);
 
 /**
  * @brief Checks if it is possible to rotate the figure with a horizontal shift.
@@ -280,18 +314,12 @@ void move_figure(Figure_position *figure, GameInfo_t *game, int type_move);
  *   4. (Only for figure type 0) Shift to the left by four positions (relative
  * to the original position), then attempt rotation.
  *
- * @param figure  A pointer to the `Figure_position` structure containing
- * information about the figure's position and rotation.
- *                - `figure->y`: The Y coordinate of the top-left corner of the
- * figure.
- *                - `figure->figure`: The type of figure.
- * @param game    A pointer to the `GameInfo_t` structure containing game
- * information.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  *
  * @return `true` if rotation with a shift is possible. `false` if rotation is
  * not possible in any of the checked options.
  */
-bool can_shift_and_rotate(Figure_position *figure, GameInfo_t *game);
+bool can_shift_and_rotate(TetrisContext *ctx);
 
 /**
  * @brief Stores the coordinates of the parts of the next figure in the
@@ -312,116 +340,99 @@ bool can_shift_and_rotate(Figure_position *figure, GameInfo_t *game);
 void random_figure(int digit, GameInfo_t *game);
 
 /**
- * @brief Returns a pointer to a static variable storing information about the
- * figure.
+ * @brief Adds the current step of a recorded game to its replay.
  *
- * The `set_figure_info` function provides access to the static variable
- * `figure`, which stores information about the current figure (of type
- * `Figure_position`). Using a static variable ensures that the information
- * about the figure is preserved between function calls.
+ * Records the time of the game timer and the last action given to the game
+ * (`ctx->input`); `tetris_step` then resets the action to `Up`.
  *
- * @return A pointer to the static variable `figure` of type `Figure_position`.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ */
+void replay_record_step(TetrisContext *ctx);
+
+/**
+ * @brief Publishes the frame of the current step of a game to its feed.
+ *
+ * Called by `tetris_step` after it rebuilds the frame (see `tetris_publish`).
  *
- * The function uses a static variable, so it retains its
- * value between calls.
- * Because the function returns a pointer to a static variable,
- * changes made through this pointer will affect the information about the
- * figure globally.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-Figure_position *set_figure_info(void);
+void feed_publish_step(TetrisContext *ctx);
+
+/**
+ * @brief Chooses the type of the next figure.
+ *
+ * The figure is taken from the generator of the game (`ctx->rng`): with
+ * `RANDOMIZER_UNIFORM` every type has equal probability, with
+ * `RANDOMIZER_BAG` the types are taken from a shuffled set of all seven types,
+ * and a new set is shuffled when the previous one is empty.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ *
+ * @return The type of the figure (0 to `COUNT_OF_FIGURES - 1`).
+ */
+int next_piece(TetrisContext *ctx);
 
 /**
  * @brief Initializes the `GameInfo_t` and `Figure_position` structures to start
  * a new game.
  *
  * The `init_game` function performs the following actions:
- *   - Allocates memory for the game field (`game->field`) and initializes it
- * with default values (0).
- *   - Reads the high score from the "high_score.txt" file. If the file does not
- * exist, it creates it and sets the high score to 0.
+ *   - Points the game field (`game->field`) to the storage of the context and
+ * fills it with default values (0), clears the board masks.
+ *   - Reads the high score with `load_high_score` (headless games start with a
+ * high score of 0).
+ *   - Resets the counters of fixed figures and removed lines.
+ *   - Seeds the generator of figures if it was not seeded and starts a new set
+ * of figures for the `RANDOMIZER_BAG` mode.
  *   - Initializes the position and rotation of the first figure (`figure`).
- *   - Generates a random type for the next figure (`figure->next_figure`).
+ *   - Chooses the type of the next figure (`figure->next_figure`) with
+ * `next_piece`.
  *   - Sets the initial game level (`game->level`) to 1.
- *   - Allocates memory for the `game->next` array, which will be used to store
- * information about the next figure.
+ *   - Points the `game->next` array, which will be used to store information
+ * about the next figure, to the storage of the context.
  *   - Fills the `game->next` array with the coordinates of the parts of the
  * next figure, obtained using the `random_figure` function.
  *   - Sets the initial game speed (`game->speed`).
  *   - Sets the game state to `ready_to_start`.
- *   - Initializes the initial value for the delay (`delay`) and the last update
- * time (`last_update`).
+ *   - Initializes the initial value for the delay (`ctx->delay`) and the last
+ * update time (`ctx->last_update`).
  *
- * @param game    A pointer to the `GameInfo_t` structure to be initialized.
- *                - `game->field`: A two-dimensional array representing the game
- * field.
- *                - `game->score`: The player's current score.
- *                - `game->high_score`: The player's high score.
- *                - `game->level`: The current game level.
- *                - `game->next`: An array intended for storing the coordinates
- * of the parts of the next figure.
- *                - `game->pause`: The current game state.
- *                - `game->speed`: The current game speed.
- * @param figure  A pointer to the `Figure_position` structure to be
- * initialized.
- *                - `figure->x`: The X coordinate of the top-left corner of the
- * figure.
- *                - `figure->y`: The Y coordinate of the top-left corner of the
- * figure.
- *                - `figure->rotation`: The rotation of the figure.
- *                - `figure->figure`: The type of figure.
- *                - `figure->next_figure`: The type of the next figure.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-void init_game(GameInfo_t *game, Figure_position *figure);
+void init_game(TetrisContext *ctx);
 
 /**
- * @brief Returns a pointer to a static variable storing the delay value.
+ * @brief Reads the high score from the "high_score.txt" file.
  *
- * The `delay` function provides access to the static variable `delay`,
- * which stores the delay value (of type `double`). Using a static
- * variable ensures that the delay value is preserved between function
- * calls. Returns the delay between figure shifts down by the timer.
+ * If the file does not exist, it creates an empty one.
  *
- * @return A pointer to the static variable `delay` of type `double`.
+ * @return The stored high score or 0 if there is none.
  */
-double *delay(void);
+int load_high_score(void);
 
 /**
- * @brief Returns a pointer to a static variable storing the time of the last
- * update.
+ * @brief Saves the high score of a finished game.
  *
- * The `last_update` function provides access to the static variable
- * `time_update`, which stores the time of the last update (of type `clock_t`).
- * Using a static variable ensures that the time of the last
- * update is preserved between function calls.
+ * Checks if the current score (`game->score`) reaches the high score
+ * (`game->high_score`). If so, it writes the high score to the
+ * "high_score.txt" file. `updateCurrentState` calls it when the game is over
+ * or terminated.
  *
- * @return A pointer to the static variable `time_update` of type `clock_t`.
+ * @param game A pointer to the `GameInfo_t` view of the game.
  */
-clock_t *last_update(void);
+void save_high_score(const GameInfo_t *game);
 
 /**
- * @brief Frees the memory allocated for the game field and other game
- * resources.
- *
- * The `free_game` function performs the following actions:
- *   - Checks if the current score (`game->score`) exceeds the high score
- * (`game->high_score`). If so, it writes the current score to the
- * "high_score.txt" file.
- *   - Frees the memory allocated for each row of the game field
- * (`game->field`).
- *   - Frees the memory allocated for the game field array (`game->field`).
- *   - Assigns `NULL` to the `game->field` pointer to prevent accidental use of
- * the freed memory.
- *   - Frees the memory allocated for each row of the `game->next` array.
- *   - Frees the memory allocated for the `game->next` array.
- *   - Assigns `NULL` to the `game->next` pointer to prevent accidental use of
- * the freed memory.
- *
- * @param game  A pointer to the `GameInfo_t` structure for which memory needs
- * to be freed.
+ * @brief Releases the game field and other game resources.
+ *
+ * The storage of the arrays belongs to the `TetrisContext`, so the function
+ * only detaches them from the game: it assigns `NULL` to the `game->field`
+ * and `game->next` pointers, which marks the game as finished.
+ *
+ * @param game  A pointer to the `GameInfo_t` structure whose resources need
+ * to be released.
  *                - `game->field`: A two-dimensional array representing the game
  * field.
- *                - `game->score`: The player's current score.
- *                - `game->high_score`: The player's high score.
  *                - `game->next`: An array intended for storing the coordinates
  * of the parts of the next figure.
  */
@@ -431,18 +442,18 @@ void free_game(GameInfo_t *game);
  * @brief Checks if enough time has passed since the last update.
  *
  * The `time_passed` function determines whether the specified delay time
- * (`*time_delay`) has elapsed since the last update (`*time_update`). If the
- * time has passed, the function updates the last update time and returns
- * `true`. The function also recalculates the value of `*time_delay` based on
- * the game level `level`.
+ * (`ctx->delay`) has elapsed since the last update (`ctx->last_update`),
+ * measured by the timer of the game (`ctx->timer`). If
+ * the time has passed, the function updates the last update time and returns
+ * `true`. The function also recalculates the value of `ctx->delay` based on
+ * the game level `ctx->game.level`.
  *
- * @param level The current game level. Used to calculate the delay time.
+ * @param ctx A pointer to the `TetrisContext` of the game.
  *
  * @return `true` if the delay time has elapsed. `false` if the delay time has
- * not yet elapsed. The function modifies the values of the static variables
- * `delay` and `last_update`.
+ * not yet elapsed.
  */
-bool time_passed(int level);
+bool time_passed(TetrisContext *ctx);
 
 /**
  * @brief Performs active actions in the game based on the current game state.
@@ -455,7 +466,9 @@ bool time_passed(int level);
  *   - If the game is in an active state, it checks if enough time has passed
  * since the last update, using the `time_passed` function.
  *   - If time has passed, it sets the game state to `shift` (need to
- *     shift the figure down).
+ *     shift the figure down). If a move of the player is pending, the move is
+ *     made first and the figure is shifted down after it in the same step, so
+ *     the input is never lost.
  *   - Depending on the current game state (`game->pause`), it performs the
  *     corresponding action:
  *     - `move_left`: Moves the figure to the left.
@@ -464,19 +477,45 @@ bool time_passed(int level);
  *     - `rotation`: Rotates the figure.
  *     - `shift`: Shifts the figure down by one position.
  *   - After performing the action, it sets the game state to `no_signal`.
+ *
+ * @param ctx   A pointer to the `TetrisContext` of the game.
  */
-void game_active(GameInfo_t *game, Figure_position *figure);
+void game_active(TetrisContext *ctx);
 
 /**
- * @brief Returns a pointer to a static variable storing game information.
+ * @brief Copies the game field into the frame of the context.
  *
- * The `set_game_info` function provides access to the static variable `game`,
- * which stores game information (of type `GameInfo_t`). Using a
- * static variable ensures that the game information is preserved between
- * function calls.
+ * Only the `REAL_FIELD_WIDTH` columns of every row are read. The field holds
+ * only the fixed figures; the falling figure is drawn over it in its color
+ * once it has entered the field (the same rule as the bots use), and then the
+ * ghost is added.
  *
- * @return A pointer to the static variable `game` of type `GameInfo_t`.
+ * @param ctx   A pointer to the `TetrisContext` of the game.
+ */
+void build_frame(TetrisContext *ctx);
+
+/**
+ * @brief Returns a pointer to the game information of the default context.
+ *
+ * @return A pointer to the `GameInfo_t` view of the default context.
  */
 GameInfo_t *set_game_info(void);
 
+/**
+ * @brief Returns a pointer to the current figure of the default context.
+ *
+ * @return A pointer to the `Figure_position` of the default context.
+ */
+Figure_position *set_figure_info(void);
+
+/**
+ * @brief Returns a pointer to the board masks of the default context.
+ *
+ * The board is the source of truth for collision checks and line removal,
+ * while `GameInfo_t::field` keeps the colors of the fixed cells.
+ *
+ * @return A pointer to the `Board_t` of the default context.
+ */
+Board_t *set_board_info(void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,589 @@
+#include "batch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_HAS_AVX2 1
+#else
+#define BATCH_HAS_AVX2 0
+#endif
+
+#define BATCH_ALIGN 32
+#define BATCH_RIGHT_WALL ((uint16_t)(1u << (REAL_FIELD_WIDTH - 1)))
+
+// функции над векторами встраиваются в каждое ядро и компилируются вместе с
+// ним (в ядре AVX2 - командами AVX2), поэтому соглашение о возврате векторов
+// из функций не важно
+#define LANES_INLINE static inline __attribute__((always_inline))
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/**
+ * @brief The same 16-bit value of `BATCH_LANES` boards.
+ */
+typedef uint16_t Lanes_t
+    __attribute__((vector_size(BATCH_LANES * sizeof(uint16_t)), may_alias));
+
+/**
+ * @brief The same signed 16-bit value of `BATCH_LANES` boards.
+ */
+typedef int16_t SignedLanes_t
+    __attribute__((vector_size(BATCH_LANES * sizeof(int16_t)), may_alias));
+
+/**
+ * @brief The vector of `BATCH_LANES` values starting at an element of a
+ * board array (the first board of the vector is a multiple of
+ * `BATCH_LANES`, so the vector is aligned).
+ */
+#define LANES(values) (*(Lanes_t *)(values))
+
+/**
+ * @brief Many games stepped together.
+ *
+ * All arrays of the boards have `stride` elements; the boards after `count`
+ * only fill the last vector and never play. Row `r` of board `n` is
+ * `rows[r * stride + n]`, the same for `piece`.
+ *
+ * @var count        The number of boards.
+ * @var stride       `count` rounded up to `BATCH_LANES`.
+ * @var kernel       The implementation of `batch_step`.
+ * @var randomizer   The way the figures are chosen.
+ * @var rows         The masks of the rows of the fixed cells.
+ * @var piece        The masks of the rows of the falling figures.
+ * @var x, y         The positions of the falling figures.
+ * @var alive        0xFFFF for the boards in play, 0 after game over.
+ * @var actions      The actions of the current step.
+ * @var fixed        0xFFFF for the boards that fixed a figure at this step.
+ * @var cleared      The lines removed at this step.
+ * @var rotation     The rotations of the falling figures.
+ * @var figure       The types of the falling figures.
+ * @var next_figure  The types of the next figures.
+ * @var score        The scores.
+ * @var lines        The removed lines.
+ * @var pieces       The fixed figures.
+ * @var level        The levels.
+ * @var rng          The generators of the figures.
+ * @var bag          The sets of figures of `RANDOMIZER_BAG`, `COUNT_OF_FIGURES`
+ * per board.
+ * @var bag_size     The numbers of figures left in the sets.
+ */
+struct TetrisBatch {
+  int count;
+  int stride;
+  BatchKernel_t kernel;
+  Randomizer_t randomizer;
+  uint16_t *rows;
+  uint16_t *piece;
+  int16_t *x;
+  int16_t *y;
+  uint16_t *alive;
+  uint16_t *actions;
+  uint16_t *fixed;
+  uint16_t *cleared;
+  unsigned char *rotation;
+  unsigned char *figure;
+  unsigned char *next_figure;
+  int *score;
+  int *lines;
+  int *pieces;
+  int *level;
+  Rng_t *rng;
+  unsigned char *bag;
+  int *bag_size;
+};
+
+// обнуленный массив с выравниванием под самый длинный вектор
+static void *alloc_lanes(size_t size) {
+  size = (size + BATCH_ALIGN - 1) / BATCH_ALIGN * BATCH_ALIGN;
+  void *memory = aligned_alloc(BATCH_ALIGN, size);
+  if (memory) {
+    memset(memory, 0, size);
+  }
+  return memory;
+}
+
+static bool avx2_supported(void) {
+#if BATCH_HAS_AVX2
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+// фигура помещается на доске: те же проверки, что в can_move
+static bool lane_fits(const TetrisBatch_t *batch, int n, const Shape_t *shape,
+                      int x, int y) {
+  bool flag = x + shape->max_row < FIELD_HEIGHT - 1 &&
+              x + shape->min_row > ZERO_X &&
+              y + shape->max_col < FIELD_WIDTH - 1 &&
+              y + shape->min_col >= ZERO_Y;
+  for (int i = shape->min_row; i <= shape->max_row && flag; ++i) {
+    if (batch->rows[(x + i) * batch->stride + n] &
+        shape_row_mask(shape, i - shape->min_row, y)) {
+      flag = false;
+    }
+  }
+  return flag;
+}
+
+// маски рядов падающей фигуры доски по ее типу, повороту и положению
+static void lane_draw(TetrisBatch_t *batch, int n, bool visible) {
+  const Shape_t *shape = shape_get(batch->figure[n], batch->rotation[n]);
+  for (int i = shape->min_row; i <= shape->max_row; ++i) {
+    batch->piece[(batch->x[n] + i) * batch->stride + n] =
+        visible ? shape_row_mask(shape, i - shape->min_row, batch->y[n]) : 0;
+  }
+}
+
+// расстояние до места падения как в drop_distance: под нижней клеткой
+// каждого столбца фигуры ищется ближайшая занятая клетка, поэтому новая
+// фигура, наложившаяся на поле, падает сквозь него
+static int lane_drop_distance(const TetrisBatch_t *batch, int n,
+                              const Shape_t *shape, int x, int y) {
+  int distance = FIELD_HEIGHT;
+  for (int col = shape->min_col; col <= shape->max_col; ++col) {
+    int j = col + y, bottom = x + shape->bottom[col - shape->min_col];
+    int below = bottom + 1;
+    while (below < BOARD_FLOOR &&
+           !(batch->rows[below * batch->stride + n] >> j & 1u)) {
+      below++;
+    }
+    if (below - bottom - 1 < distance) {
+      distance = below - bottom - 1;
+    }
+  }
+  return distance;
+}
+
+static void lane_drop(TetrisBatch_t *batch, int n) {
+  const Shape_t *shape = shape_get(batch->figure[n], batch->rotation[n]);
+  int distance = lane_drop_distance(batch, n, shape, batch->x[n], batch->y[n]);
+  lane_draw(batch, n, false);
+  batch->x[n] = (int16_t)(batch->x[n] + distance);
+  lane_draw(batch, n, true);
+}
+
+static int lane_next_piece(TetrisBatch_t *batch, int n) {
+  int piece = 0;
+  if (batch->randomizer == RANDOMIZER_BAG) {
+    piece = (int)rng_bag(&batch->rng[n], &batch->bag[n * COUNT_OF_FIGURES],
+                         &batch->bag_size[n], COUNT_OF_FIGURES);
+  } else {
+    piece = (int)rng_below(&batch->rng[n], COUNT_OF_FIGURES);
+  }
+  return piece;
+}
+
+// поворот как в rotate: на месте, затем со сдвигом на 1 и для палки на 2
+static void lane_rotate(TetrisBatch_t *batch, int n) {
+  static const int kicks[] = {0, 1, -1, 2, -2};
+  int rotation = (batch->rotation[n] + 1) % COUNT_OF_ROTATIONS;
+  int tries = batch->figure[n] == 0 ? 5 : 3;
+  const Shape_t *shape = shape_get(batch->figure[n], rotation);
+  for (int k = 0; k < tries; ++k) {
+    if (lane_fits(batch, n, shape, batch->x[n], batch->y[n] + kicks[k])) {
+      lane_draw(batch, n, false);
+      batch->rotation[n] = (unsigned char)rotation;
+      batch->y[n] = (int16_t)(batch->y[n] + kicks[k]);
+      lane_draw(batch, n, true);
+      k = tries;
+    }
+  }
+}
+
+// после фиксации фигуры: счет и уровень как в check_field, затем конец игры
+// или новая фигура, как в tetris_step
+static void lane_finish(TetrisBatch_t *batch, int n, int lines) {
+  static const int points[] = {0, ONE_LINE, TWO_LINES, THREE_LINES,
+                               FOUR_LINES};
+  batch->pieces[n]++;
+  batch->lines[n] += lines;
+  batch->score[n] += points[lines];
+  if (batch->score[n] / SPEED_UP <= MAX_SPEED) {
+    batch->level[n] = batch->score[n] / SPEED_UP + 1;
+  }
+  if (batch->rows[HIGHEST_LINE * batch->stride + n]) {
+    batch->alive[n] = 0;
+  } else {
+    batch->figure[n] = batch->next_figure[n];
+    batch->next_figure[n] = (unsigned char)lane_next_piece(batch, n);
+    batch->x[n] = 0, batch->y[n] = 0, batch->rotation[n] = 0;
+    lane_draw(batch, n, true);
+  }
+}
+
+// одна доска за раз, по фигуре и ее положению
+static void step_board(TetrisBatch_t *batch, int n) {
+  UserAction_t action = (UserAction_t)batch->actions[n];
+  const Shape_t *shape = shape_get(batch->figure[n], batch->rotation[n]);
+  int x = batch->x[n], y = batch->y[n];
+  if (action == Action) {
+    lane_rotate(batch, n);
+    shape = shape_get(batch->figure[n], batch->rotation[n]);
+    y = batch->y[n];
+  } else if (action == Left || action == Right) {
+    int change = action == Left ? -1 : 1;
+    y += lane_fits(batch, n, shape, x, y + change) ? change : 0;
+  } else if (action == Up) {
+    x += lane_fits(batch, n, shape, x + 1, y);
+  } else if (action == Down) {
+    x += lane_drop_distance(batch, n, shape, x, y);
+  }
+  lane_draw(batch, n, false);
+  batch->x[n] = (int16_t)x, batch->y[n] = (int16_t)y;
+  if (lane_fits(batch, n, shape, x + 1, y)) {
+    lane_draw(batch, n, true);
+  } else {
+    Board_t board;
+    for (int r = 0; r < FIELD_HEIGHT; ++r) {
+      board.rows[r] = batch->rows[r * batch->stride + n];
+    }
+    for (int i = shape->min_row; i <= shape->max_row; ++i) {
+      board.rows[x + i] |= shape_row_mask(shape, i - shape->min_row, y);
+    }
+    uint32_t full = board_full_rows(&board);
+    board_remove_rows(&board, full);
+    for (int r = 0; r < FIELD_HEIGHT; ++r) {
+      batch->rows[r * batch->stride + n] = board.rows[r];
+    }
+    int lines = 0;
+    for (; full; full &= full - 1) {
+      lines++;
+    }
+    lane_finish(batch, n, lines);
+  }
+}
+
+static void step_scalar(TetrisBatch_t *batch) {
+  for (int n = 0; n < batch->count; ++n) {
+    if (batch->alive[n]) {
+      step_board(batch, n);
+    }
+  }
+}
+
+// векторы передаются в функции по указателю: так они не зависят от того,
+// есть ли у процессора регистры нужной длины
+LANES_INLINE bool any(const Lanes_t *lanes) {
+  uint64_t words[sizeof(Lanes_t) / sizeof(uint64_t)], result = 0;
+  memcpy(words, lanes, sizeof(words));
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+    result |= words[i];
+  }
+  return result != 0;
+}
+
+/**
+ * @brief The rows that hold the falling figures of a group of boards.
+ *
+ * @var top     The first row.
+ * @var bottom  The last row.
+ */
+typedef struct {
+  int top;
+  int bottom;
+} Window_t;
+
+// ряды от верхней фигуры группы до низа самой нижней: все циклы по рядам
+// векторного ядра проходят только их
+static Window_t lanes_window(const TetrisBatch_t *batch, int c) {
+  Window_t window = {FIELD_HEIGHT, 0};
+  for (int n = c; n < c + BATCH_LANES; ++n) {
+    if (batch->alive[n] && batch->x[n] < window.top) {
+      window.top = batch->x[n];
+    }
+    if (batch->alive[n] && batch->x[n] > window.bottom) {
+      window.bottom = batch->x[n];
+    }
+  }
+  window.bottom += SHAPE_SIZE - 1;
+  if (window.bottom > BOARD_FLOOR - 1) {
+    window.bottom = BOARD_FLOOR - 1;
+  }
+  return window;
+}
+
+// доски, где фигура может сдвинуться вниз: она не на последнем ряду и
+// каждый ее ряд не пересекается со следующим рядом поля
+LANES_INLINE Lanes_t lanes_can_fall(const TetrisBatch_t *batch, int c,
+                                    const Window_t *window) {
+  const uint16_t *rows = batch->rows + c, *piece = batch->piece + c;
+  size_t stride = batch->stride;
+  Lanes_t bad = LANES(piece + (BOARD_FLOOR - 1) * stride);
+  int last = window->bottom < BOARD_FLOOR - 1 ? window->bottom + 1
+                                              : BOARD_FLOOR - 1;
+  for (int r = window->top + 1; r <= last; ++r) {
+    bad |= LANES(piece + (r - 1) * stride) & LANES(rows + r * stride);
+  }
+  return (Lanes_t)(bad == 0);
+}
+
+// сдвиг фигур вниз; окно растет на ряд, если хоть одна фигура сдвинулась
+LANES_INLINE void lanes_fall(TetrisBatch_t *batch, int c, Window_t *window,
+                             const Lanes_t *fall) {
+  Lanes_t ok = *fall;
+  uint16_t *piece = batch->piece + c;
+  size_t stride = batch->stride;
+  if (any(&ok)) {
+    if (window->bottom < BOARD_FLOOR - 1) {
+      window->bottom++;
+    }
+    for (int r = window->bottom; r > window->top; --r) {
+      Lanes_t cells = LANES(piece + r * stride);
+      Lanes_t above = LANES(piece + (r - 1) * stride);
+      LANES(piece + r * stride) = (cells & ~ok) | (above & ok);
+    }
+    LANES(piece + window->top * stride) &= ~ok;
+    *(SignedLanes_t *)(batch->x + c) -= (SignedLanes_t)ok;
+  }
+}
+
+// сдвиг влево и вправо: фигура не касается стены со стороны сдвига, не
+// пересекается с полем после сдвига и не находится в нулевом ряду
+LANES_INLINE void lanes_move(TetrisBatch_t *batch, int c,
+                             const Window_t *window) {
+  Lanes_t alive = LANES(batch->alive + c), action = LANES(batch->actions + c);
+  Lanes_t left = alive & (Lanes_t)(action == Left);
+  Lanes_t right = alive & (Lanes_t)(action == Right);
+  const uint16_t *rows = batch->rows + c;
+  uint16_t *piece = batch->piece + c;
+  size_t stride = batch->stride;
+  Lanes_t bad = LANES(piece);
+  int top = window->top > 1 ? window->top : 1;
+  for (int r = top; r <= window->bottom; ++r) {
+    Lanes_t cells = LANES(piece + r * stride), row = LANES(rows + r * stride);
+    bad |= left & ((cells & 1) | ((cells >> 1) & row));
+    bad |= right & ((cells & BATCH_RIGHT_WALL) | ((cells << 1) & row));
+  }
+  Lanes_t ok = (Lanes_t)(bad == 0), to_left = left & ok, to_right = right & ok;
+  Lanes_t moved = to_left | to_right;
+  if (any(&moved)) {
+    for (int r = top; r <= window->bottom; ++r) {
+      Lanes_t cells = LANES(piece + r * stride);
+      LANES(piece + r * stride) = (cells & ~moved) |
+                                    ((cells >> 1) & to_left) |
+                                    ((cells << 1) & to_right);
+    }
+    *(SignedLanes_t *)(batch->y + c) +=
+        (SignedLanes_t)to_left - (SignedLanes_t)to_right;
+  }
+}
+
+// фиксация фигур и удаление полных рядов снизу вверх: на каждой доске с
+// полным рядом верхние ряды сдвигаются вниз на один, и ряд проверяется снова;
+// полными могут стать только ряды окна, остальные ряды поля не меняются
+LANES_INLINE void lanes_fix(TetrisBatch_t *batch, int c,
+                            const Window_t *window, const Lanes_t *fix) {
+  Lanes_t fixed = *fix;
+  uint16_t *rows = batch->rows + c, *piece = batch->piece + c;
+  size_t stride = batch->stride;
+  for (int r = window->top; r <= window->bottom; ++r) {
+    Lanes_t cells = LANES(piece + r * stride);
+    LANES(rows + r * stride) |= cells & fixed;
+    LANES(piece + r * stride) = cells & ~fixed;
+  }
+  Lanes_t cleared = {0};
+  for (int r = window->bottom; r >= window->top;) {
+    Lanes_t row = LANES(rows + r * stride);
+    Lanes_t full = fixed & (Lanes_t)(row == BOARD_FULL_ROW);
+    if (any(&full)) {
+      for (int i = r; i > 0; --i) {
+        LANES(rows + i * stride) = (LANES(rows + i * stride) & ~full) |
+                                     (LANES(rows + (i - 1) * stride) & full);
+      }
+      LANES(rows) &= ~full;
+      cleared -= (Lanes_t)full;
+    } else {
+      --r;
+    }
+  }
+  LANES(batch->cleared + c) = cleared;
+}
+
+// одна группа досок: сдвиги, падение, фиксация и удаление рядов векторами;
+// повороты, сброс и новые фигуры обрабатываются по одной доске
+LANES_INLINE void step_lanes(TetrisBatch_t *batch, int c) {
+  Lanes_t alive = LANES(batch->alive + c), action = LANES(batch->actions + c);
+  if (any(&alive)) {
+    Window_t window = lanes_window(batch, c);
+    lanes_move(batch, c, &window);
+    Lanes_t turn = alive & (Lanes_t)(action == Action);
+    for (int n = c; any(&turn) && n < c + BATCH_LANES; ++n) {
+      if (batch->actions[n] == Action && batch->alive[n]) {
+        lane_rotate(batch, n);
+      }
+    }
+    Lanes_t gravity = alive & (Lanes_t)(action == Up);
+    if (any(&gravity)) {
+      gravity &= lanes_can_fall(batch, c, &window);
+      lanes_fall(batch, c, &window, &gravity);
+    }
+    // сброс по одной доске: расстояния до места падения у досок разные, и
+    // сдвиг векторов по ряду за раз длился бы столько шагов, сколько падает
+    // самая высокая фигура группы
+    Lanes_t drop = alive & (Lanes_t)(action == Down);
+    if (any(&drop)) {
+      for (int n = c; n < c + BATCH_LANES; ++n) {
+        if (batch->actions[n] == Down && batch->alive[n]) {
+          lane_drop(batch, n);
+        }
+      }
+      window = lanes_window(batch, c);
+    }
+    Lanes_t fixed = alive & ~lanes_can_fall(batch, c, &window);
+    LANES(batch->fixed + c) = fixed;
+    if (any(&fixed)) {
+      lanes_fix(batch, c, &window, &fixed);
+      for (int n = c; n < c + BATCH_LANES; ++n) {
+        if (batch->fixed[n]) {
+          lane_finish(batch, n, batch->cleared[n]);
+        }
+      }
+    }
+  }
+}
+
+static void step_vector(TetrisBatch_t *batch) {
+  for (int c = 0; c < batch->stride; c += BATCH_LANES) {
+    step_lanes(batch, c);
+  }
+}
+
+#if BATCH_HAS_AVX2
+__attribute__((target("avx2"))) static void step_avx2(TetrisBatch_t *batch) {
+  for (int c = 0; c < batch->stride; c += BATCH_LANES) {
+    step_lanes(batch, c);
+  }
+}
+#endif
+
+TetrisBatch_t *batch_create(int count, Randomizer_t randomizer) {
+  TetrisBatch_t *batch = NULL;
+  if (count > 0) {
+    batch = (TetrisBatch_t *)calloc(1, sizeof(TetrisBatch_t));
+  }
+  if (batch) {
+    int stride = (count + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES;
+    size_t lanes = (size_t)stride;
+    batch->count = count, batch->stride = stride;
+    batch->randomizer = randomizer;
+    batch->rows = alloc_lanes(FIELD_HEIGHT * lanes * sizeof(uint16_t));
+    batch->piece = alloc_lanes(FIELD_HEIGHT * lanes * sizeof(uint16_t));
+    batch->x = alloc_lanes(lanes * sizeof(int16_t));
+    batch->y = alloc_lanes(lanes * sizeof(int16_t));
+    batch->alive = alloc_lanes(lanes * sizeof(uint16_t));
+    batch->actions = alloc_lanes(lanes * sizeof(uint16_t));
+    batch->fixed = alloc_lanes(lanes * sizeof(uint16_t));
+    batch->cleared = alloc_lanes(lanes * sizeof(uint16_t));
+    batch->rotation = calloc(lanes, 1);
+    batch->figure = calloc(lanes, 1);
+    batch->next_figure = calloc(lanes, 1);
+    batch->score = calloc(lanes, sizeof(int));
+    batch->lines = calloc(lanes, sizeof(int));
+    batch->pieces = calloc(lanes, sizeof(int));
+    batch->level = calloc(lanes, sizeof(int));
+    batch->rng = calloc(lanes, sizeof(Rng_t));
+    batch->bag = calloc(lanes, COUNT_OF_FIGURES);
+    batch->bag_size = calloc(lanes, sizeof(int));
+    if (!batch->rows || !batch->piece || !batch->x || !batch->y ||
+        !batch->alive || !batch->actions || !batch->fixed ||
+        !batch->cleared || !batch->rotation || !batch->figure ||
+        !batch->next_figure || !batch->score || !batch->lines ||
+        !batch->pieces || !batch->level || !batch->rng || !batch->bag ||
+        !batch->bag_size) {
+      batch_destroy(batch);
+      batch = NULL;
+    }
+  }
+  if (batch) {
+    batch->kernel = avx2_supported() ? BATCH_AVX2 : BATCH_VECTOR;
+    for (int n = 0; n < count; ++n) {
+      batch_reset(batch, n, (unsigned long long)n);
+    }
+  }
+  return batch;
+}
+
+void batch_destroy(TetrisBatch_t *batch) {
+  if (batch) {
+    free(batch->rows), free(batch->piece);
+    free(batch->x), free(batch->y);
+    free(batch->alive), free(batch->actions);
+    free(batch->fixed), free(batch->cleared);
+    free(batch->rotation), free(batch->figure), free(batch->next_figure);
+    free(batch->score), free(batch->lines);
+    free(batch->pieces), free(batch->level);
+    free(batch->rng), free(batch->bag), free(batch->bag_size);
+    free(batch);
+  }
+}
+
+int batch_count(const TetrisBatch_t *batch) { return batch->count; }
+
+bool batch_set_kernel(TetrisBatch_t *batch, BatchKernel_t kernel) {
+  bool flag = kernel == BATCH_SCALAR || kernel == BATCH_VECTOR ||
+              (kernel == BATCH_AVX2 && avx2_supported());
+  if (flag) {
+    batch->kernel = kernel;
+  }
+  return flag;
+}
+
+BatchKernel_t batch_kernel(const TetrisBatch_t *batch) {
+  return batch->kernel;
+}
+
+// как init_game и шаг Start: первая фигура на пустом поле сразу сдвигается
+// вниз на один ряд
+void batch_reset(TetrisBatch_t *batch, int index, unsigned long long seed) {
+  for (int r = 0; r < FIELD_HEIGHT; ++r) {
+    batch->rows[r * batch->stride + index] = 0;
+    batch->piece[r * batch->stride + index] = 0;
+  }
+  rng_seed(&batch->rng[index], seed, 0);
+  batch->bag_size[index] = 0;
+  batch->figure[index] = (unsigned char)lane_next_piece(batch, index);
+  batch->next_figure[index] = (unsigned char)lane_next_piece(batch, index);
+  batch->x[index] = 1, batch->y[index] = 0, batch->rotation[index] = 0;
+  batch->score[index] = 0, batch->lines[index] = 0;
+  batch->pieces[index] = 0, batch->level[index] = 1;
+  batch->alive[index] = 0xFFFF;
+  lane_draw(batch, index, true);
+}
+
+void batch_step(TetrisBatch_t *batch, const UserAction_t *actions) {
+  for (int n = 0; n < batch->count; ++n) {
+    batch->actions[n] = (uint16_t)actions[n];
+  }
+  switch (batch->kernel) {
+    case BATCH_SCALAR:
+      step_scalar(batch);
+      break;
+#if BATCH_HAS_AVX2
+    case BATCH_AVX2:
+      step_avx2(batch);
+      break;
+#endif
+    default:
+      step_vector(batch);
+      break;
+  }
+}
+
+void batch_board(const TetrisBatch_t *batch, int index, BatchBoard_t *board) {
+  memset(board, 0, sizeof(BatchBoard_t));
+  for (int r = 0; r < FIELD_HEIGHT; ++r) {
+    board->board.rows[r] = batch->rows[r * batch->stride + index];
+  }
+  board->figure.x = batch->x[index], board->figure.y = batch->y[index];
+  board->figure.rotation = batch->rotation[index];
+  board->figure.figure = batch->figure[index];
+  board->figure.next_figure = batch->next_figure[index];
+  board->score = batch->score[index], board->lines = batch->lines[index];
+  board->pieces = batch->pieces[index], board->level = batch->level[index];
+  board->alive = batch->alive[index] != 0;
+}
+
+bool batch_alive(const TetrisBatch_t *batch, int index) {
+  return batch->alive[index] != 0;
+}
@@ -0,0 +1,156 @@
+#ifndef H_FILE_BATCH
+#define H_FILE_BATCH
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "backend.h"
+
+/**
+ * @brief The number of boards processed together by the vector kernels.
+ */
+#define BATCH_LANES 16
+
+/**
+ * @brief The implementation of `batch_step`.
+ *
+ * All kernels give exactly the same boards. `BATCH_SCALAR` steps one board at
+ * a time; `BATCH_VECTOR` steps `BATCH_LANES` boards at once with the vectors
+ * of the compiler (SSE2 on x86-64, plain loops where the processor has no
+ * vectors); `BATCH_AVX2` is the same code compiled for AVX2 and exists only
+ * on x86 processors that support it.
+ */
+typedef enum { BATCH_SCALAR, BATCH_VECTOR, BATCH_AVX2 } BatchKernel_t;
+
+/**
+ * @brief Many games stepped together.
+ *
+ * The boards are stored as a structure of arrays: row `r` of all boards lies
+ * in one array, so one vector holds the same row of `BATCH_LANES` boards.
+ * The falling figure of every board is kept the same way, as the masks of
+ * the rows it covers, and moving figures aside and down, fixing them and
+ * removing lines are bit operations on whole rows of all boards at once.
+ * Rotations, drops and new figures are handled board by board.
+ *
+ * Every board follows the rules of the engine: a step of a board gives the
+ * same board as `tetris_step` after the same action (see `batch_step`).
+ */
+typedef struct TetrisBatch TetrisBatch_t;
+
+/**
+ * @brief The state of one board of a batch.
+ *
+ * @var board     The fixed cells.
+ * @var figure    The falling figure and the next figure.
+ * @var score     The score.
+ * @var lines     The removed lines.
+ * @var pieces    The fixed figures.
+ * @var level     The level.
+ * @var alive     `false` after the game of the board is over.
+ */
+typedef struct {
+  Board_t board;
+  Figure_position figure;
+  int score;
+  int lines;
+  int pieces;
+  int level;
+  bool alive;
+} BatchBoard_t;
+
+/**
+ * @brief Creates a batch of games.
+ *
+ * Every board is started with `batch_reset` and the seed equal to its index.
+ * The fastest kernel supported by the processor is chosen.
+ *
+ * @param count       The number of boards (positive).
+ * @param randomizer  The way the figures of all boards are chosen.
+ *
+ * @return A pointer to the batch or `NULL` if `count` is not positive or
+ * there is not enough memory. The batch must be released with
+ * `batch_destroy`.
+ */
+TetrisBatch_t *batch_create(int count, Randomizer_t randomizer);
+
+/**
+ * @brief Releases a batch.
+ *
+ * @param batch  The batch; `NULL` does nothing.
+ */
+void batch_destroy(TetrisBatch_t *batch);
+
+/**
+ * @brief Returns the number of boards of a batch.
+ */
+int batch_count(const TetrisBatch_t *batch);
+
+/**
+ * @brief Chooses the implementation of `batch_step`.
+ *
+ * @param batch   The batch.
+ * @param kernel  The kernel.
+ *
+ * @return `false` if the processor does not support the kernel (the kernel
+ * is not changed).
+ */
+bool batch_set_kernel(TetrisBatch_t *batch, BatchKernel_t kernel);
+
+/**
+ * @brief Returns the kernel used by a batch.
+ */
+BatchKernel_t batch_kernel(const TetrisBatch_t *batch);
+
+/**
+ * @brief Starts a new game on one board.
+ *
+ * The board gets the state of a headless game seeded with `seed` after the
+ * `Start` step: an empty field, the first figure shifted into the field and
+ * the next figure chosen.
+ *
+ * @param batch  The batch.
+ * @param index  The number of the board.
+ * @param seed   The seed of the figures (as `tetris_seed`).
+ */
+void batch_reset(TetrisBatch_t *batch, int index, unsigned long long seed);
+
+/**
+ * @brief Makes one step of every board.
+ *
+ * A board takes one action per step, exactly as a game that gets the action
+ * with `tetris_input` before `tetris_step`:
+ *   - `Left`, `Right`: the figure is moved if possible.
+ *   - `Action`: the figure is rotated, shifted aside if needed.
+ *   - `Down`: the figure is dropped.
+ *   - `Up`: the figure is shifted down by gravity (the step of a game whose
+ * gravity timer has expired).
+ *   - Any other action does nothing.
+ *
+ * Then a figure that cannot move down is fixed, the full lines are removed,
+ * the score and the level are updated and the next figure appears, or the
+ * game of the board is over. Boards whose game is over do not change.
+ *
+ * @param batch    The batch.
+ * @param actions  The actions of all boards (`batch_count` elements).
+ */
+void batch_step(TetrisBatch_t *batch, const UserAction_t *actions);
+
+/**
+ * @brief Reads the state of one board.
+ *
+ * @param batch  The batch.
+ * @param index  The number of the board.
+ * @param board  The state to fill.
+ */
+void batch_board(const TetrisBatch_t *batch, int index, BatchBoard_t *board);
+
+/**
+ * @brief Checks whether the game of one board goes on.
+ *
+ * @param batch  The batch.
+ * @param index  The number of the board.
+ *
+ * @return `false` after the game of the board is over.
+ */
+bool batch_alive(const TetrisBatch_t *batch, int index);
+
+#endif
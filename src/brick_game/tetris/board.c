@@ -0,0 +1,125 @@
+#include "board.h"
+
+// очистка всех рядов поля
+void board_clear(Board_t *board) {
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    board->rows[i] = 0;
+  }
+}
+
+// построение битовых масок рядов по двумерному полю
+void board_load(Board_t *board, int **field) {
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    uint16_t row = 0;
+    for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+      if (field[i][j] != EMPTY_PLACE) {
+        row |= (uint16_t)(1u << j);
+      }
+    }
+    board->rows[i] = row;
+  }
+}
+
+// удаление ряда со сдвигом всех верхних рядов вниз
+void board_remove_row(Board_t *board, int line) {
+  board_remove_rows(board, 1u << line);
+}
+
+uint32_t board_full_rows(const Board_t *board) {
+  uint32_t lines = 0;
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    lines |= (uint32_t)(board->rows[i] == BOARD_FULL_ROW) << i;
+  }
+  return lines;
+}
+
+// число установленных битов маски ряда
+static int row_count(uint16_t row) {
+  int count = 0;
+  for (; row; row &= (uint16_t)(row - 1)) {
+    count++;
+  }
+  return count;
+}
+
+// высоты столбцов и дыры по маскам рядов: все столбцы обрабатываются сразу,
+// проход идет сверху вниз с маской уже встреченных столбцов
+static void features_columns(Features_t *features, const Board_t *board) {
+  uint16_t seen = 0;
+  features->holes = 0;
+  for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+    features->height[j] = 0;
+  }
+  for (int i = 0; i < BOARD_FLOOR; ++i) {
+    uint16_t first = board->rows[i] & (uint16_t)~seen & BOARD_FULL_ROW;
+    for (int j = 0; first; ++j, first >>= 1) {
+      if (first & 1u) {
+        features->height[j] = (unsigned char)(BOARD_FLOOR - i);
+      }
+    }
+    features->holes += row_count(seen & (uint16_t)~board->rows[i]);
+    seen |= board->rows[i] & BOARD_FULL_ROW;
+  }
+}
+
+void features_load(Features_t *features, const Board_t *board) {
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    features->fill[i] =
+        (unsigned char)row_count(board->rows[i] & BOARD_FULL_ROW);
+  }
+  features_columns(features, board);
+}
+
+// в каждом столбце фигура может закрыть дыры под верхней клеткой или поднять
+// столбец, оставив под собой новые дыры
+void features_place(Features_t *features, const Shape_t *shape, int x, int y) {
+  for (int i = 0; i < FIGURE_PART; ++i) {
+    features->fill[x + shape->cells[i][0]]++;
+  }
+  for (int col = shape->min_col; col <= shape->max_col; ++col) {
+    int j = col + y, top = BOARD_FLOOR - features->height[j];
+    int figure_top = x + shape->top[col - shape->min_col];
+    int above = 0;
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      int row = x + shape->cells[i][0];
+      if (shape->cells[i][1] == col) {
+        if (row > top) {
+          features->holes--;
+        } else if (row > figure_top) {
+          above++;
+        }
+      }
+    }
+    if (figure_top < top) {
+      features->holes += top - figure_top - 1 - above;
+      features->height[j] = (unsigned char)(BOARD_FLOOR - figure_top);
+    }
+  }
+}
+
+void features_remove_rows(Features_t *features, const Board_t *board,
+                          uint32_t lines) {
+  int dst = FIELD_HEIGHT - 1;
+  for (int src = FIELD_HEIGHT - 1; src >= 0; --src) {
+    if (!(lines >> src & 1u)) {
+      features->fill[dst--] = features->fill[src];
+    }
+  }
+  for (; dst >= 0; --dst) {
+    features->fill[dst] = 0;
+  }
+  features_columns(features, board);
+}
+
+// уплотнение снизу вверх: оставшиеся ряды переносятся сразу на свое место
+void board_remove_rows(Board_t *board, uint32_t lines) {
+  int dst = FIELD_HEIGHT - 1;
+  for (int src = FIELD_HEIGHT - 1; src >= 0; --src) {
+    if (!(lines >> src & 1u)) {
+      board->rows[dst--] = board->rows[src];
+    }
+  }
+  for (; dst >= 0; --dst) {
+    board->rows[dst] = 0;
+  }
+}
@@ -0,0 +1,150 @@
+#ifndef H_FILE_BOARD
+#define H_FILE_BOARD
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "./../../tetris.h"
+#include "shapes.h"
+
+/**
+ * @brief Mask of a completely filled row of the playfield.
+ *
+ * Every bit from 0 to `REAL_FIELD_WIDTH - 1` is set, one bit per column.
+ */
+#define BOARD_FULL_ROW ((uint16_t)((1u << REAL_FIELD_WIDTH) - 1u))
+
+/**
+ * @brief Bitboard representation of the locked cells of the game field.
+ *
+ * The `Board_t` structure stores the playfield as one 16-bit mask per row:
+ * bit `j` of `rows[i]` is set if the cell in row `i` and column `j` is
+ * occupied by a fixed figure. The falling figure is never stored in the
+ * board, so collision checks reduce to AND operations and a full line is a
+ * single comparison with `BOARD_FULL_ROW`.
+ *
+ * The whole board takes `FIELD_HEIGHT * 2` bytes. Colors of the cells are not
+ * stored here: they live in the `GameInfo_t::field` view, which is only
+ * updated when a figure is fixed or a line is removed.
+ *
+ * @var rows  Occupancy masks of the rows, row 0 is the top line.
+ */
+typedef struct {
+  uint16_t rows[FIELD_HEIGHT];
+} Board_t;
+
+_Static_assert(FIELD_HEIGHT <= 32, "a set of rows must fit in uint32_t");
+
+/**
+ * @brief The first row below the playfield.
+ *
+ * Figures never go below row `BOARD_FLOOR - 1`, so column heights are counted
+ * from this row.
+ */
+#define BOARD_FLOOR (FIELD_HEIGHT - 1)
+
+/**
+ * @brief Features of the fixed cells of the board.
+ *
+ * The game keeps the `Features_t` structure up to date when a figure is fixed
+ * and when lines are removed, so bots and analytics can read it after every
+ * figure instead of scanning the field.
+ *
+ * @var fill    The number of occupied cells of every row.
+ * @var height  The height of every column: `BOARD_FLOOR` minus the row of the
+ * highest occupied cell, 0 for an empty column.
+ * @var holes   The number of empty cells that have an occupied cell above them
+ * in the same column.
+ */
+typedef struct {
+  unsigned char fill[FIELD_HEIGHT];
+  unsigned char height[REAL_FIELD_WIDTH];
+  int holes;
+} Features_t;
+
+/**
+ * @brief Makes all the cells of the board empty.
+ *
+ * @param board A pointer to the board to clear.
+ */
+void board_clear(Board_t *board);
+
+/**
+ * @brief Builds the board from a two-dimensional game field.
+ *
+ * The `board_load` function rebuilds the occupancy masks from a field in the
+ * `GameInfo_t::field` format: every cell that is not `EMPTY_PLACE` is treated
+ * as occupied. It is meant for setting up positions prepared outside of the
+ * engine (tests, analysis tools), so the field must not contain the falling
+ * figure unless it should be treated as a fixed one.
+ *
+ * @param board A pointer to the board to fill.
+ * @param field A field of `FIELD_HEIGHT` rows with at least
+ * `REAL_FIELD_WIDTH` columns each.
+ */
+void board_load(Board_t *board, int **field);
+
+/**
+ * @brief Removes a row of the board and shifts all upper rows down.
+ *
+ * The top row of the board becomes empty.
+ *
+ * @param board A pointer to the board.
+ * @param line  The index of the row to remove (0 is the top line).
+ */
+void board_remove_row(Board_t *board, int line);
+
+/**
+ * @brief Returns the set of completely filled rows of the board.
+ *
+ * @param board A pointer to the board.
+ *
+ * @return A mask with bit `i` set if row `i` equals `BOARD_FULL_ROW`.
+ */
+uint32_t board_full_rows(const Board_t *board);
+
+/**
+ * @brief Removes a set of rows of the board in one pass.
+ *
+ * The remaining rows keep their order and are moved down, each of them only
+ * once; the freed rows at the top of the board become empty.
+ *
+ * @param board A pointer to the board.
+ * @param lines A mask with bit `i` set for every row `i` to remove.
+ */
+void board_remove_rows(Board_t *board, uint32_t lines);
+
+/**
+ * @brief Computes the features of a board from scratch.
+ *
+ * @param features  A pointer to the features to fill.
+ * @param board     A pointer to the board.
+ */
+void features_load(Features_t *features, const Board_t *board);
+
+/**
+ * @brief Updates the features for a figure that is being fixed.
+ *
+ * Only the rows and columns covered by the figure are changed. The function
+ * must be called with the features of the board without the figure.
+ *
+ * @param features  A pointer to the features to update.
+ * @param shape     The description of the figure.
+ * @param x         The vertical displacement of the figure.
+ * @param y         The horizontal displacement of the figure.
+ */
+void features_place(Features_t *features, const Shape_t *shape, int x, int y);
+
+/**
+ * @brief Updates the features after `board_remove_rows`.
+ *
+ * The row counters are moved together with the rows; column heights and holes
+ * are taken from the row masks of the compacted board.
+ *
+ * @param features  A pointer to the features to update.
+ * @param board     A pointer to the board after the removal.
+ * @param lines     The mask of the removed rows.
+ */
+void features_remove_rows(Features_t *features, const Board_t *board,
+                          uint32_t lines);
+
+#endif
@@ -0,0 +1,315 @@
+#define _POSIX_C_SOURCE 200809L
+#include "bot.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "backend.h"
+
+#define BOT_MAX_PLACEMENTS (COUNT_OF_ROTATIONS * REAL_FIELD_WIDTH)
+#define BOT_LOST (-1e9)
+
+/**
+ * @brief One placement of the current figure being scored.
+ *
+ * @var rotation  The rotation of the figure.
+ * @var y         The horizontal displacement of the figure.
+ * @var score     The score of the placement (filled by the search).
+ */
+typedef struct {
+  int rotation;
+  int y;
+  double score;
+} Candidate_t;
+
+/**
+ * @brief Automatic player.
+ *
+ * @var weights     The weights of the score.
+ * @var threads     The search threads.
+ * @var count       The number of search threads.
+ * @var lock        Protects the fields of the current search.
+ * @var start       Signals the threads that a search has started or that they
+ * must stop.
+ * @var done        Signals the caller that all placements are scored.
+ * @var generation  The number of the current search.
+ * @var stop        `true` when the threads must exit.
+ * @var board       The board of the searched game.
+ * @var figure      The current figure of the searched game.
+ * @var next        The type of the next figure.
+ * @var candidates  The placements of the current figure.
+ * @var total       The number of placements.
+ * @var taken       The number of placements taken by the threads.
+ * @var scored      The number of placements already scored.
+ * @var planned     `true` if `plan` belongs to the current figure.
+ * @var pieces      The number of fixed figures when `plan` was made.
+ * @var plan        The placement chosen for the current figure.
+ */
+struct Bot {
+  BotWeights_t weights;
+  pthread_t *threads;
+  int count;
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  bool stop;
+  Board_t board;
+  Figure_position figure;
+  int next;
+  Candidate_t candidates[BOT_MAX_PLACEMENTS];
+  int total;
+  int taken;
+  int scored;
+  bool planned;
+  int pieces;
+  BotMove_t plan;
+};
+
+BotWeights_t bot_default_weights(void) {
+  BotWeights_t weights = {.height = -0.510066,
+                          .lines = 0.760666,
+                          .holes = -0.35663,
+                          .bumpiness = -0.184483};
+  return weights;
+}
+
+// фигура помещается на поле в заданном положении
+static bool fits(const Board_t *board, const Shape_t *shape, int x, int y) {
+  bool flag = x + shape->min_row >= 0 && x + shape->max_row < BOARD_FLOOR &&
+              y + shape->min_col >= 0 && y + shape->max_col < REAL_FIELD_WIDTH;
+  for (int i = shape->min_row; i <= shape->max_row && flag; ++i) {
+    if (board->rows[x + i] & shape_row_mask(shape, i - shape->min_row, y)) {
+      flag = false;
+    }
+  }
+  return flag;
+}
+
+// сброс фигуры с фиксацией и удалением линий, -1 если фигура не помещается
+// или игра после этого заканчивается
+static int drop(Board_t *board, const Shape_t *shape, int x, int y) {
+  int lines = -1;
+  if (fits(board, shape, x, y)) {
+    while (fits(board, shape, x + 1, y)) {
+      x++;
+    }
+    for (int i = shape->min_row; i <= shape->max_row; ++i) {
+      board->rows[x + i] |= shape_row_mask(shape, i - shape->min_row, y);
+    }
+    uint32_t full = board_full_rows(board);
+    board_remove_rows(board, full);
+    lines = 0;
+    for (; full; full &= full - 1) {
+      lines++;
+    }
+    if (board->rows[HIGHEST_LINE]) {
+      lines = -1;
+    }
+  }
+  return lines;
+}
+
+// оценка поля по высотам, дырам и неровности
+static double evaluate(const BotWeights_t *weights, const Board_t *board,
+                       int lines) {
+  Features_t features;
+  features_load(&features, board);
+  int height = 0, bumpiness = 0;
+  for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+    height += features.height[j];
+    if (j > 0) {
+      bumpiness += abs(features.height[j] - features.height[j - 1]);
+    }
+  }
+  return weights->height * height + weights->lines * lines +
+         weights->holes * features.holes + weights->bumpiness * bumpiness;
+}
+
+// верхний ряд фигуры должен быть на видимой части поля
+static int start_row(const Shape_t *shape, int x) {
+  return x + shape->min_row > 0 ? x : 1 - shape->min_row;
+}
+
+// лучшая оценка после размещения текущей фигуры и всех вариантов следующей
+static double score_candidate(const Bot_t *bot, const Candidate_t *candidate) {
+  Board_t board = bot->board;
+  const Shape_t *shape = shape_get(bot->figure.figure, candidate->rotation);
+  int lines = drop(&board, shape, start_row(shape, bot->figure.x),
+                   candidate->y);
+  double best = BOT_LOST;
+  if (lines >= 0) {
+    best = evaluate(&bot->weights, &board, lines);
+    bool first = true;
+    for (int rotation = 0; rotation < COUNT_OF_ROTATIONS; ++rotation) {
+      const Shape_t *next = shape_get(bot->next, rotation);
+      for (int y = -next->min_col; y + next->max_col < REAL_FIELD_WIDTH; ++y) {
+        Board_t after = board;
+        int more = drop(&after, next, start_row(next, 0), y);
+        if (more >= 0) {
+          double score = evaluate(&bot->weights, &after, lines + more);
+          if (first || score > best) {
+            best = score;
+            first = false;
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+
+// потоки и вызывающий поток разбирают размещения по одному
+static void score_all(Bot_t *bot) {
+  bool work = true;
+  while (work) {
+    pthread_mutex_lock(&bot->lock);
+    int index = bot->taken < bot->total ? bot->taken++ : -1;
+    pthread_mutex_unlock(&bot->lock);
+    work = index >= 0;
+    if (work) {
+      double score = score_candidate(bot, &bot->candidates[index]);
+      pthread_mutex_lock(&bot->lock);
+      bot->candidates[index].score = score;
+      if (++bot->scored == bot->total) {
+        pthread_cond_signal(&bot->done);
+      }
+      pthread_mutex_unlock(&bot->lock);
+    }
+  }
+}
+
+static void *worker(void *arg) {
+  Bot_t *bot = (Bot_t *)arg;
+  unsigned long seen = 0;
+  bool running = true;
+  while (running) {
+    pthread_mutex_lock(&bot->lock);
+    while (!bot->stop && bot->generation == seen) {
+      pthread_cond_wait(&bot->start, &bot->lock);
+    }
+    seen = bot->generation;
+    running = !bot->stop;
+    pthread_mutex_unlock(&bot->lock);
+    if (running) {
+      score_all(bot);
+    }
+  }
+  return NULL;
+}
+
+Bot_t *bot_create(int threads, const BotWeights_t *weights) {
+  Bot_t *bot = NULL;
+  if (threads >= 0) {
+    bot = (Bot_t *)calloc(1, sizeof(Bot_t));
+  }
+  if (bot) {
+    bot->weights = weights ? *weights : bot_default_weights();
+    pthread_mutex_init(&bot->lock, NULL);
+    pthread_cond_init(&bot->start, NULL);
+    pthread_cond_init(&bot->done, NULL);
+    bot->threads =
+        (pthread_t *)calloc(threads ? threads : 1, sizeof(pthread_t));
+    if (!bot->threads) {
+      bot_destroy(bot);
+      bot = NULL;
+    }
+  }
+  for (int i = 0; bot && i < threads; ++i) {
+    if (pthread_create(&bot->threads[i], NULL, worker, bot)) {
+      bot_destroy(bot);
+      bot = NULL;
+    } else {
+      bot->count++;
+    }
+  }
+  return bot;
+}
+
+void bot_destroy(Bot_t *bot) {
+  if (bot) {
+    pthread_mutex_lock(&bot->lock);
+    bot->stop = true;
+    pthread_cond_broadcast(&bot->start);
+    pthread_mutex_unlock(&bot->lock);
+    for (int i = 0; i < bot->count; ++i) {
+      pthread_join(bot->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&bot->lock);
+    pthread_cond_destroy(&bot->start);
+    pthread_cond_destroy(&bot->done);
+    free(bot->threads);
+    free(bot);
+  }
+}
+
+BotMove_t bot_search(Bot_t *bot, const TetrisContext *ctx) {
+  BotMove_t move = {.found = false};
+  pthread_mutex_lock(&bot->lock);
+  bot->board = ctx->board;
+  bot->figure = ctx->figure;
+  bot->next = ctx->figure.next_figure;
+  bot->total = 0;
+  for (int rotation = 0; rotation < COUNT_OF_ROTATIONS; ++rotation) {
+    const Shape_t *shape = shape_get(ctx->figure.figure, rotation);
+    for (int y = -shape->min_col; y + shape->max_col < REAL_FIELD_WIDTH; ++y) {
+      Candidate_t candidate = {.rotation = rotation, .y = y};
+      bot->candidates[bot->total++] = candidate;
+    }
+  }
+  bot->taken = 0, bot->scored = 0;
+  bot->generation++;
+  pthread_cond_broadcast(&bot->start);
+  pthread_mutex_unlock(&bot->lock);
+  score_all(bot);
+  pthread_mutex_lock(&bot->lock);
+  while (bot->scored < bot->total) {
+    pthread_cond_wait(&bot->done, &bot->lock);
+  }
+  pthread_mutex_unlock(&bot->lock);
+  // при равных оценках выбирается первое размещение, результат не зависит от
+  // числа потоков
+  for (int i = 0; i < bot->total; ++i) {
+    const Candidate_t *candidate = &bot->candidates[i];
+    if (candidate->score > BOT_LOST &&
+        (!move.found || candidate->score > move.score)) {
+      move.found = true;
+      move.rotation = candidate->rotation;
+      move.y = candidate->y;
+      move.score = candidate->score;
+    }
+  }
+  return move;
+}
+
+UserAction_t bot_action(Bot_t *bot, const TetrisContext *ctx) {
+  const GameInfo_t *game = &ctx->game;
+  const Figure_position *figure = &ctx->figure;
+  UserAction_t action = Up;
+  if (game->pause == ready_to_start) {
+    action = Start;
+    bot->planned = false;
+  } else if (game->field && game->pause != pause &&
+             game->pause != terminate && game->pause != game_over) {
+    const Shape_t *shape = shape_get(figure->figure, figure->rotation);
+    if (figure->x + shape->min_row > ZERO_X) {  // фигура уже видна на поле
+      if (!bot->planned || bot->pieces != ctx->pieces) {
+        bot->plan = bot_search(bot, ctx);
+        bot->planned = true;
+        bot->pieces = ctx->pieces;
+      }
+      if (!bot->plan.found) {
+        action = Down;
+      } else if (figure->rotation != bot->plan.rotation) {
+        action = Action;
+      } else if (figure->y < bot->plan.y) {
+        action = Right;
+      } else if (figure->y > bot->plan.y) {
+        action = Left;
+      } else {
+        action = Down;
+      }
+    }
+  }
+  return action;
+}
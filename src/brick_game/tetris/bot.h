@@ -0,0 +1,104 @@
+#ifndef H_FILE_BOT
+#define H_FILE_BOT
+#include <stdbool.h>
+
+#include "common.h"
+
+/**
+ * @brief Weights of the features of a board in the score of a placement.
+ *
+ * The score of a position is the sum of the features multiplied by their
+ * weights, so the features that make a position worse need negative weights.
+ *
+ * @var height     The weight of the sum of the heights of all columns.
+ * @var lines      The weight of the number of lines removed by the placements.
+ * @var holes      The weight of the number of holes.
+ * @var bumpiness  The weight of the sum of height differences of neighbouring
+ * columns.
+ */
+typedef struct {
+  double height;
+  double lines;
+  double holes;
+  double bumpiness;
+} BotWeights_t;
+
+/**
+ * @brief A placement of the current figure chosen by the bot.
+ *
+ * @var found     `false` if the figure cannot be placed anywhere.
+ * @var rotation  The rotation of the figure.
+ * @var y         The horizontal displacement of the figure
+ * (`Figure_position::y`).
+ * @var score     The score of the best position reachable with this
+ * placement and a placement of the next figure.
+ */
+typedef struct {
+  bool found;
+  int rotation;
+  int y;
+  double score;
+} BotMove_t;
+
+/**
+ * @brief Opaque automatic player with its own pool of search threads.
+ */
+typedef struct Bot Bot_t;
+
+/**
+ * @brief Returns the default weights of the bot.
+ *
+ * @return Weights that clear lines steadily and keep the stack low.
+ */
+BotWeights_t bot_default_weights(void);
+
+/**
+ * @brief Creates an automatic player.
+ *
+ * @param threads  The number of search threads started in addition to the
+ * calling thread (0 searches in the calling thread only).
+ * @param weights  The weights of the score or `NULL` for the default ones.
+ *
+ * @return A pointer to the bot or `NULL` if it cannot be created. The bot must
+ * be released with `bot_destroy`.
+ */
+Bot_t *bot_create(int threads, const BotWeights_t *weights);
+
+/**
+ * @brief Stops the search threads of a bot and releases it.
+ *
+ * @param bot  The bot; `NULL` does nothing.
+ */
+void bot_destroy(Bot_t *bot);
+
+/**
+ * @brief Finds the best placement of the current figure of a game.
+ *
+ * Every rotation and horizontal position of the current figure is dropped
+ * from its current row; for each resulting board every placement of the next
+ * figure is tried, and the placement of the current figure leading to the
+ * best scored board is chosen. The placements of the current figure are
+ * scored in parallel by the threads of the bot. The game is not changed.
+ *
+ * @param bot  The bot.
+ * @param ctx  The game context with a falling figure.
+ *
+ * @return The chosen placement.
+ */
+BotMove_t bot_search(Bot_t *bot, const TetrisContext *ctx);
+
+/**
+ * @brief Returns the next input of the bot for a game.
+ *
+ * The bot starts the game, plans a placement for every new figure with
+ * `bot_search` and then rotates the figure, moves it to the chosen column and
+ * drops it, one action per call. Call it before every `tetris_step`.
+ *
+ * @param bot  The bot.
+ * @param ctx  The game context.
+ *
+ * @return The action to pass to `tetris_input`.
+ */
+UserAction_t bot_action(Bot_t *bot, const TetrisContext *ctx);
+
+#endif
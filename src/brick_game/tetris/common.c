@@ -2,16 +2,23 @@
 
 #include "backend.h"
 
+// создание независимого контекста игры, игра инициализируется при первом вводе
+TetrisContext *tetris_create(void) {
+  return (TetrisContext *)calloc(1, sizeof(TetrisContext));
+}
+
+// контекст не владеет другой памятью, незавершенная игра освобождается с ним
+void tetris_destroy(TetrisContext *ctx) { free(ctx); }
+
 // преобразование ввода пользователя в новое состояние игры
-void userInput(UserAction_t action, bool hold) {
-  GameInfo_t *game = set_game_info();
-  static int init = 1;
-  Figure_position *figure = set_figure_info();
-  if (init == 1) {
-    init = 0;
-    init_game(game, figure);
-  }
-  if (game->pause == game_over) init = 1;  ///////
+void tetris_input(TetrisContext *ctx, UserAction_t action, bool hold) {
+  GameInfo_t *game = &ctx->game;
+  ctx->input = action;
+  if (!ctx->initialized) {
+    ctx->initialized = true;
+    init_game(ctx);
+  }
+  if (game->pause == game_over) ctx->initialized = false;  ///////
   (void)hold;
   if (game->pause != terminate && game->pause != game_over &&
       game->pause != pause) {
@@ -50,29 +57,204 @@ void userInput(UserAction_t action, bool hold) {
   }
 }
 
+// упаковка всего, что видно на экране, кроме клеток поля (они меняются
+// только вместе с фигурой или счетом), в одно число
+static unsigned long long state_digest(const TetrisContext *ctx) {
+  const Figure_position *figure = &ctx->figure;
+  unsigned long long digest = (unsigned long long)(figure->x + 8) & 0x3F;
+  digest = digest << 6 | ((unsigned long long)(figure->y + 16) & 0x3F);
+  digest = digest << 2 | ((unsigned long long)figure->rotation & 0x3);
+  digest = digest << 3 | ((unsigned long long)figure->figure & 0x7);
+  digest = digest << 3 | ((unsigned long long)figure->next_figure & 0x7);
+  digest = digest << 4 | ((unsigned long long)ctx->game.pause & 0xF);
+  digest = digest << 32 | ((unsigned long long)ctx->pieces & 0xFFFFFFFF);
+  return digest;
+}
+
 // все манипуляции с полем: сдвиги и проверка на обновление счета, рекорда,
 // скорости, уровня, состояния игры. Проверка на возможность убрать строки
 // происходит только в том случае, если предыдущая фигура достигла нижней
 // возможной позиции
-GameInfo_t updateCurrentState() {
-  GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  game_active(game, figure);
-  if (game->pause == no_signal && !can_move(figure, game, MOVE_DOWN)) {
-    fix_figure(figure, game);
-    check_field(game);
+GameInfo_t tetris_step(TetrisContext *ctx) {
+  GameInfo_t *game = &ctx->game;
+  Figure_position *figure = &ctx->figure;
+  STATS_BEGIN(start);
+  timer_tick(&ctx->timer);
+  if (ctx->replay) {
+    replay_record_step(ctx);
+  }
+  ctx->input = Up;
+  game_active(ctx);
+  if (game->pause == no_signal && !can_move(ctx, MOVE_DOWN)) {
+    fix_figure(ctx);
+    check_field(ctx);
   }
   if (game->pause == next_figure) {
     figure->figure = figure->next_figure;
-    figure->next_figure = rand() % COUNT_OF_FIGURES;
+    figure->next_figure = next_piece(ctx);
     random_figure(figure->next_figure, game);
     game->next[2][2] = figure->figure + 1,
     game->next[3][2] = figure->next_figure + 1;
     figure->x = 0, figure->y = 0, figure->rotation = 0;
     game->pause = shift;
   }
-  if (game->pause == terminate || game->pause == game_over) {
+  unsigned long long digest = state_digest(ctx);
+  if (digest != ctx->digest) {
+    ctx->digest = digest;
+    ctx->version++;
+    if (game->field) {
+      build_frame(ctx);
+      if (ctx->feed) {
+        feed_publish_step(ctx);
+      }
+    }
+  }
+  if ((game->pause == terminate || game->pause == game_over) && game->field) {
+    if (!ctx->headless) {
+      save_high_score(game);
+    }
     free_game(game);
+    ctx->replay = NULL;  // запись заканчивается вместе с игрой
   }
+  STATS_END(steps, start);
+  STATS_POLL();
   return *game;
 }
+
+void tetris_set_timer(TetrisContext *ctx, TimeSource_t source,
+                      double step_ms) {
+  timer_init(&ctx->timer, source, step_ms);
+  ctx->last_update = 0;
+  ctx->accumulator = 0;
+}
+
+void tetris_seed(TetrisContext *ctx, unsigned long long seed) {
+  rng_seed(&ctx->rng, seed, 0);
+  ctx->seeded = true;
+  ctx->bag_size = 0;
+}
+
+void tetris_set_randomizer(TetrisContext *ctx, Randomizer_t randomizer) {
+  ctx->randomizer = randomizer;
+  ctx->bag_size = 0;
+}
+
+void tetris_advance_time(TetrisContext *ctx, double ms) {
+  timer_advance(&ctx->timer, ms);
+}
+
+// длина такта округляется до миллисекунды, чтобы записи игр были точными
+void tetris_set_tick_rate(TetrisContext *ctx, double ticks_per_second) {
+  double step = 1;
+  if (ticks_per_second > 0 && 1000.0 / ticks_per_second > 1) {
+    step = (double)(long long)(1000.0 / ticks_per_second + 0.5);
+  }
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, step);
+}
+
+static bool game_ended(const TetrisContext *ctx) {
+  return ctx->game.pause == terminate || ctx->game.pause == game_over;
+}
+
+// накопленное время расходуется целыми тактами, после долгой остановки
+// лишнее время отбрасывается
+GameInfo_t tetris_advance(TetrisContext *ctx, double elapsed_ms, int max_ticks,
+                          int *ticks) {
+  int count = 0;
+  double step = ctx->timer.step_ms;
+  if (ctx->timer.source == TIMER_FIXED_STEP && step > 0) {
+    ctx->accumulator += elapsed_ms > 0 ? elapsed_ms : 0;
+    while (ctx->accumulator >= step && !game_ended(ctx) &&
+           (max_ticks <= 0 || count < max_ticks)) {
+      // такт без нового ввода получает Up, как шаг интерфейса без клавиши
+      if (!ctx->initialized || ctx->input == Up) {
+        tetris_input(ctx, Up, 0);
+      }
+      tetris_step(ctx);
+      ctx->accumulator -= step;
+      count++;
+    }
+    if (ctx->accumulator >= step) {
+      ctx->accumulator -= step * (double)(long long)(ctx->accumulator / step);
+    }
+  } else {
+    tetris_step(ctx);
+    count = 1;
+  }
+  if (ticks) *ticks = count;
+  return ctx->game;
+}
+
+int tetris_tick_wait(const TetrisContext *ctx) {
+  int wait = -1;
+  if (ctx->timer.source == TIMER_FIXED_STEP) {
+    double left = ctx->timer.step_ms - ctx->accumulator;
+    wait = left > 0 ? (int)left + (left > (int)left) : 0;
+  }
+  return wait;
+}
+
+unsigned long tetris_version(const TetrisContext *ctx) { return ctx->version; }
+
+const Frame_t *tetris_frame(const TetrisContext *ctx) { return &ctx->frame; }
+
+bool tetris_ghost(const TetrisContext *ctx, int cells[FIGURE_PART][2]) {
+  int state = ctx->game.pause;
+  bool active = ctx->game.field && state != ready_to_start &&
+                state != pause && state != terminate && state != game_over;
+  if (active) {
+    const Figure_position *figure = &ctx->figure;
+    const Shape_t *shape = shape_get(figure->figure, figure->rotation);
+    int x = figure->x + drop_distance(ctx);
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      cells[i][0] = x + shape->cells[i][0];
+      cells[i][1] = figure->y + shape->cells[i][1];
+    }
+  }
+  return active;
+}
+
+const Features_t *tetris_features(const TetrisContext *ctx) {
+  return &ctx->features;
+}
+
+int tetris_cleared_rows(const TetrisContext *ctx, int *rows) {
+  int count = 0;
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    if (ctx->cleared >> i & 1u) {
+      if (rows) rows[count] = i;
+      count++;
+    }
+  }
+  return count;
+}
+
+// время до следующего сдвига фигуры по таймеру, -1 если игра не идет
+int tetris_wait_time(const TetrisContext *ctx) {
+  int wait = -1;
+  int state = ctx->game.pause;
+  if (ctx->initialized && ctx->game.field && state != ready_to_start &&
+      state != pause && state != terminate && state != game_over) {
+    double left = ctx->last_update + ctx->delay - timer_now(&ctx->timer) -
+                  ctx->accumulator;
+    wait = left > 0 ? (int)left + (left > (int)left) : 0;
+  }
+  return wait;
+}
+
+// сон не длиннее max_ticks тактов: до первого такта tick, дальше по step_ms
+int tetris_sleep_time(const TetrisContext *ctx, int max_ticks) {
+  int wait = tetris_wait_time(ctx), tick = tetris_tick_wait(ctx);
+  if (wait >= 0 && tick >= 0) {
+    if (wait < tick) wait = tick;
+    double most = tick + ctx->timer.step_ms * (max_ticks - 1);
+    if (max_ticks > 0 && wait > most) wait = (int)most;
+  }
+  return wait;
+}
+
+void userInput(UserAction_t action, bool hold) {
+  tetris_input(tetris_default(), action, hold);
+}
+
+GameInfo_t updateCurrentState() { return tetris_step(tetris_default()); }
@@ -3,6 +3,9 @@
 #include <stdbool.h>
 
 #include "../../tetris.h"
+#include "board.h"
+#include "rng.h"
+#include "timer.h"
 
 /**
  * @brief Enumeration defining possible user actions.
@@ -40,7 +43,9 @@ typedef enum {
  *
  * @var field       A two-dimensional array representing the game field.
  *                  Each element of the array contains information about what is
- *                  in that cell of the field (empty, part of a figure, etc.).
+ *                  in that cell of the field (empty or the type of the fixed
+ *                  figure plus one). The falling figure is not stored there,
+ *                  it is drawn into the frame (see `tetris_frame`).
  * @var next        A two-dimensional array containing the coordinates of the
  * parts of the next figure that should appear in the game.
  * @var score       The player's current score.
@@ -60,15 +65,317 @@ typedef struct {
   int pause;
 } GameInfo_t;
 
+/**
+ * @brief The number of columns of a frame.
+ */
+#define FRAME_WIDTH REAL_FIELD_WIDTH
+
+/**
+ * @brief The number of rows of a frame (row 0 is above the visible field).
+ */
+#define FRAME_HEIGHT FIELD_HEIGHT
+
+/**
+ * @brief The number of cells of a frame.
+ */
+#define FRAME_SIZE (FRAME_WIDTH * FRAME_HEIGHT)
+
+/**
+ * @brief The value of the empty cells of a frame where the falling figure
+ * would land.
+ */
+#define FRAME_GHOST (COUNT_OF_FIGURES + 1)
+
+/**
+ * @brief Snapshot of the game field prepared for drawing.
+ *
+ * The cells are stored row by row in one array of known size, so an interface
+ * can walk the whole field with one index: the cell of row `i` and column `j`
+ * is `cells[i * FRAME_WIDTH + j]`.
+ *
+ * @var cells    The color of every cell: `EMPTY_PLACE` for an empty cell,
+ * `FRAME_GHOST` for an empty cell where the falling figure would land,
+ * otherwise the type of the figure plus one (for fixed cells and for the cells
+ * of the falling figure).
+ * @var version  The value of `tetris_version` when the frame was built.
+ */
+typedef struct {
+  unsigned char cells[FRAME_SIZE];
+  unsigned long version;
+} Frame_t;
+
+/**
+ * @brief Opaque handle of one independent game.
+ *
+ * A `TetrisContext` holds the whole state of a game: the `GameInfo_t` view,
+ * the current figure, the board and the timer. Any number of contexts can
+ * exist in one process; functions working with different contexts do not
+ * share any state. `userInput` and `updateCurrentState` work with a default
+ * context.
+ */
+typedef struct TetrisContext TetrisContext;
+
+/**
+ * @brief Creates a new independent game.
+ *
+ * The game itself is initialized by the first call of `tetris_input`, the
+ * same way as the default game is initialized by the first `userInput`.
+ *
+ * @return A pointer to the new context or `NULL` if there is not enough
+ * memory. The context must be released with `tetris_destroy`.
+ */
+TetrisContext *tetris_create(void);
+
+/**
+ * @brief Handles user input for the specified game.
+ *
+ * Works as `userInput`, but with the state stored in `ctx`.
+ *
+ * @param ctx     The game context.
+ * @param action  The user's action.
+ * @param hold    A flag indicating whether the button is being held down (not
+ * used in this implementation).
+ */
+void tetris_input(TetrisContext *ctx, UserAction_t action, bool hold);
+
+/**
+ * @brief Updates the state of the specified game by one step.
+ *
+ * Works as `updateCurrentState`, but with the state stored in `ctx`.
+ *
+ * @param ctx The game context.
+ *
+ * @return A copy of the `GameInfo_t` view of the game.
+ */
+GameInfo_t tetris_step(TetrisContext *ctx);
+
+/**
+ * @brief Releases a game created by `tetris_create`.
+ *
+ * The context holds all the memory of its game, so an unfinished game is
+ * released together with it. Passing `NULL` does nothing. Contexts taken from
+ * a `TetrisPool_t` must be returned with `tetris_pool_release` instead.
+ *
+ * @param ctx The game context.
+ */
+void tetris_destroy(TetrisContext *ctx);
+
+/**
+ * @brief Sets the source of time of the gravity timer of a game.
+ *
+ * By default games use the monotonic wall clock (`TIMER_REAL`). Simulations
+ * and tests can make the time advance by a fixed amount on every
+ * `tetris_step` (`TIMER_FIXED_STEP`) or only on `tetris_advance_time`
+ * (`TIMER_VIRTUAL`), so the game does not depend on the speed of the machine.
+ * The time of the new source starts from zero.
+ *
+ * @param ctx      The game context.
+ * @param source   The source of time.
+ * @param step_ms  The time of one step for `TIMER_FIXED_STEP` (ms).
+ */
+void tetris_set_timer(TetrisContext *ctx, TimeSource_t source,
+                      double step_ms);
+
+/**
+ * @brief Seeds the generator of figures of a game.
+ *
+ * Every game has its own generator, so the sequence of figures depends only on
+ * the seed and games can run in different threads. A game that was not seeded
+ * uses `RNG_DEFAULT_SEED`. The next game in the same context continues the
+ * sequence.
+ *
+ * @param ctx   The game context.
+ * @param seed  The seed.
+ */
+void tetris_seed(TetrisContext *ctx, unsigned long long seed);
+
+/**
+ * @brief Sets the way the figures of a game are chosen.
+ *
+ * @param ctx         The game context.
+ * @param randomizer  `RANDOMIZER_UNIFORM` (the default) or `RANDOMIZER_BAG`.
+ */
+void tetris_set_randomizer(TetrisContext *ctx, Randomizer_t randomizer);
+
+/**
+ * @brief Moves the time of a game with a virtual or fixed-step timer forward.
+ *
+ * @param ctx  The game context.
+ * @param ms   The time to add (ms).
+ */
+void tetris_advance_time(TetrisContext *ctx, double ms);
+
+/**
+ * @brief Makes a game run on fixed ticks of the given rate.
+ *
+ * The timer of the game becomes `TIMER_FIXED_STEP` with one tick per step, so
+ * the game advances the same way however often it is drawn. The tick is
+ * rounded to whole milliseconds (at least 1 ms), so the times of recorded
+ * games stay exact. The time of the game starts from zero.
+ *
+ * @param ctx               The game context.
+ * @param ticks_per_second  The tick rate.
+ */
+void tetris_set_tick_rate(TetrisContext *ctx, double ticks_per_second);
+
+/**
+ * @brief Runs the ticks of a game that fit into the passed wall time.
+ *
+ * The time is added to the accumulator of the context, and one `tetris_step`
+ * is made for every whole tick in it; the rest waits for the next call. The
+ * input given with `tetris_input` before the call is handled by the first
+ * tick, and the other ticks get `Up` (no key), the same way an interface
+ * reports every step without a pressed key. A recorded game keeps only the
+ * last input before every tick, so the caller should give at most one input
+ * per tick. An interface passes the time since its previous call and draws the
+ * game at its own rate; a headless program can run any amount of game time
+ * at once.
+ *
+ * When the game ends, the remaining ticks are not made. If more than
+ * `max_ticks` ticks are due (the program was stalled), only `max_ticks` are
+ * made and the rest of the time is dropped, so the game slows down instead of
+ * spending ever more time catching up.
+ *
+ * Games without a `TIMER_FIXED_STEP` timer make exactly one step per call.
+ *
+ * @param ctx         The game context.
+ * @param elapsed_ms  The wall time since the previous call (ms).
+ * @param max_ticks   The most ticks to make, 0 for no limit.
+ * @param ticks       The number of made ticks or `NULL`.
+ *
+ * @return The state of the game after the last tick.
+ */
+GameInfo_t tetris_advance(TetrisContext *ctx, double elapsed_ms, int max_ticks,
+                          int *ticks);
+
+/**
+ * @brief Returns the wall time until the next tick of a game.
+ *
+ * @param ctx  The game context.
+ *
+ * @return The time in milliseconds, rounded up, or -1 if the timer of the game
+ * is not `TIMER_FIXED_STEP`.
+ */
+int tetris_tick_wait(const TetrisContext *ctx);
+
+/**
+ * @brief Returns the number of visible changes of the game.
+ *
+ * The counter grows every time `tetris_step` changes the figure, the fixed
+ * cells, the score or the game state, so an interface can skip redrawing
+ * frames that are identical to the previous one.
+ *
+ * @param ctx The game context.
+ *
+ * @return The change counter of the game.
+ */
+unsigned long tetris_version(const TetrisContext *ctx);
+
+/**
+ * @brief Returns the last frame of a game.
+ *
+ * `tetris_step` rebuilds the frame once, at the end of every step that changes
+ * the picture. After the end of the game the frame keeps the last field.
+ *
+ * @param ctx The game context.
+ *
+ * @return A pointer to the frame stored in the context; it stays valid until
+ * the context is destroyed.
+ */
+const Frame_t *tetris_frame(const TetrisContext *ctx);
+
+/**
+ * @brief Returns where the falling figure would land after a hard drop.
+ *
+ * @param ctx    The game context.
+ * @param cells  Receives the row and the column of every part of the figure in
+ * the landing position.
+ *
+ * @return `false` (and `cells` is not changed) if the game has no falling
+ * figure: it is not started, paused or finished.
+ */
+bool tetris_ghost(const TetrisContext *ctx, int cells[FIGURE_PART][2]);
+
+/**
+ * @brief Returns the features of the fixed cells of a game.
+ *
+ * The features (row fill counts, column heights and the number of holes) are
+ * updated when a figure is fixed and when lines are removed, so reading them
+ * costs nothing.
+ *
+ * @param ctx The game context.
+ *
+ * @return A read-only pointer to the features stored in the context; it stays
+ * valid until the context is destroyed.
+ */
+const Features_t *tetris_features(const TetrisContext *ctx);
+
+/**
+ * @brief Returns the lines removed when the last figure was fixed.
+ *
+ * @param ctx   The game context.
+ * @param rows  An array of at least `FIELD_HEIGHT` elements that receives the
+ * indices of the removed lines from top to bottom, as they were numbered
+ * before the removal. It can be `NULL` if only the number is needed.
+ *
+ * @return The number of removed lines.
+ */
+int tetris_cleared_rows(const TetrisContext *ctx, int *rows);
+
+/**
+ * @brief Returns the time until the next shift of the figure by the timer.
+ *
+ * An interface can wait for the user input at most this long and then call
+ * `tetris_step`, instead of polling the game in a loop. The wall time kept in
+ * the accumulator of `tetris_advance` is already taken into account.
+ *
+ * @param ctx The game context.
+ *
+ * @return The time in milliseconds (0 if the shift is already due) or -1 if
+ * the game is not running (not started, paused or finished) and nothing
+ * happens until the user input.
+ */
+int tetris_wait_time(const TetrisContext *ctx);
+
+/**
+ * @brief Returns how long an interface on ticks may sleep before the next
+ * `tetris_advance`.
+ *
+ * This is `tetris_wait_time`, but not less than the time until the next tick
+ * (the timer works only on ticks) and not more than `max_ticks` ticks: after a
+ * longer sleep `tetris_advance` with the same `max_ticks` would take the
+ * planned sleep for a stall and drop a part of it, and the game would slow
+ * down. The sleep may be late by less than one tick without losing time.
+ *
+ * @param ctx        The game context.
+ * @param max_ticks  The limit passed to `tetris_advance`, 0 for no limit.
+ *
+ * @return The time in milliseconds or -1 if nothing happens until the user
+ * input.
+ */
+int tetris_sleep_time(const TetrisContext *ctx, int max_ticks);
+
+/**
+ * @brief Returns the default game context.
+ *
+ * The `tetris_default` function provides access to the static variable `ctx`
+ * of type `TetrisContext`, which is used by `userInput` and
+ * `updateCurrentState`. Other games should be created with `tetris_create`.
+ *
+ * @return A pointer to the static variable `ctx` of type `TetrisContext`.
+ */
+TetrisContext *tetris_default(void);
+
 /**
  * @brief Handles user input and modifies the game state.
  *
  * The `userInput` function processes actions performed by the user and
- * modifies the game state stored in the `GameInfo_t` structure accordingly.
+ * modifies the game state stored in the `GameInfo_t` structure accordingly. It
+ * is a wrapper over `tetris_input` for the default context.
  *
  * The function performs the following actions:
- *   - Initializes the game on the first call (if `init == 1`), calling the
- * `init_game` function.
+ *   - Initializes the game on the first call (if the context is not
+ * initialized yet), calling the `init_game` function.
  *   - Resets the initialization flag if the game is in the `game_over` state.
  *   - Depending on the user's action (`action`) and the current game state
  *     (`game->pause`), performs the corresponding actions:
@@ -93,11 +400,10 @@ void userInput(UserAction_t action, bool hold);
  *
  * The `updateCurrentState` function performs the main steps of updating the
  * game state at each step of the game loop. It handles the logic of falling
- * figures, line checks, new figure generation, and game over.
+ * figures, line checks, new figure generation, and game over. It is a wrapper
+ * over `tetris_step` for the default context.
  *
  * The function performs the following actions:
- *   - Obtains pointers to the `GameInfo_t` and `Figure_position` structures
- * using the `set_game_info` and `set_figure_info` functions, respectively.
  *   - Calls the `game_active` function to handle actions related to the
  *     current game state.
  *   - If the game is not in the `no_signal` state and the figure cannot
@@ -108,8 +414,9 @@ void userInput(UserAction_t action, bool hold);
  * about the next figure, and sets the game state to `shift` (need to shift the
  *     figure down).
  *   - If the game is over (`game->pause == terminate` or `game->pause ==
- *     game_over`), it frees the memory allocated for game resources by calling
- *     the `free_game` function.
+ *     game_over`), it saves the high score (`save_high_score`) and frees the
+ *     memory allocated for game resources by calling the `free_game` function
+ *     (only once).
  *
  * @return A copy of the `GameInfo_t` structure containing the updated game
  * state.
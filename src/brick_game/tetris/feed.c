@@ -0,0 +1,189 @@
+#include "feed.h"
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+
+#define FEED_WORDS ((sizeof(FeedFrame_t) + 7) / 8)
+#define FEED_LINE 64
+
+/**
+ * @brief One frame of the ring.
+ *
+ * The frame is stored as atomic words, so a reader that copies it while the
+ * writer replaces it gets a torn copy instead of a data race, and throws the
+ * copy away because the mark has changed.
+ *
+ * @var mark   `2 * n + 1` while frame `n` is written, `2 * n + 2` after it
+ * is written, 0 before the first frame.
+ * @var words  The frame.
+ */
+typedef struct {
+  alignas(FEED_LINE) atomic_uint_least64_t mark;
+  atomic_uint_least64_t words[FEED_WORDS];
+} FeedSlot_t;
+
+/**
+ * @brief The ring of frames.
+ *
+ * @var head      The number of published frames; written only by the writer.
+ * @var capacity  The number of slots (a power of two).
+ * @var slots     The slots; frame `n` is kept in slot `n % capacity`.
+ */
+struct FrameFeed {
+  alignas(FEED_LINE) atomic_uint_least64_t head;
+  uint64_t capacity;
+  FeedSlot_t *slots;
+};
+
+FrameFeed_t *feed_create(int capacity) {
+  FrameFeed_t *feed = NULL;
+  if (capacity >= 2) {
+    feed = (FrameFeed_t *)aligned_alloc(FEED_LINE, sizeof(FrameFeed_t));
+  }
+  if (feed) {
+    feed->capacity = 2;
+    while (feed->capacity < (uint64_t)capacity) {
+      feed->capacity *= 2;
+    }
+    feed->slots = (FeedSlot_t *)aligned_alloc(
+        FEED_LINE, feed->capacity * sizeof(FeedSlot_t));
+    if (feed->slots) {
+      atomic_init(&feed->head, 0);
+      for (uint64_t i = 0; i < feed->capacity; ++i) {
+        atomic_init(&feed->slots[i].mark, 0);
+        for (size_t w = 0; w < FEED_WORDS; ++w) {
+          atomic_init(&feed->slots[i].words[w], 0);
+        }
+      }
+    } else {
+      free(feed);
+      feed = NULL;
+    }
+  }
+  return feed;
+}
+
+void feed_destroy(FrameFeed_t *feed) {
+  if (feed) {
+    free(feed->slots);
+    free(feed);
+  }
+}
+
+int feed_capacity(const FrameFeed_t *feed) { return (int)feed->capacity; }
+
+uint64_t feed_published(const FrameFeed_t *feed) {
+  return atomic_load_explicit(&feed->head, memory_order_acquire);
+}
+
+// писатель один, поэтому номер кадра можно читать без синхронизации;
+// ограждение не дает записи слов обогнать пометку "занят"
+void feed_publish(FrameFeed_t *feed, const FeedFrame_t *frame) {
+  uint64_t n = atomic_load_explicit(&feed->head, memory_order_relaxed);
+  FeedSlot_t *slot = &feed->slots[n & (feed->capacity - 1)];
+  FeedFrame_t copy = *frame;
+  uint64_t words[FEED_WORDS] = {0};
+  copy.sequence = n;
+  memcpy(words, &copy, sizeof(FeedFrame_t));
+  atomic_store_explicit(&slot->mark, 2 * n + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (size_t w = 0; w < FEED_WORDS; ++w) {
+    atomic_store_explicit(&slot->words[w], words[w], memory_order_relaxed);
+  }
+  atomic_store_explicit(&slot->mark, 2 * n + 2, memory_order_release);
+  atomic_store_explicit(&feed->head, n + 1, memory_order_release);
+}
+
+void feed_subscribe(const FrameFeed_t *feed, FeedReader_t *reader) {
+  uint64_t head = feed_published(feed);
+  reader->next = head ? head - 1 : 0;
+  reader->dropped = 0;
+}
+
+// копия кадра n годится, только если пометка слота до и после копирования
+// равна пометке записанного кадра n; пометка больше значит, что писатель уже
+// занял слот под более новый кадр и кадра n больше нет
+static bool read_slot(const FrameFeed_t *feed, uint64_t n, FeedFrame_t *frame,
+                      bool *gone) {
+  const FeedSlot_t *slot = &feed->slots[n & (feed->capacity - 1)];
+  uint64_t mark = atomic_load_explicit(&slot->mark, memory_order_acquire);
+  bool flag = mark == 2 * n + 2;
+  if (flag) {
+    uint64_t words[FEED_WORDS];
+    for (size_t w = 0; w < FEED_WORDS; ++w) {
+      words[w] = atomic_load_explicit(&slot->words[w], memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    mark = atomic_load_explicit(&slot->mark, memory_order_relaxed);
+    flag = mark == 2 * n + 2;
+    if (flag) {
+      memcpy(frame, words, sizeof(FeedFrame_t));
+    }
+  }
+  *gone = mark > 2 * n + 2;
+  return flag;
+}
+
+// кадр, который перезаписывается или уже перезаписан, считается потерянным и
+// пропускается сразу, не дожидаясь, пока писатель опубликует новый кадр
+bool feed_read(const FrameFeed_t *feed, FeedReader_t *reader,
+               FeedFrame_t *frame) {
+  bool flag = false, done = false, gone = false;
+  while (!done) {
+    uint64_t head = feed_published(feed);
+    if (reader->next >= head) {
+      done = true;
+    } else {
+      if (head - reader->next > feed->capacity) {
+        reader->dropped += head - feed->capacity - reader->next;
+        reader->next = head - feed->capacity;
+      }
+      flag = done = read_slot(feed, reader->next, frame, &gone);
+      if (flag || gone) {
+        reader->dropped += !flag;
+        reader->next++;
+      }
+    }
+  }
+  return flag;
+}
+
+bool feed_latest(const FrameFeed_t *feed, FeedReader_t *reader,
+                 FeedFrame_t *frame) {
+  bool flag = false, done = false, gone = false;
+  while (!done) {
+    uint64_t head = feed_published(feed);
+    if (reader->next >= head) {
+      done = true;
+    } else if (read_slot(feed, head - 1, frame, &gone)) {
+      reader->next = head;
+      flag = done = true;
+    }
+  }
+  return flag;
+}
+
+void tetris_publish(TetrisContext *ctx, FrameFeed_t *feed) {
+  ctx->feed = feed;
+}
+
+void feed_frame(const TetrisContext *ctx, FeedFrame_t *frame) {
+  const GameInfo_t *game = &ctx->game;
+  memset(frame, 0, sizeof(FeedFrame_t));
+  frame->frame = ctx->frame;
+  frame->score = game->score, frame->high_score = game->high_score;
+  frame->level = game->level, frame->speed = game->speed;
+  frame->state = game->pause;
+  frame->next_figure = ctx->figure.next_figure;
+  frame->pieces = ctx->pieces, frame->lines = ctx->lines;
+}
+
+void feed_publish_step(TetrisContext *ctx) {
+  FeedFrame_t frame;
+  feed_frame(ctx, &frame);
+  feed_publish(ctx->feed, &frame);
+}
@@ -0,0 +1,172 @@
+#ifndef H_FILE_FEED
+#define H_FILE_FEED
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+/**
+ * @brief Everything an observer needs to show one frame of a game.
+ *
+ * The frame has no pointers, so it can be copied between threads and
+ * processes as plain bytes.
+ *
+ * @var frame        The field with the falling figure and its ghost
+ * (`tetris_frame`); `frame.version` is the value of `tetris_version`.
+ * @var sequence     The number of the frame in its feed, starting from 0.
+ * @var score        The score.
+ * @var high_score   The high score.
+ * @var level        The level.
+ * @var speed        The speed.
+ * @var state        The state of the game (`game_state`).
+ * @var next_figure  The type of the next figure.
+ * @var pieces       The fixed figures.
+ * @var lines        The removed lines.
+ */
+typedef struct {
+  Frame_t frame;
+  uint64_t sequence;
+  int score;
+  int high_score;
+  int level;
+  int speed;
+  int state;
+  int next_figure;
+  int pieces;
+  int lines;
+} FeedFrame_t;
+
+/**
+ * @brief A ring of the last frames of a game shared with any number of
+ * readers.
+ *
+ * One thread (the game) publishes frames, any number of threads read them,
+ * and nobody waits for anybody: publishing never blocks and never fails, and
+ * a reader that falls behind by more than the capacity of the ring loses the
+ * oldest frames instead of stopping the game. Every slot of the ring is a
+ * sequence lock: the writer marks the slot as busy, copies the frame and
+ * marks it with the number of the frame, and a reader keeps its copy only if
+ * the mark did not change while it was copying.
+ */
+typedef struct FrameFeed FrameFeed_t;
+
+/**
+ * @brief Position of one reader of a feed.
+ *
+ * Every reader keeps its own position, so readers do not share any state
+ * with each other or write to the feed.
+ *
+ * @var next     The number of the next frame to read.
+ * @var dropped  The number of frames overwritten before the reader got to
+ * them.
+ */
+typedef struct {
+  uint64_t next;
+  uint64_t dropped;
+} FeedReader_t;
+
+/**
+ * @brief Creates an empty feed.
+ *
+ * @param capacity  The number of frames kept (at least 2, rounded up to a
+ * power of two).
+ *
+ * @return A pointer to the feed or `NULL` if `capacity` is less than 2 or
+ * there is not enough memory. The feed must be released with `feed_destroy`
+ * after all its readers and its writer have stopped.
+ */
+FrameFeed_t *feed_create(int capacity);
+
+/**
+ * @brief Releases a feed.
+ *
+ * @param feed  The feed; `NULL` does nothing.
+ */
+void feed_destroy(FrameFeed_t *feed);
+
+/**
+ * @brief Returns the number of frames a feed keeps.
+ */
+int feed_capacity(const FrameFeed_t *feed);
+
+/**
+ * @brief Returns the number of frames published to a feed.
+ */
+uint64_t feed_published(const FrameFeed_t *feed);
+
+/**
+ * @brief Adds a frame to a feed.
+ *
+ * Only one thread may publish to a feed. The frame gets the next number
+ * (`sequence` of the argument is ignored) and replaces the oldest frame of
+ * the ring.
+ *
+ * @param feed   The feed.
+ * @param frame  The frame.
+ */
+void feed_publish(FrameFeed_t *feed, const FeedFrame_t *frame);
+
+/**
+ * @brief Starts reading a feed.
+ *
+ * @param feed    The feed.
+ * @param reader  The reader to set to the last published frame, so the first
+ * read gets it (or the first frame of an empty feed).
+ */
+void feed_subscribe(const FrameFeed_t *feed, FeedReader_t *reader);
+
+/**
+ * @brief Reads the next frame of a feed.
+ *
+ * A reader that has fallen behind by more than the capacity skips to the
+ * oldest frame still in the ring and adds the lost frames to `dropped`. A
+ * frame whose slot the writer is already filling with a newer frame is
+ * dropped the same way, so a reader never waits for the writer.
+ *
+ * @param feed    The feed.
+ * @param reader  The reader, moved past the frame.
+ * @param frame   The frame.
+ *
+ * @return `false` if the reader has read all published frames.
+ */
+bool feed_read(const FrameFeed_t *feed, FeedReader_t *reader,
+               FeedFrame_t *frame);
+
+/**
+ * @brief Reads the newest frame of a feed, skipping the older unread ones.
+ *
+ * Suits readers that only show the current picture, such as renderers; the
+ * skipped frames are not counted as dropped.
+ *
+ * @param feed    The feed.
+ * @param reader  The reader, moved past the frame.
+ * @param frame   The frame.
+ *
+ * @return `false` if the reader has read all published frames.
+ */
+bool feed_latest(const FrameFeed_t *feed, FeedReader_t *reader,
+                 FeedFrame_t *frame);
+
+/**
+ * @brief Fills a frame with the current state of a game.
+ *
+ * @param ctx    The game context.
+ * @param frame  The frame; `sequence` is set to 0.
+ */
+void feed_frame(const TetrisContext *ctx, FeedFrame_t *frame);
+
+/**
+ * @brief Starts publishing the frames of the game of a context.
+ *
+ * After every step of the game that changes its picture (see
+ * `tetris_version`) `tetris_step` publishes the new frame with the score, the
+ * level and the next figure. The feed is owned by the caller and must live
+ * until the context stops publishing or is released. Copies of the context
+ * (`tetris_clone`, `tetris_restore`) do not publish.
+ *
+ * @param ctx   The context.
+ * @param feed  The feed or `NULL` to stop publishing.
+ */
+void tetris_publish(TetrisContext *ctx, FrameFeed_t *feed);
+
+#endif
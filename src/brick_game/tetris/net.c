@@ -0,0 +1,189 @@
+#define _GNU_SOURCE
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define NET_BACKLOG 128
+
+// адрес Unix-сокета; путь, не помещающийся в sun_path, - ошибка
+static bool unix_address(const char *path, struct sockaddr_un *address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  bool flag = strlen(path) < sizeof(address->sun_path);
+  if (flag) {
+    strcpy(address->sun_path, path);
+  }
+  return flag;
+}
+
+static void loopback_address(int port, struct sockaddr_in *address) {
+  memset(address, 0, sizeof(*address));
+  address->sin_family = AF_INET;
+  address->sin_port = htons((uint16_t)port);
+  address->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+// общая часть listen: привязка и очередь соединений
+static int bind_listen(int fd, const struct sockaddr *address,
+                       socklen_t size) {
+  if (fd >= 0 && (bind(fd, address, size) || listen(fd, NET_BACKLOG))) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+// сокет мертв, если к нему никто не слушает: connect получает отказ
+static bool stale_socket(const struct sockaddr_un *address) {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  bool flag = fd >= 0 &&
+              connect(fd, (const struct sockaddr *)address,
+                      sizeof(*address)) < 0 &&
+              errno == ECONNREFUSED;
+  net_close(fd);
+  return flag;
+}
+
+// удаляется только мертвый сокет, оставленный прежним сервером; живой сокет
+// другого сервера и любой другой файл по этому пути - ошибка
+static bool free_path(const struct sockaddr_un *address) {
+  struct stat info;
+  bool flag = true;
+  if (!lstat(address->sun_path, &info)) {
+    flag = S_ISSOCK(info.st_mode) && stale_socket(address) &&
+           !unlink(address->sun_path);
+    if (!flag) {
+      errno = EADDRINUSE;
+    }
+  }
+  return flag;
+}
+
+int net_listen_unix(const char *path, NetFile_t *bound) {
+  struct sockaddr_un address;
+  struct stat info;
+  int fd = -1;
+  if (unix_address(path, &address) && free_path(&address)) {
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    fd = bind_listen(fd, (struct sockaddr *)&address, sizeof(address));
+  }
+  if (fd >= 0 && !lstat(path, &info)) {
+    bound->device = (unsigned long long)info.st_dev;
+    bound->inode = (unsigned long long)info.st_ino;
+  }
+  return fd;
+}
+
+void net_unlink_unix(const char *path, const NetFile_t *bound) {
+  struct stat info;
+  if (!lstat(path, &info) && S_ISSOCK(info.st_mode) &&
+      (unsigned long long)info.st_dev == bound->device &&
+      (unsigned long long)info.st_ino == bound->inode) {
+    unlink(path);
+  }
+}
+
+int net_listen_tcp(int port) {
+  struct sockaddr_in address;
+  loopback_address(port, &address);
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int yes = 1;
+  if (fd >= 0) {
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  }
+  return bind_listen(fd, (struct sockaddr *)&address, sizeof(address));
+}
+
+int net_local_port(int fd) {
+  struct sockaddr_in address;
+  socklen_t size = sizeof(address);
+  int port = -1;
+  if (!getsockname(fd, (struct sockaddr *)&address, &size) &&
+      address.sin_family == AF_INET) {
+    port = ntohs(address.sin_port);
+  }
+  return port;
+}
+
+// короткие сообщения уходят сразу, без алгоритма Нейгла; для Unix-сокетов
+// параметр не существует, и ошибка не важна
+static int no_delay(int fd) {
+  int yes = 1;
+  if (fd >= 0) {
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+  }
+  return fd;
+}
+
+int net_accept(int fd) {
+  return no_delay(accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC));
+}
+
+static int connect_to(int fd, const struct sockaddr *address,
+                      socklen_t size) {
+  if (fd >= 0 && connect(fd, address, size)) {
+    close(fd);
+    fd = -1;
+  }
+  return fd;
+}
+
+int net_connect_unix(const char *path) {
+  struct sockaddr_un address;
+  int fd = -1;
+  if (unix_address(path, &address)) {
+    fd = connect_to(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+                    (struct sockaddr *)&address, sizeof(address));
+  }
+  return fd;
+}
+
+int net_connect_tcp(int port) {
+  struct sockaddr_in address;
+  loopback_address(port, &address);
+  return no_delay(connect_to(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0),
+                             (struct sockaddr *)&address, sizeof(address)));
+}
+
+long net_read(int fd, void *data, size_t size) {
+  ssize_t count = read(fd, data, size);
+  long result = count;
+  if (count == 0) {
+    result = -1;  // соединение закрыто
+  } else if (count < 0) {
+    result = errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0
+                                                                        : -1;
+  }
+  return result;
+}
+
+long net_write(int fd, const void *data, size_t size) {
+  ssize_t count = send(fd, data, size, MSG_NOSIGNAL);
+  long result = count;
+  if (count < 0) {
+    result = errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0
+                                                                        : -1;
+  }
+  return result;
+}
+
+bool net_wait(int fd, int timeout_ms) {
+  struct pollfd item = {.fd = fd, .events = POLLIN};
+  return poll(&item, 1, timeout_ms) > 0;
+}
+
+void net_close(int fd) {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
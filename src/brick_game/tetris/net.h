@@ -0,0 +1,112 @@
+#ifndef H_FILE_NET
+#define H_FILE_NET
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The calls of the operating system used by the game server. They live in a
+ * file of their own because <unistd.h> declares the function `pause`, which
+ * clashes with the game state of the same name from tetris.h.
+ */
+
+/**
+ * @brief The file a Unix domain socket is bound to.
+ *
+ * @var device  The device of the file.
+ * @var inode   The inode of the file.
+ */
+typedef struct {
+  unsigned long long device;
+  unsigned long long inode;
+} NetFile_t;
+
+/**
+ * @brief Opens a listening Unix domain socket.
+ *
+ * A socket left at `path` by a server that is gone (a connection to it is
+ * refused) is removed first. A socket another server still listens on and
+ * any other file at `path` are kept, and the call fails with `EADDRINUSE`.
+ *
+ * @param path   The path of the socket.
+ * @param bound  Receives the file the socket is bound to.
+ *
+ * @return The non-blocking socket or -1 on error.
+ */
+int net_listen_unix(const char *path, NetFile_t *bound);
+
+/**
+ * @brief Removes the file of a Unix domain socket, but only if `path` still
+ * is the file `bound` by `net_listen_unix` and not a socket of another server.
+ */
+void net_unlink_unix(const char *path, const NetFile_t *bound);
+
+/**
+ * @brief Opens a listening TCP socket on the loopback interface.
+ *
+ * @param port  The port; 0 chooses a free port (see `net_local_port`).
+ *
+ * @return The non-blocking socket or -1 on error.
+ */
+int net_listen_tcp(int port);
+
+/**
+ * @brief Returns the TCP port a socket is bound to or -1 on error.
+ */
+int net_local_port(int fd);
+
+/**
+ * @brief Accepts a connection of a listening socket.
+ *
+ * @param fd  The listening socket.
+ *
+ * @return The non-blocking socket of the connection or -1 if there is no
+ * connection to accept.
+ */
+int net_accept(int fd);
+
+/**
+ * @brief Connects to a Unix domain socket.
+ *
+ * @return The blocking socket or -1 on error.
+ */
+int net_connect_unix(const char *path);
+
+/**
+ * @brief Connects to a TCP port of the loopback interface.
+ *
+ * @return The blocking socket or -1 on error.
+ */
+int net_connect_tcp(int port);
+
+/**
+ * @brief Reads from a file descriptor.
+ *
+ * @return The number of bytes read, 0 if nothing can be read without
+ * blocking, -1 if the peer has closed the connection or on error.
+ */
+long net_read(int fd, void *data, size_t size);
+
+/**
+ * @brief Writes to a socket; a closed peer does not raise `SIGPIPE`.
+ *
+ * @return The number of bytes written, 0 if nothing can be written without
+ * blocking, -1 on error.
+ */
+long net_write(int fd, const void *data, size_t size);
+
+/**
+ * @brief Waits until a file descriptor can be read.
+ *
+ * @param fd          The file descriptor.
+ * @param timeout_ms  The longest wait (ms), -1 waits forever.
+ *
+ * @return `false` on timeout or error.
+ */
+bool net_wait(int fd, int timeout_ms);
+
+/**
+ * @brief Closes a file descriptor; -1 does nothing.
+ */
+void net_close(int fd);
+
+#endif
@@ -0,0 +1,142 @@
+#include "placement.h"
+
+#include "backend.h"
+
+#define PLACEMENT_NODES (PLACEMENT_MAX + 1)
+#define PLACEMENT_HASH_BITS 11
+#define PLACEMENT_HASH_SIZE (1 << PLACEMENT_HASH_BITS)
+
+_Static_assert(PLACEMENT_HASH_SIZE > 2 * PLACEMENT_NODES,
+               "the hash set must stay at most half full");
+
+/**
+ * @brief A position of the figure reached by the search.
+ *
+ * @var x         The vertical displacement.
+ * @var y         The horizontal displacement.
+ * @var rotation  The rotation.
+ * @var parent    The position it was reached from (-1 for the start).
+ * @var action    The action that led from `parent` to this position.
+ * @var depth     The number of actions from the start.
+ */
+typedef struct {
+  signed char x;
+  signed char y;
+  signed char rotation;
+  int parent;
+  unsigned char action;
+  int depth;
+} Node_t;
+
+/**
+ * @brief State of one search.
+ *
+ * @var ctx    A copy of the game used to check moves with the game rules.
+ * @var nodes  The reached positions in the order of the search (the queue).
+ * @var count  The number of reached positions.
+ * @var keys   The hash set of the reached positions: packed positions, 0 for
+ * an empty slot.
+ * @var index  The index in `nodes` of every key of the set.
+ */
+typedef struct {
+  TetrisContext ctx;
+  Node_t nodes[PLACEMENT_NODES];
+  int count;
+  unsigned keys[PLACEMENT_HASH_SIZE];
+  int index[PLACEMENT_HASH_SIZE];
+} Search_t;
+
+// позиция упаковывается в ненулевое число
+static unsigned pack(int x, int y, int rotation) {
+  return (unsigned)(x + 32) << 8 | (unsigned)(y + 32) << 2 |
+         (unsigned)rotation;
+}
+
+// добавление позиции, если она еще не встречалась (открытая адресация)
+static void visit(Search_t *search, int x, int y, int rotation, int parent,
+                  int action) {
+  unsigned key = pack(x, y, rotation);
+  unsigned slot = (key * 2654435761u) >> (32 - PLACEMENT_HASH_BITS);
+  while (search->keys[slot] && search->keys[slot] != key) {
+    slot = (slot + 1) & (PLACEMENT_HASH_SIZE - 1);
+  }
+  if (!search->keys[slot] && search->count < PLACEMENT_NODES) {
+    Node_t *node = &search->nodes[search->count];
+    node->x = (signed char)x, node->y = (signed char)y,
+    node->rotation = (signed char)rotation;
+    node->parent = parent, node->action = (unsigned char)action;
+    node->depth = parent >= 0 ? search->nodes[parent].depth + 1 : 0;
+    search->keys[slot] = key;
+    search->index[slot] = search->count++;
+  }
+}
+
+// ходы из позиции по правилам игры: сдвиги, поворот с подвижками, шаг вниз
+// по таймеру и сброс
+static void expand(Search_t *search, int current) {
+  Node_t node = search->nodes[current];
+  Figure_position *figure = &search->ctx.figure;
+  figure->x = node.x, figure->y = node.y, figure->rotation = node.rotation;
+  if (can_move(&search->ctx, MOVE_LEFT)) {
+    visit(search, node.x, node.y - 1, node.rotation, current, Left);
+  }
+  if (can_move(&search->ctx, MOVE_RIGHT)) {
+    visit(search, node.x, node.y + 1, node.rotation, current, Right);
+  }
+  if (can_move(&search->ctx, ROTATING) ||
+      can_shift_and_rotate(&search->ctx)) {
+    visit(search, node.x, figure->y, (node.rotation + 1) % COUNT_OF_ROTATIONS,
+          current, Action);
+  }
+  figure->y = node.y;
+  if (can_move(&search->ctx, MOVE_DOWN)) {
+    visit(search, node.x + 1, node.y, node.rotation, current, Up);
+    visit(search, node.x + drop_distance(&search->ctx), node.y, node.rotation,
+          current, Down);
+  }
+}
+
+// путь восстанавливается от позиции падения к начальной
+static bool write_path(const Search_t *search, int current,
+                       Placement_t *placement) {
+  const Node_t *node = &search->nodes[current];
+  bool fits = node->depth <= PLACEMENT_MAX_PATH;
+  if (fits) {
+    placement->x = node->x, placement->y = node->y,
+    placement->rotation = node->rotation;
+    placement->length = node->depth;
+    for (int i = node->depth - 1; i >= 0; --i) {
+      placement->path[i] = node->action;
+      node = &search->nodes[node->parent];
+    }
+  }
+  return fits;
+}
+
+int placements_find(const TetrisContext *ctx, Placement_t *placements,
+                    int capacity) {
+  Search_t search;
+  memset(search.keys, 0, sizeof(search.keys));
+  search.count = 0;
+  search.ctx.board = ctx->board;
+  search.ctx.features = ctx->features;
+  search.ctx.figure = ctx->figure;
+  const Figure_position *figure = &ctx->figure;
+  visit(&search, figure->x, figure->y, figure->rotation, -1, Up);
+  int found = 0;
+  for (int current = 0; current < search.count; ++current) {
+    const Node_t *node = &search.nodes[current];
+    Figure_position *scratch = &search.ctx.figure;
+    scratch->x = node->x, scratch->y = node->y,
+    scratch->rotation = node->rotation;
+    if (!can_move(&search.ctx, MOVE_DOWN)) {
+      if (found < capacity &&
+          write_path(&search, current, &placements[found])) {
+        found++;
+      }
+    } else {
+      expand(&search, current);
+    }
+  }
+  return found;
+}
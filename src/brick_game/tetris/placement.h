@@ -0,0 +1,61 @@
+#ifndef H_FILE_PLACEMENT
+#define H_FILE_PLACEMENT
+
+#include "common.h"
+
+/**
+ * @brief The longest input path stored in a `Placement_t`.
+ */
+#define PLACEMENT_MAX_PATH 64
+
+/**
+ * @brief The largest number of landing positions of one figure.
+ */
+#define PLACEMENT_MAX (COUNT_OF_ROTATIONS * FIELD_HEIGHT * REAL_FIELD_WIDTH)
+
+/**
+ * @brief A landing position of the current figure and the inputs leading to
+ * it.
+ *
+ * The path is a sequence of actions, each of them applied in its own step of
+ * the game: `Left`, `Right` and `Action` move or rotate the figure by the
+ * rules of the game (including the shifts of `can_shift_and_rotate`), `Up`
+ * stands for one shift of the figure down by the timer, `Down` drops the
+ * figure. The figure is fixed right after the last action.
+ *
+ * @var x         The vertical displacement of the figure in the landing
+ * position (`Figure_position::x`).
+ * @var y         The horizontal displacement of the figure
+ * (`Figure_position::y`).
+ * @var rotation  The rotation of the figure.
+ * @var length    The number of actions in `path`.
+ * @var path      The shortest sequence of actions (`UserAction_t` values).
+ */
+typedef struct {
+  int x;
+  int y;
+  int rotation;
+  int length;
+  unsigned char path[PLACEMENT_MAX_PATH];
+} Placement_t;
+
+/**
+ * @brief Finds all landing positions reachable by the current figure.
+ *
+ * The positions of the figure are explored breadth first from its current
+ * position; a hash set of visited positions makes sure that every position is
+ * expanded once, so each landing position comes with the shortest path. The
+ * game is not changed. Symmetric figures can land in the same cells with
+ * different rotations; such positions are reported separately.
+ *
+ * @param ctx         The game context with a falling figure.
+ * @param placements  An array that receives the landing positions.
+ * @param capacity    The size of the array (`PLACEMENT_MAX` is always
+ * enough).
+ *
+ * @return The number of positions written to `placements`.
+ */
+int placements_find(const TetrisContext *ctx, Placement_t *placements,
+                    int capacity);
+
+#endif
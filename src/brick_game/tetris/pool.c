@@ -0,0 +1,93 @@
+#include "pool.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "backend.h"
+
+/**
+ * @brief A fixed set of game contexts.
+ *
+ * @var contexts  The contexts of the pool.
+ * @var free      The indices of the contexts that are not in use (a stack).
+ * @var used      `true` for every context that is taken.
+ * @var capacity  The number of contexts.
+ * @var count     The number of indices in `free`.
+ */
+struct TetrisPool {
+  TetrisContext *contexts;
+  int *free;
+  bool *used;
+  int capacity;
+  int count;
+};
+
+TetrisPool_t *tetris_pool_create(int capacity) {
+  TetrisPool_t *pool = NULL;
+  if (capacity > 0) {
+    pool = (TetrisPool_t *)calloc(1, sizeof(TetrisPool_t));
+  }
+  if (pool) {
+    pool->contexts = (TetrisContext *)calloc(capacity, sizeof(TetrisContext));
+    pool->free = (int *)calloc(capacity, sizeof(int));
+    pool->used = (bool *)calloc(capacity, sizeof(bool));
+    if (!pool->contexts || !pool->free || !pool->used) {
+      tetris_pool_destroy(pool);
+      pool = NULL;
+    }
+  }
+  if (pool) {
+    pool->capacity = capacity;
+    for (int i = 0; i < capacity; ++i) {
+      pool->free[pool->count++] = capacity - 1 - i;
+    }
+  }
+  return pool;
+}
+
+TetrisContext *tetris_pool_acquire(TetrisPool_t *pool) {
+  TetrisContext *ctx = NULL;
+  if (pool->count > 0) {
+    int index = pool->free[--pool->count];
+    pool->used[index] = true;
+    ctx = &pool->contexts[index];
+  }
+  return ctx;
+}
+
+// номер контекста в пуле или -1 для чужого указателя; адреса сравниваются
+// как числа, потому что чужой указатель может быть из другого блока памяти
+static int pool_index(const TetrisPool_t *pool, const TetrisContext *ctx) {
+  uintptr_t begin = (uintptr_t)pool->contexts, address = (uintptr_t)ctx;
+  uintptr_t offset = address - begin;
+  int index = -1;
+  if (address >= begin && offset % sizeof(TetrisContext) == 0 &&
+      offset / sizeof(TetrisContext) < (uintptr_t)pool->capacity) {
+    index = (int)(offset / sizeof(TetrisContext));
+  }
+  return index;
+}
+
+// возвращенный контекст обнуляется, как новый контекст из tetris_create
+int tetris_pool_release(TetrisPool_t *pool, TetrisContext *ctx) {
+  int result = 0;
+  if (ctx) {
+    int index = pool_index(pool, ctx);
+    result = index < 0 || !pool->used[index] || pool->count == pool->capacity;
+    if (!result) {
+      memset(ctx, 0, sizeof(TetrisContext));
+      pool->used[index] = false;
+      pool->free[pool->count++] = index;
+    }
+  }
+  return result;
+}
+
+void tetris_pool_destroy(TetrisPool_t *pool) {
+  if (pool) {
+    free(pool->contexts);
+    free(pool->free);
+    free(pool->used);
+    free(pool);
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef H_FILE_POOL
+#define H_FILE_POOL
+
+#include "common.h"
+
+/**
+ * @brief A fixed set of game contexts allocated at once.
+ *
+ * A pool is meant for programs that play many games one after another or at
+ * the same time (simulations): all its contexts live in one block of memory
+ * that is allocated by `tetris_pool_create`, and taking or returning a context
+ * never calls the allocator.
+ */
+typedef struct TetrisPool TetrisPool_t;
+
+/**
+ * @brief Creates a pool of game contexts.
+ *
+ * @param capacity  The number of contexts in the pool.
+ *
+ * @return A pointer to the new pool or `NULL` if `capacity` is not positive
+ * or there is not enough memory. The pool must be released with
+ * `tetris_pool_destroy`.
+ */
+TetrisPool_t *tetris_pool_create(int capacity);
+
+/**
+ * @brief Takes a free context from a pool.
+ *
+ * The context is in the same state as a context returned by `tetris_create`.
+ *
+ * @param pool  The pool.
+ *
+ * @return A pointer to the context or `NULL` if all the contexts are in use.
+ */
+TetrisContext *tetris_pool_acquire(TetrisPool_t *pool);
+
+/**
+ * @brief Returns a context to its pool.
+ *
+ * The game of the context, finished or not, is discarded. A context that does
+ * not belong to the pool or is already free is left as it is.
+ *
+ * @param pool  The pool the context was taken from.
+ * @param ctx   The context; `NULL` does nothing.
+ *
+ * @return 0 on success, 1 if the context is not taken from this pool.
+ */
+int tetris_pool_release(TetrisPool_t *pool, TetrisContext *ctx);
+
+/**
+ * @brief Releases a pool together with all its contexts.
+ *
+ * @param pool  The pool; `NULL` does nothing.
+ */
+void tetris_pool_destroy(TetrisPool_t *pool);
+
+#endif
@@ -0,0 +1,256 @@
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "backend.h"
+
+#define REPLAY_HEADER_SIZE 20
+#define REPLAY_ACTION_BITS 3
+#define REPLAY_MAX_EVENT 10
+
+/**
+ * @brief A recorded game.
+ *
+ * @var seed        The seed of the figures.
+ * @var randomizer  The way the figures are chosen.
+ * @var data        The encoded events.
+ * @var size        The number of bytes in `data`.
+ * @var capacity    The allocated size of `data`.
+ * @var count       The number of events.
+ * @var time        The time of the last event (ms).
+ * @var delta       The time between the last two events (ms).
+ * @var failed      `true` if an event could not be added.
+ */
+struct Replay {
+  unsigned long long seed;
+  Randomizer_t randomizer;
+  unsigned char *data;
+  size_t size;
+  size_t capacity;
+  uint32_t count;
+  unsigned long long time;
+  unsigned long long delta;
+  bool failed;
+};
+
+Replay_t *replay_create(unsigned long long seed, Randomizer_t randomizer) {
+  Replay_t *replay = (Replay_t *)calloc(1, sizeof(Replay_t));
+  if (replay) {
+    replay->seed = seed;
+    replay->randomizer = randomizer;
+  }
+  return replay;
+}
+
+void replay_destroy(Replay_t *replay) {
+  if (replay) {
+    free(replay->data);
+    free(replay);
+  }
+}
+
+// место еще для одного события, буфер растет вдвое
+static bool reserve(Replay_t *replay) {
+  bool flag = replay->size + REPLAY_MAX_EVENT <= replay->capacity;
+  if (!flag) {
+    size_t capacity = replay->capacity ? replay->capacity * 2 : 256;
+    unsigned char *data = (unsigned char *)realloc(replay->data, capacity);
+    if (data) {
+      replay->data = data, replay->capacity = capacity;
+      flag = true;
+    }
+  }
+  return flag;
+}
+
+int replay_add(Replay_t *replay, unsigned long long time, UserAction_t action) {
+  bool flag = !replay->failed && time >= replay->time &&
+              replay->count < UINT32_MAX && reserve(replay);
+  if (flag) {
+    uint64_t delta = time - replay->time;
+    // разность промежутков в зигзаг-кодировании: 0, -1, 1, -2, ...
+    uint64_t change = delta >= replay->delta
+                          ? (delta - replay->delta) << 1
+                          : ((replay->delta - delta) << 1) - 1;
+    uint64_t value = change << REPLAY_ACTION_BITS |
+                     ((uint64_t)action & ((1u << REPLAY_ACTION_BITS) - 1));
+    while (value >= 0x80) {
+      replay->data[replay->size++] = (unsigned char)(value | 0x80);
+      value >>= 7;
+    }
+    replay->data[replay->size++] = (unsigned char)value;
+    replay->time = time;
+    replay->delta = delta;
+    replay->count++;
+  } else {
+    replay->failed = true;
+  }
+  return !flag;
+}
+
+bool replay_next(const Replay_t *replay, ReplayCursor_t *cursor,
+                 ReplayEvent_t *event) {
+  bool flag = cursor->index < replay->count && cursor->offset < replay->size;
+  if (flag) {
+    uint64_t value = 0;
+    int shift = 0;
+    unsigned char byte = 0x80;
+    while (byte & 0x80 && cursor->offset < replay->size && shift < 64) {
+      byte = replay->data[cursor->offset++];
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      shift += 7;
+    }
+    uint64_t change = value >> REPLAY_ACTION_BITS;
+    cursor->delta = change & 1u ? cursor->delta - (change >> 1) - 1
+                                : cursor->delta + (change >> 1);
+    cursor->time += cursor->delta;
+    cursor->index++;
+    event->time = cursor->time;
+    event->action =
+        (UserAction_t)(value & ((1u << REPLAY_ACTION_BITS) - 1));
+  }
+  return flag;
+}
+
+uint32_t replay_count(const Replay_t *replay) { return replay->count; }
+
+unsigned long long replay_duration(const Replay_t *replay) {
+  return replay->time;
+}
+
+size_t replay_size(const Replay_t *replay) { return replay->size; }
+
+// запись числа в little-endian независимо от порядка байтов машины
+static void put_number(unsigned char *bytes, uint64_t value, int size) {
+  for (int i = 0; i < size; ++i) {
+    bytes[i] = (unsigned char)(value >> (8 * i));
+  }
+}
+
+static uint64_t get_number(const unsigned char *bytes, int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; ++i) {
+    value |= (uint64_t)bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+int replay_save(const Replay_t *replay, const char *path) {
+  int result = replay->failed;
+  FILE *file = result ? NULL : fopen(path, "wb");
+  if (file) {
+    unsigned char header[REPLAY_HEADER_SIZE] = {'T', 'R', 'P', 'L',
+                                                REPLAY_VERSION};
+    header[5] = (unsigned char)replay->randomizer;
+    put_number(header + 8, replay->seed, 8);
+    put_number(header + 16, replay->count, 4);
+    result = fwrite(header, 1, REPLAY_HEADER_SIZE, file) != REPLAY_HEADER_SIZE;
+    if (!result && replay->size) {
+      result = fwrite(replay->data, 1, replay->size, file) != replay->size;
+    }
+    result |= fclose(file) != 0;
+  } else {
+    result = 1;
+  }
+  return result;
+}
+
+// события файла должны разбираться ровно до его конца
+static bool check_events(Replay_t *replay) {
+  ReplayCursor_t cursor = {0};
+  ReplayEvent_t event;
+  while (replay_next(replay, &cursor, &event)) {
+    replay->time = event.time;
+  }
+  return cursor.index == replay->count && cursor.offset == replay->size &&
+         (replay->size == 0 || replay->data[replay->size - 1] < 0x80);
+}
+
+Replay_t *replay_load(const char *path) {
+  Replay_t *replay = NULL;
+  FILE *file = fopen(path, "rb");
+  unsigned char header[REPLAY_HEADER_SIZE];
+  if (file &&
+      fread(header, 1, REPLAY_HEADER_SIZE, file) == REPLAY_HEADER_SIZE &&
+      !memcmp(header, "TRPL", 4) && header[4] == REPLAY_VERSION &&
+      header[5] <= RANDOMIZER_BAG) {
+    replay = replay_create(get_number(header + 8, 8),
+                           (Randomizer_t)header[5]);
+  }
+  if (replay) {
+    replay->count = (uint32_t)get_number(header + 16, 4);
+    unsigned char buffer[4096];
+    size_t read;
+    while (replay && (read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      unsigned char *data = NULL;
+      if (replay->size + read > replay->capacity) {
+        replay->capacity = (replay->size + read) * 2;
+        data = (unsigned char *)realloc(replay->data, replay->capacity);
+        if (data) {
+          replay->data = data;
+        } else {
+          replay_destroy(replay);
+          replay = NULL;
+        }
+      }
+      if (replay) {
+        memcpy(replay->data + replay->size, buffer, read);
+        replay->size += read;
+      }
+    }
+  }
+  if (replay && (ferror(file) || !check_events(replay))) {
+    replay_destroy(replay);
+    replay = NULL;
+  }
+  if (file) {
+    fclose(file);
+  }
+  return replay;
+}
+
+void replay_prepare(const Replay_t *replay, TetrisContext *ctx) {
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_seed(ctx, replay->seed);
+  tetris_set_randomizer(ctx, replay->randomizer);
+}
+
+// действие получено в момент предыдущего шага, затем время идет до шага
+GameInfo_t replay_apply(TetrisContext *ctx, const ReplayEvent_t *event) {
+  tetris_input(ctx, event->action, 0);
+  double now = timer_now(&ctx->timer);
+  if ((double)event->time > now) {
+    tetris_advance_time(ctx, (double)event->time - now);
+  }
+  return tetris_step(ctx);
+}
+
+GameInfo_t replay_play(const Replay_t *replay, TetrisContext *ctx) {
+  ReplayCursor_t cursor = {0};
+  ReplayEvent_t event;
+  GameInfo_t info = ctx->game;
+  replay_prepare(replay, ctx);
+  while (replay_next(replay, &cursor, &event)) {
+    info = replay_apply(ctx, &event);
+  }
+  return info;
+}
+
+void tetris_record(TetrisContext *ctx, Replay_t *replay) {
+  ctx->replay = replay;
+  ctx->input = Up;
+  if (replay) {
+    tetris_set_timer(ctx, ctx->timer.source, ctx->timer.step_ms);
+    tetris_seed(ctx, replay->seed);
+    tetris_set_randomizer(ctx, replay->randomizer);
+  }
+}
+
+// шаг записывается со временем таймера, округленным до миллисекунды
+void replay_record_step(TetrisContext *ctx) {
+  double now = timer_now(&ctx->timer);
+  replay_add(ctx->replay, now > 0 ? (unsigned long long)(now + 0.5) : 0,
+             ctx->input);
+}
@@ -0,0 +1,189 @@
+#ifndef H_FILE_REPLAY
+#define H_FILE_REPLAY
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+/**
+ * @brief The version of the replay file format.
+ */
+#define REPLAY_VERSION 1
+
+/**
+ * @brief A recorded game: the seed of its figures and all its steps.
+ *
+ * Every step of the game is one event: the time of the game timer at the step
+ * and the last action given to the game before it (`Up` if there was none).
+ * A game is a pure function of these events when its timer is not
+ * `TIMER_REAL` and the times are whole milliseconds, so playing the events
+ * on a new context reproduces the game exactly.
+ *
+ * The events are kept in the same compact form as in the file: every event is
+ * one variable-length number (7 bits per byte) holding the change of the time
+ * between events (zigzag-encoded, so small negative changes stay small)
+ * shifted left by 3 bits and the action in the low 3 bits. Steps made at a
+ * steady rate take one byte per event.
+ *
+ * The file starts with a 20-byte header: the magic `TRPL`, the version of the
+ * format, the randomizer, two reserved bytes, the seed (8 bytes) and the
+ * number of events (4 bytes), both little-endian.
+ */
+typedef struct Replay Replay_t;
+
+/**
+ * @brief One recorded step of a game.
+ *
+ * @var time    The time of the game timer at the step (ms).
+ * @var action  The action given to the game before the step.
+ */
+typedef struct {
+  unsigned long long time;
+  UserAction_t action;
+} ReplayEvent_t;
+
+/**
+ * @brief Position of a reader of the events of a replay.
+ *
+ * A zero-initialized cursor points to the first event.
+ *
+ * @var offset  The offset of the next event in the encoded events.
+ * @var index   The number of events already read.
+ * @var time    The time of the last read event (ms).
+ * @var delta   The time between the last two read events (ms).
+ */
+typedef struct {
+  size_t offset;
+  uint32_t index;
+  unsigned long long time;
+  unsigned long long delta;
+} ReplayCursor_t;
+
+/**
+ * @brief Creates an empty replay.
+ *
+ * @param seed        The seed of the figures of the recorded game.
+ * @param randomizer  The way the figures of the game are chosen.
+ *
+ * @return A pointer to the replay or `NULL` if there is not enough memory.
+ * The replay must be released with `replay_destroy`.
+ */
+Replay_t *replay_create(unsigned long long seed, Randomizer_t randomizer);
+
+/**
+ * @brief Releases a replay.
+ *
+ * @param replay  The replay; `NULL` does nothing.
+ */
+void replay_destroy(Replay_t *replay);
+
+/**
+ * @brief Appends a step to a replay.
+ *
+ * @param replay  The replay.
+ * @param time    The time of the step (ms), not less than the time of the
+ * previous step.
+ * @param action  The action given to the game before the step.
+ *
+ * @return 0 on success, 1 if the time goes back or there is not enough memory.
+ * After an error the replay cannot be saved.
+ */
+int replay_add(Replay_t *replay, unsigned long long time, UserAction_t action);
+
+/**
+ * @brief Writes a replay to a file.
+ *
+ * @param replay  The replay.
+ * @param path    The path of the file.
+ *
+ * @return 0 on success, 1 if the file cannot be written or a step was lost.
+ */
+int replay_save(const Replay_t *replay, const char *path);
+
+/**
+ * @brief Reads a replay from a file.
+ *
+ * @param path  The path of the file.
+ *
+ * @return A pointer to the replay or `NULL` if the file cannot be read or is
+ * not a valid replay.
+ */
+Replay_t *replay_load(const char *path);
+
+/**
+ * @brief Reads the next event of a replay.
+ *
+ * @param replay  The replay.
+ * @param cursor  The position of the reader, moved past the event.
+ * @param event   The event.
+ *
+ * @return `false` if there are no more events.
+ */
+bool replay_next(const Replay_t *replay, ReplayCursor_t *cursor,
+                 ReplayEvent_t *event);
+
+/**
+ * @brief Returns the number of events of a replay.
+ */
+uint32_t replay_count(const Replay_t *replay);
+
+/**
+ * @brief Returns the time of the last event of a replay (ms).
+ */
+unsigned long long replay_duration(const Replay_t *replay);
+
+/**
+ * @brief Returns the size of the encoded events of a replay (bytes).
+ */
+size_t replay_size(const Replay_t *replay);
+
+/**
+ * @brief Prepares a context to play a replay.
+ *
+ * The context gets the seed and the randomizer of the replay, a
+ * `TIMER_VIRTUAL` timer and the headless mode. The game of the context must
+ * not be started yet.
+ *
+ * @param replay  The replay.
+ * @param ctx     The context.
+ */
+void replay_prepare(const Replay_t *replay, TetrisContext *ctx);
+
+/**
+ * @brief Plays one event of a replay on a context.
+ *
+ * Gives the action of the event to the game, moves its time to the time of
+ * the event and makes a step.
+ *
+ * @param ctx    The context prepared with `replay_prepare`.
+ * @param event  The event.
+ *
+ * @return The state of the game after the step.
+ */
+GameInfo_t replay_apply(TetrisContext *ctx, const ReplayEvent_t *event);
+
+/**
+ * @brief Plays a whole replay without any delays.
+ *
+ * @param replay  The replay.
+ * @param ctx     A context whose game is not started yet.
+ *
+ * @return The state of the game after the last event.
+ */
+GameInfo_t replay_play(const Replay_t *replay, TetrisContext *ctx);
+
+/**
+ * @brief Starts recording the game of a context.
+ *
+ * The context is seeded with the seed and the randomizer of the replay and
+ * its timer restarts from zero, so it must be called before the game starts.
+ * Every following step of the game is added to the replay; the recording
+ * stops when the game ends. The replay is owned by the caller and must live
+ * until the recording stops or the context is released.
+ *
+ * @param ctx     The context.
+ * @param replay  The replay to fill or `NULL` to stop recording.
+ */
+void tetris_record(TetrisContext *ctx, Replay_t *replay);
+
+#endif
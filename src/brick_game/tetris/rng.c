@@ -0,0 +1,45 @@
+#include "rng.h"
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+void rng_seed(Rng_t *rng, uint64_t seed, uint64_t stream) {
+  rng->state = 0;
+  rng->inc = stream << 1 | 1u;
+  rng_next(rng);
+  rng->state += seed;
+  rng_next(rng);
+}
+
+// PCG-XSH-RR: линейный конгруэнтный генератор с перестановкой бит на выходе
+uint32_t rng_next(Rng_t *rng) {
+  uint64_t old = rng->state;
+  rng->state = old * PCG_MULTIPLIER + rng->inc;
+  uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+  uint32_t rot = (uint32_t)(old >> 59u);
+  return (xorshifted >> rot) | (xorshifted << ((-rot) & 31u));
+}
+
+// значения из неполного последнего диапазона отбрасываются
+uint32_t rng_below(Rng_t *rng, uint32_t bound) {
+  uint32_t threshold = (uint32_t)(-bound) % bound;
+  uint32_t value = rng_next(rng);
+  while (value < threshold) {
+    value = rng_next(rng);
+  }
+  return value % bound;
+}
+
+uint32_t rng_bag(Rng_t *rng, unsigned char *bag, int *size, int count) {
+  if (*size == 0) {
+    for (int i = 0; i < count; ++i) {
+      bag[i] = (unsigned char)i;
+    }
+    for (int i = count - 1; i > 0; --i) {  // Фишер - Йетс
+      int j = (int)rng_below(rng, (uint32_t)i + 1);
+      unsigned char swap = bag[i];
+      bag[i] = bag[j], bag[j] = swap;
+    }
+    *size = count;
+  }
+  return bag[--*size];
+}
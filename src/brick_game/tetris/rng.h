@@ -0,0 +1,78 @@
+#ifndef H_FILE_RNG
+#define H_FILE_RNG
+#include <stdint.h>
+
+/**
+ * @brief The seed of games that were not seeded explicitly.
+ */
+#define RNG_DEFAULT_SEED 1
+
+/**
+ * @brief Ways to choose the next figure.
+ *
+ *   - `RANDOMIZER_UNIFORM`: Every figure is chosen independently with equal
+ * probability (the default).
+ *   - `RANDOMIZER_BAG`: The figures come in shuffled sets of all seven
+ * figures ("7-bag"), so every figure appears once in every seven.
+ */
+typedef enum { RANDOMIZER_UNIFORM, RANDOMIZER_BAG } Randomizer_t;
+
+/**
+ * @brief State of a PCG32 pseudo-random number generator.
+ *
+ * Every game has its own generator, so games running in different threads do
+ * not share any state and the sequence of a game depends only on its seed.
+ *
+ * @var state  The current state.
+ * @var inc    The stream selector (always odd).
+ */
+typedef struct {
+  uint64_t state;
+  uint64_t inc;
+} Rng_t;
+
+/**
+ * @brief Seeds a generator.
+ *
+ * @param rng     The generator.
+ * @param seed    The seed; the same seed always gives the same sequence.
+ * @param stream  The number of the sequence; different streams with the same
+ * seed are independent.
+ */
+void rng_seed(Rng_t *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Returns the next 32-bit number of a generator.
+ *
+ * @param rng The generator.
+ *
+ * @return A uniformly distributed number.
+ */
+uint32_t rng_next(Rng_t *rng);
+
+/**
+ * @brief Returns a number from 0 to `bound - 1` without modulo bias.
+ *
+ * @param rng    The generator.
+ * @param bound  The number of possible values (positive).
+ *
+ * @return A uniformly distributed number less than `bound`.
+ */
+uint32_t rng_below(Rng_t *rng, uint32_t bound);
+
+/**
+ * @brief Takes the next value from a shuffled set of values.
+ *
+ * When the set is empty, all values from 0 to `count - 1` are put into it and
+ * shuffled (Fisher - Yates); then the values are taken from its end.
+ *
+ * @param rng    The generator.
+ * @param bag    The set (at least `count` elements).
+ * @param size   The number of values left in the set (0 for a new set).
+ * @param count  The number of different values (positive, at most 256).
+ *
+ * @return The taken value.
+ */
+uint32_t rng_bag(Rng_t *rng, unsigned char *bag, int *size, int count);
+
+#endif
@@ -0,0 +1,617 @@
+#define _GNU_SOURCE
+#include "server.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "backend.h"
+#include "net.h"
+#include "tune.h"
+
+#define SERVER_EVENTS 64
+#define SERVER_INPUT_SIZE 64
+#define SERVER_OUTPUT_SIZE (4 * SERVER_MAX_MESSAGE)
+#define SERVER_FRAME_FIELDS 35
+#define SERVER_WELCOME_SIZE 13
+#define SERVER_MAX_CATCH_UP 5
+#define CLIENT_TIMEOUT_MS 5000
+
+/**
+ * @brief One client connection and its game.
+ *
+ * @var fd        The socket.
+ * @var ctx       The game.
+ * @var sent      The last frame sent to the client (the base of the next
+ * change).
+ * @var dirty     `true` if a frame is waiting for room in `output`.
+ * @var writing   `true` if the worker waits until the socket can be written.
+ * @var closed    `true` if the connection is closed at the end of the round
+ * of events.
+ * @var index     The position of the connection in its worker.
+ * @var in_size   The number of bytes in `input`.
+ * @var input     The received bytes of an incomplete message.
+ * @var begin     The first byte of `output` not yet written.
+ * @var end       The end of the data in `output`.
+ * @var output    The messages not yet written to the socket.
+ */
+typedef struct {
+  int fd;
+  TetrisContext *ctx;
+  FeedFrame_t sent;
+  bool dirty;
+  bool writing;
+  bool closed;
+  int index;
+  int in_size;
+  unsigned char input[SERVER_INPUT_SIZE];
+  int begin;
+  int end;
+  unsigned char output[SERVER_OUTPUT_SIZE];
+} Connection_t;
+
+typedef struct Worker Worker_t;
+
+/**
+ * @brief The server.
+ *
+ * @var config     The settings.
+ * @var listeners  The Unix and the TCP listening sockets (-1 if not used).
+ * @var bound      The file of the Unix socket.
+ * @var stop       The event that stops the workers.
+ * @var workers    The workers.
+ * @var threads    The number of workers.
+ * @var games      The number of open connections.
+ * @var next_game  The number of the next game.
+ */
+struct Server {
+  ServerConfig_t config;
+  int listeners[2];
+  NetFile_t bound;
+  int stop;
+  Worker_t *workers;
+  int threads;
+  atomic_int games;
+  atomic_uint next_game;
+};
+
+/**
+ * @brief A worker thread with its own epoll, timer and connections.
+ *
+ * @var server       The server.
+ * @var poller       The epoll descriptor.
+ * @var timer        The timer of the steps of the games in real time or -1.
+ * @var connections  The connections of the worker.
+ * @var count        The number of connections.
+ * @var capacity     The size of `connections`.
+ * @var thread       The thread.
+ * @var started      `true` if the thread was started.
+ */
+struct Worker {
+  Server_t *server;
+  int poller;
+  int timer;
+  Connection_t **connections;
+  int count;
+  int capacity;
+  pthread_t thread;
+  bool started;
+};
+
+static void put16(unsigned char *data, uint32_t value) {
+  data[0] = (unsigned char)value, data[1] = (unsigned char)(value >> 8);
+}
+
+static void put32(unsigned char *data, uint32_t value) {
+  put16(data, value), put16(data + 2, value >> 16);
+}
+
+static void put64(unsigned char *data, uint64_t value) {
+  put32(data, (uint32_t)value), put32(data + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t get16(const unsigned char *data) {
+  return (uint32_t)data[0] | (uint32_t)data[1] << 8;
+}
+
+static uint32_t get32(const unsigned char *data) {
+  return get16(data) | get16(data + 2) << 16;
+}
+
+static uint64_t get64(const unsigned char *data) {
+  return (uint64_t)get32(data) | (uint64_t)get32(data + 4) << 32;
+}
+
+static void put_header(unsigned char *data, ServerMessage_t type,
+                       int length) {
+  data[0] = (unsigned char)type, data[1] = 0;
+  put16(data + 2, (uint32_t)length);
+}
+
+// опрос записи включается, только пока в буфере есть данные
+static void watch(Worker_t *worker, Connection_t *connection, bool writing) {
+  if (connection->writing != writing) {
+    struct epoll_event event = {
+        .events = EPOLLIN | (writing ? EPOLLOUT : 0),
+        .data.ptr = connection};
+    epoll_ctl(worker->poller, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->writing = writing;
+  }
+}
+
+static void flush(Worker_t *worker, Connection_t *connection) {
+  long written = 1;
+  while (connection->begin < connection->end && written > 0) {
+    written = net_write(connection->fd, connection->output + connection->begin,
+                        (size_t)(connection->end - connection->begin));
+    connection->begin += written > 0 ? (int)written : 0;
+  }
+  if (written < 0) {
+    connection->closed = true;
+  } else {
+    if (connection->begin == connection->end) {
+      connection->begin = connection->end = 0;
+    }
+    watch(worker, connection, connection->begin < connection->end);
+  }
+}
+
+// место под сообщение; данные буфера сдвигаются в его начало
+static unsigned char *reserve(Connection_t *connection, int size) {
+  unsigned char *place = NULL;
+  if (SERVER_OUTPUT_SIZE - (connection->end - connection->begin) >= size) {
+    if (SERVER_OUTPUT_SIZE - connection->end < size) {
+      memmove(connection->output, connection->output + connection->begin,
+              (size_t)(connection->end - connection->begin));
+      connection->end -= connection->begin, connection->begin = 0;
+    }
+    place = connection->output + connection->end;
+    connection->end += size;
+  }
+  return place;
+}
+
+// изменение картинки с последнего отправленного кадра; если клиент не
+// успевает читать, кадр ждет места в буфере и потом уходит вместе со всеми
+// изменениями, накопившимися к этому времени
+static void send_frame(Worker_t *worker, Connection_t *connection,
+                       bool force) {
+  FeedFrame_t frame;
+  feed_frame(connection->ctx, &frame);
+  const FeedFrame_t *sent = &connection->sent;
+  if (force || connection->dirty ||
+      frame.frame.version != sent->frame.version) {
+    unsigned char *data = reserve(connection, SERVER_MAX_MESSAGE);
+    connection->dirty = data == NULL;
+    if (data) {
+      unsigned char *cells = data + SERVER_HEADER + SERVER_FRAME_FIELDS;
+      int count = 0;
+      for (int i = 0; i < FRAME_SIZE; ++i) {
+        if (frame.frame.cells[i] != sent->frame.cells[i]) {
+          cells[2 * count] = (unsigned char)i;
+          cells[2 * count + 1] = frame.frame.cells[i];
+          count++;
+        }
+      }
+      int length = SERVER_FRAME_FIELDS + 2 * count;
+      unsigned char *fields = data + SERVER_HEADER;
+      put_header(data, SERVER_FRAME, length);
+      put64(fields, frame.frame.version);
+      put32(fields + 8, (uint32_t)frame.score);
+      put32(fields + 12, (uint32_t)frame.high_score);
+      put32(fields + 16, (uint32_t)frame.level);
+      put32(fields + 20, (uint32_t)frame.speed);
+      put32(fields + 24, (uint32_t)frame.pieces);
+      put32(fields + 28, (uint32_t)frame.lines);
+      fields[32] = (unsigned char)frame.state;
+      fields[33] = (unsigned char)frame.next_figure;
+      fields[34] = (unsigned char)count;
+      connection->end -= SERVER_MAX_MESSAGE - (SERVER_HEADER + length);
+      connection->sent = frame;
+      flush(worker, connection);
+    } else {
+      watch(worker, connection, true);
+    }
+  }
+}
+
+static void close_connection(Worker_t *worker, Connection_t *connection) {
+  epoll_ctl(worker->poller, EPOLL_CTL_DEL, connection->fd, NULL);
+  net_close(connection->fd);
+  tetris_destroy(connection->ctx);
+  Connection_t *last = worker->connections[--worker->count];
+  worker->connections[connection->index] = last;
+  last->index = connection->index;
+  atomic_fetch_sub(&worker->server->games, 1);
+  free(connection);
+}
+
+static bool add_connection(Worker_t *worker, Connection_t *connection) {
+  bool flag = true;
+  if (worker->count == worker->capacity) {
+    int capacity = worker->capacity ? worker->capacity * 2 : 16;
+    Connection_t **connections = (Connection_t **)realloc(
+        worker->connections, (size_t)capacity * sizeof(Connection_t *));
+    flag = connections != NULL;
+    if (flag) {
+      worker->connections = connections, worker->capacity = capacity;
+    }
+  }
+  if (flag) {
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = connection};
+    flag = epoll_ctl(worker->poller, EPOLL_CTL_ADD, connection->fd,
+                     &event) == 0;
+  }
+  if (flag) {
+    connection->index = worker->count;
+    worker->connections[worker->count++] = connection;
+  }
+  return flag;
+}
+
+// новая игра: своя у каждого соединения, без файла рекордов
+static void open_connection(Worker_t *worker, int fd) {
+  Server_t *server = worker->server;
+  const ServerConfig_t *config = &server->config;
+  Connection_t *connection = NULL;
+  if (atomic_fetch_add(&server->games, 1) < config->max_clients) {
+    connection = (Connection_t *)calloc(1, sizeof(Connection_t));
+  }
+  if (connection) {
+    connection->fd = fd;
+    connection->ctx = tetris_create();
+  }
+  if (connection && connection->ctx && add_connection(worker, connection)) {
+    uint32_t game = atomic_fetch_add(&server->next_game, 1);
+    unsigned long long seed = config->seed + game;
+    TetrisContext *ctx = connection->ctx;
+    ctx->headless = true;
+    tetris_seed(ctx, seed);
+    tetris_set_randomizer(ctx, config->randomizer);
+    tetris_set_timer(ctx, TIMER_FIXED_STEP, config->step_ms);
+    unsigned char *data = reserve(connection, SERVER_HEADER +
+                                                  SERVER_WELCOME_SIZE);
+    put_header(data, SERVER_WELCOME, SERVER_WELCOME_SIZE);
+    data[SERVER_HEADER] = SERVER_PROTOCOL;
+    put32(data + SERVER_HEADER + 1, game);
+    put64(data + SERVER_HEADER + 5, seed);
+    flush(worker, connection);
+  } else {
+    if (connection) {
+      tetris_destroy(connection->ctx);
+      free(connection);
+    }
+    net_close(fd);
+    atomic_fetch_sub(&server->games, 1);
+  }
+}
+
+// ввод применяется к игре: в режиме lockstep сразу делается шаг и
+// отправляется кадр, иначе действие ждет ближайшего шага по таймеру
+static void apply_input(Worker_t *worker, Connection_t *connection,
+                        UserAction_t action) {
+  tetris_input(connection->ctx, action, 0);
+  if (worker->server->config.lockstep) {
+    tetris_step(connection->ctx);
+    send_frame(worker, connection, true);
+  }
+}
+
+// за одно событие читается один буфер, чтобы клиент, засыпающий сервер
+// вводом, не задерживал остальных
+static void receive(Worker_t *worker, Connection_t *connection) {
+  long count = net_read(connection->fd, connection->input + connection->in_size,
+                        (size_t)(SERVER_INPUT_SIZE - connection->in_size));
+  connection->closed = count < 0;
+  connection->in_size += count > 0 ? (int)count : 0;
+  const unsigned char *data = connection->input;
+  int offset = 0;
+  while (!connection->closed &&
+         connection->in_size - offset >= SERVER_HEADER + 1) {
+    const unsigned char *message = data + offset;
+    connection->closed = message[0] != SERVER_INPUT || message[1] != 0 ||
+                         get16(message + 2) != 1 ||
+                         message[SERVER_HEADER] > Action;
+    if (!connection->closed) {
+      apply_input(worker, connection,
+                  (UserAction_t)message[SERVER_HEADER]);
+      offset += SERVER_HEADER + 1;
+    }
+  }
+  connection->in_size -= offset;
+  memmove(connection->input, data + offset, (size_t)connection->in_size);
+}
+
+// шаги всех начатых игр работника по таймеру; пропущенные такты
+// догоняются, но не больше SERVER_MAX_CATCH_UP за раз
+static void tick(Worker_t *worker) {
+  uint64_t ticks = 0;
+  if (net_read(worker->timer, &ticks, sizeof(ticks)) > 0) {
+    int steps = ticks < SERVER_MAX_CATCH_UP ? (int)ticks : SERVER_MAX_CATCH_UP;
+    for (int i = 0; i < worker->count; ++i) {
+      Connection_t *connection = worker->connections[i];
+      for (int s = 0; s < steps && connection->ctx->initialized; ++s) {
+        tetris_step(connection->ctx);
+      }
+      if (!connection->closed) {
+        send_frame(worker, connection, false);
+      }
+    }
+  }
+}
+
+static void handle(Worker_t *worker, const struct epoll_event *event,
+                   bool *running) {
+  Server_t *server = worker->server;
+  void *source = event->data.ptr;
+  if (source == &server->stop) {
+    *running = false;
+  } else if (source == &worker->timer) {
+    tick(worker);
+  } else if (source == &server->listeners[0] ||
+             source == &server->listeners[1]) {
+    int fd;
+    while ((fd = net_accept(*(int *)source)) >= 0) {
+      open_connection(worker, fd);
+    }
+  } else {
+    Connection_t *connection = (Connection_t *)source;
+    if (!connection->closed && event->events & (EPOLLIN | EPOLLHUP)) {
+      receive(worker, connection);
+    }
+    if (!connection->closed && event->events & EPOLLERR) {
+      connection->closed = true;
+    }
+    if (!connection->closed && event->events & EPOLLOUT) {
+      flush(worker, connection);
+      if (!connection->closed && connection->dirty) {
+        send_frame(worker, connection, true);
+      }
+    }
+  }
+}
+
+// соединения закрываются после обработки всех событий, чтобы события того
+// же опроса не указывали на освобожденную память
+static void *work(void *arg) {
+  Worker_t *worker = (Worker_t *)arg;
+  struct epoll_event events[SERVER_EVENTS];
+  bool running = true;
+  while (running) {
+    int count = epoll_wait(worker->poller, events, SERVER_EVENTS, -1);
+    running = count >= 0 || errno == EINTR;
+    for (int i = 0; i < count; ++i) {
+      handle(worker, &events[i], &running);
+    }
+    for (int i = worker->count - 1; i >= 0; --i) {
+      if (worker->connections[i]->closed) {
+        close_connection(worker, worker->connections[i]);
+      }
+    }
+  }
+  return NULL;
+}
+
+static bool watch_source(int poller, int fd, uint32_t events, void *source) {
+  struct epoll_event event = {.events = events, .data.ptr = source};
+  return epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+// опрос работника: общий сигнал остановки, слушающие сокеты (соединение
+// получает только один из ждущих работников) и таймер шагов
+static bool init_worker(Server_t *server, Worker_t *worker) {
+  worker->server = server;
+  worker->timer = -1;
+  worker->poller = epoll_create1(EPOLL_CLOEXEC);
+  bool flag = worker->poller >= 0 &&
+              watch_source(worker->poller, server->stop, EPOLLIN,
+                           &server->stop);
+  for (int i = 0; i < 2 && flag; ++i) {
+    if (server->listeners[i] >= 0) {
+      flag = watch_source(worker->poller, server->listeners[i],
+                          EPOLLIN | EPOLLEXCLUSIVE, &server->listeners[i]);
+    }
+  }
+  if (flag && !server->config.lockstep) {
+    long long ns = (long long)(server->config.step_ms * 1e6);
+    struct itimerspec period = {
+        .it_interval = {.tv_sec = ns / 1000000000, .tv_nsec = ns % 1000000000}};
+    period.it_value = period.it_interval;
+    worker->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    flag = worker->timer >= 0 &&
+           !timerfd_settime(worker->timer, 0, &period, NULL) &&
+           watch_source(worker->poller, worker->timer, EPOLLIN, &worker->timer);
+  }
+  return flag;
+}
+
+Server_t *server_start(const ServerConfig_t *config) {
+  Server_t *server = NULL;
+  if ((config->path || config->port >= 0) && config->threads >= 0 &&
+      config->max_clients > 0 && config->step_ms >= 1e-3) {
+    server = (Server_t *)calloc(1, sizeof(Server_t));
+  }
+  bool flag = server != NULL;
+  if (flag) {
+    server->config = *config;
+    server->listeners[0] = server->listeners[1] = -1;
+    server->stop = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    atomic_init(&server->games, 0);
+    atomic_init(&server->next_game, 0);
+    if (config->path) {
+      server->listeners[0] = net_listen_unix(config->path, &server->bound);
+    }
+    if (config->port >= 0) {
+      server->listeners[1] = net_listen_tcp(config->port);
+    }
+    flag = server->stop >= 0 && (!config->path || server->listeners[0] >= 0) &&
+           (config->port < 0 || server->listeners[1] >= 0);
+  }
+  if (flag) {
+    server->threads = config->threads ? config->threads : tune_processors();
+    server->workers =
+        (Worker_t *)calloc((size_t)server->threads, sizeof(Worker_t));
+    flag = server->workers != NULL;
+    for (int i = 0; flag && i < server->threads; ++i) {
+      flag = init_worker(server, &server->workers[i]);
+    }
+    for (int i = 0; flag && i < server->threads; ++i) {
+      Worker_t *worker = &server->workers[i];
+      worker->started =
+          pthread_create(&worker->thread, NULL, work, worker) == 0;
+      flag = worker->started;
+    }
+  }
+  if (!flag && server) {
+    server_stop(server);
+    server = NULL;
+  }
+  return server;
+}
+
+void server_stop(Server_t *server) {
+  if (server) {
+    if (server->stop >= 0) {
+      eventfd_write(server->stop, 1);
+    }
+    for (int i = 0; server->workers && i < server->threads; ++i) {
+      Worker_t *worker = &server->workers[i];
+      if (worker->started) {
+        pthread_join(worker->thread, NULL);
+      }
+      while (worker->count > 0) {
+        close_connection(worker, worker->connections[0]);
+      }
+      free(worker->connections);
+      if (worker->server) {  // работник был подготовлен init_worker
+        net_close(worker->timer);
+        net_close(worker->poller);
+      }
+    }
+    free(server->workers);
+    net_close(server->listeners[0]);
+    net_close(server->listeners[1]);
+    if (server->listeners[0] >= 0) {
+      net_unlink_unix(server->config.path, &server->bound);
+    }
+    net_close(server->stop);
+    free(server);
+  }
+}
+
+int server_port(const Server_t *server) {
+  return server->listeners[1] >= 0 ? net_local_port(server->listeners[1])
+                                   : -1;
+}
+
+int server_games(const Server_t *server) {
+  return atomic_load(&((Server_t *)server)->games);
+}
+
+// клиент ждет приветствия сервера: переполненный сервер сразу закрывает
+// соединение
+static int client_welcome(ServerClient_t *client) {
+  int result = client->fd < 0;
+  if (!result) {
+    result = client_receive(client, CLIENT_TIMEOUT_MS) != SERVER_WELCOME;
+  }
+  if (result) {
+    client_close(client);
+  }
+  return result;
+}
+
+int client_connect_unix(ServerClient_t *client, const char *path) {
+  memset(client, 0, sizeof(ServerClient_t));
+  client->fd = net_connect_unix(path);
+  return client_welcome(client);
+}
+
+int client_connect_tcp(ServerClient_t *client, int port) {
+  memset(client, 0, sizeof(ServerClient_t));
+  client->fd = net_connect_tcp(port);
+  return client_welcome(client);
+}
+
+int client_send(ServerClient_t *client, UserAction_t action) {
+  unsigned char data[SERVER_HEADER + 1];
+  put_header(data, SERVER_INPUT, 1);
+  data[SERVER_HEADER] = (unsigned char)action;
+  int size = 0;
+  long written = 1;
+  while (size < (int)sizeof(data) && written > 0) {
+    written = net_write(client->fd, data + size, sizeof(data) - size);
+    size += written > 0 ? (int)written : 0;
+  }
+  return size != (int)sizeof(data);
+}
+
+// разбор одного сообщения из начала буфера: 0 - сообщение еще не пришло
+// целиком, -1 - сообщение неверно
+static int decode(ServerClient_t *client) {
+  const unsigned char *data = client->data;
+  int result = 0, length = client->size >= SERVER_HEADER ? (int)get16(data + 2)
+                                                         : 0;
+  if (client->size >= SERVER_HEADER &&
+      (data[1] != 0 || SERVER_HEADER + length > SERVER_MAX_MESSAGE)) {
+    result = -1;
+  } else if (client->size >= SERVER_HEADER &&
+             client->size >= SERVER_HEADER + length) {
+    const unsigned char *payload = data + SERVER_HEADER;
+    result = data[0];
+    if (data[0] == SERVER_WELCOME && length == SERVER_WELCOME_SIZE &&
+        payload[0] == SERVER_PROTOCOL) {
+      client->game = get32(payload + 1);
+      client->seed = get64(payload + 5);
+    } else if (data[0] == SERVER_FRAME && length >= SERVER_FRAME_FIELDS &&
+               length == SERVER_FRAME_FIELDS + 2 * payload[34]) {
+      FeedFrame_t *frame = &client->frame;
+      const unsigned char *cells = payload + SERVER_FRAME_FIELDS;
+      for (int i = 0; i < payload[34] && result > 0; ++i) {
+        if (cells[2 * i] < FRAME_SIZE) {
+          frame->frame.cells[cells[2 * i]] = cells[2 * i + 1];
+        } else {
+          result = -1;
+        }
+      }
+      frame->frame.version = (unsigned long)get64(payload);
+      frame->score = (int)get32(payload + 8);
+      frame->high_score = (int)get32(payload + 12);
+      frame->level = (int)get32(payload + 16);
+      frame->speed = (int)get32(payload + 20);
+      frame->pieces = (int)get32(payload + 24);
+      frame->lines = (int)get32(payload + 28);
+      frame->state = payload[32];
+      frame->next_figure = payload[33];
+      frame->sequence = client->frames++;
+    } else {
+      result = -1;
+    }
+    client->size -= SERVER_HEADER + length;
+    memmove(client->data, data + SERVER_HEADER + length,
+            (size_t)client->size);
+  }
+  return result;
+}
+
+int client_receive(ServerClient_t *client, int timeout_ms) {
+  int result = decode(client);
+  while (result == 0 && net_wait(client->fd, timeout_ms)) {
+    long count = net_read(client->fd, client->data + client->size,
+                          sizeof(client->data) - (size_t)client->size);
+    client->size += count > 0 ? (int)count : 0;
+    result = count < 0 ? -1 : decode(client);
+  }
+  return result;
+}
+
+void client_close(ServerClient_t *client) {
+  net_close(client->fd);
+  client->fd = -1;
+}
@@ -0,0 +1,188 @@
+#ifndef H_FILE_SERVER
+#define H_FILE_SERVER
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "feed.h"
+
+/**
+ * @brief The version of the protocol, sent in `SERVER_WELCOME`.
+ */
+#define SERVER_PROTOCOL 1
+
+/**
+ * @brief The size of the header of every message (bytes).
+ */
+#define SERVER_HEADER 4
+
+/**
+ * @brief The largest message of the protocol (bytes): a frame in which every
+ * cell has changed.
+ */
+#define SERVER_MAX_MESSAGE (SERVER_HEADER + 35 + 2 * FRAME_SIZE)
+
+/**
+ * @brief The types of the messages.
+ *
+ * Every message is a 4-byte header (the type, a zero byte and the length of
+ * the payload as 16-bit little-endian) followed by the payload. All numbers
+ * are little-endian.
+ *   - `SERVER_WELCOME` (server): the protocol version (1 byte), the number of
+ * the game (4 bytes) and the seed of its figures (8 bytes), sent once after
+ * the connection is accepted.
+ *   - `SERVER_INPUT` (client): one `UserAction_t` (1 byte).
+ *   - `SERVER_FRAME` (server): the change of the picture since the previous
+ * frame sent to the client: `tetris_version` (8 bytes), the score, the high
+ * score, the level, the speed, the fixed figures and the removed lines
+ * (4 bytes each), the state and the next figure (1 byte each), the number of
+ * changed cells (1 byte) and, for every changed cell, its index in
+ * `Frame_t::cells` and its new value (1 byte each). The first frame is
+ * compared with an empty field.
+ */
+typedef enum {
+  SERVER_WELCOME = 1,
+  SERVER_INPUT = 2,
+  SERVER_FRAME = 3,
+} ServerMessage_t;
+
+/**
+ * @brief Settings of a game server.
+ *
+ * @var path         The path of the Unix domain socket or `NULL`; a socket
+ * left at the path by a server that is gone is replaced, but a running
+ * server or any other file at the path makes the start fail.
+ * @var port         The TCP port on the loopback interface: 0 chooses a
+ * free port (see `server_port`), -1 does not listen on TCP.
+ * @var threads      The number of worker threads (0 uses one per processor).
+ * @var max_clients  The largest number of games at once; further connections
+ * are closed at once.
+ * @var step_ms      The time of one step of the games (ms).
+ * @var lockstep     `false`: the games run in real time, one step every
+ * `step_ms`, and the inputs are applied at the next step. `true`: every input
+ * makes one step of its game at once and is always answered with a frame, so
+ * a game is a pure function of its inputs (for bots and tests).
+ * @var seed         Game `n` is seeded with `seed + n`.
+ * @var randomizer   The way the figures are chosen.
+ */
+typedef struct {
+  const char *path;
+  int port;
+  int threads;
+  int max_clients;
+  double step_ms;
+  bool lockstep;
+  unsigned long long seed;
+  Randomizer_t randomizer;
+} ServerConfig_t;
+
+/**
+ * @brief A running game server.
+ *
+ * Every client that connects gets its own headless game with the rules of
+ * the engine. The connections are spread over a small pool of worker
+ * threads; every worker waits for its sockets and its timer with epoll and
+ * owns the games of its connections, so games are never shared between
+ * threads. The server never waits for a client: the frames of a client that
+ * reads too slowly are merged, so it gets the latest picture later.
+ */
+typedef struct Server Server_t;
+
+/**
+ * @brief One client of a game server.
+ *
+ * @var fd      The socket.
+ * @var game    The number of the game (from `SERVER_WELCOME`).
+ * @var seed    The seed of the game (from `SERVER_WELCOME`).
+ * @var frame   The picture built from the received frames; `sequence` is the
+ * number of the last frame, starting from 0.
+ * @var frames  The number of frames received.
+ * @var size    The number of bytes in `data`.
+ * @var data    The received bytes not yet decoded.
+ */
+typedef struct {
+  int fd;
+  uint32_t game;
+  unsigned long long seed;
+  FeedFrame_t frame;
+  uint64_t frames;
+  int size;
+  unsigned char data[SERVER_MAX_MESSAGE];
+} ServerClient_t;
+
+/**
+ * @brief Starts a game server.
+ *
+ * @param config  The settings; `path` must stay valid until `server_stop`.
+ *
+ * @return A pointer to the server or `NULL` if the settings are invalid,
+ * no socket could be opened or there is not enough memory. The server must
+ * be stopped with `server_stop`.
+ */
+Server_t *server_start(const ServerConfig_t *config);
+
+/**
+ * @brief Stops a game server: closes all connections, waits for the workers
+ * and releases the server.
+ *
+ * The Unix socket file is removed only if it is still the one the server
+ * bound, so stopping never takes the path from another server.
+ *
+ * @param server  The server; `NULL` does nothing.
+ */
+void server_stop(Server_t *server);
+
+/**
+ * @brief Returns the TCP port of a server or -1 if it does not listen on TCP.
+ */
+int server_port(const Server_t *server);
+
+/**
+ * @brief Returns the number of games being played on a server.
+ */
+int server_games(const Server_t *server);
+
+/**
+ * @brief Connects to a server over its Unix domain socket.
+ *
+ * @param client  The client to set up.
+ * @param path    The path of the socket.
+ *
+ * @return 0 on success, 1 on error.
+ */
+int client_connect_unix(ServerClient_t *client, const char *path);
+
+/**
+ * @brief Connects to a server over TCP on the loopback interface.
+ *
+ * @param client  The client to set up.
+ * @param port    The port.
+ *
+ * @return 0 on success, 1 on error.
+ */
+int client_connect_tcp(ServerClient_t *client, int port);
+
+/**
+ * @brief Sends an input to the game of a client.
+ *
+ * @return 0 on success, 1 on error.
+ */
+int client_send(ServerClient_t *client, UserAction_t action);
+
+/**
+ * @brief Receives the next message and applies it to the client.
+ *
+ * @param client      The client.
+ * @param timeout_ms  The longest wait (ms), -1 waits forever.
+ *
+ * @return The type of the message, 0 on timeout or -1 if the connection is
+ * closed or the message is invalid.
+ */
+int client_receive(ServerClient_t *client, int timeout_ms);
+
+/**
+ * @brief Closes the connection of a client.
+ */
+void client_close(ServerClient_t *client);
+
+#endif
@@ -0,0 +1,82 @@
+#include "shapes.h"
+
+// все значения таблицы вычисляются компилятором из базовых координат фигур
+#define MIN2(a, b) ((a) < (b) ? (a) : (b))
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+#define MIN4(a, b, c, d) MIN2(MIN2(a, b), MIN2(c, d))
+#define MAX4(a, b, c, d) MAX2(MAX2(a, b), MAX2(c, d))
+
+#define ROW_BIT(r, pr, pc) ((pr) == (r) ? (1u << (pc)) : 0u)
+#define ROW_MASK(r, r0, c0, r1, c1, r2, c2, r3, c3)            \
+  (uint16_t)(ROW_BIT(r, r0, c0) | ROW_BIT(r, r1, c1) |         \
+             ROW_BIT(r, r2, c2) | ROW_BIT(r, r3, c3))
+
+#define LOW(c, pr, pc) ((pc) == (c) ? (pr) : -128)
+#define HIGH(c, pr, pc) ((pc) == (c) ? (pr) : 127)
+#define BOTTOM(c, r0, c0, r1, c1, r2, c2, r3, c3) \
+  MAX4(LOW(c, r0, c0), LOW(c, r1, c1), LOW(c, r2, c2), LOW(c, r3, c3))
+#define TOP(c, r0, c0, r1, c1, r2, c2, r3, c3) \
+  MIN4(HIGH(c, r0, c0), HIGH(c, r1, c1), HIGH(c, r2, c2), HIGH(c, r3, c3))
+
+#define SHAPE(...)                                                        \
+  {{{P0R(__VA_ARGS__), P0C(__VA_ARGS__)},                                 \
+    {P1R(__VA_ARGS__), P1C(__VA_ARGS__)},                                 \
+    {P2R(__VA_ARGS__), P2C(__VA_ARGS__)},                                 \
+    {P3R(__VA_ARGS__), P3C(__VA_ARGS__)}},                                \
+   MINR(__VA_ARGS__),                                                     \
+   MAXR(__VA_ARGS__),                                                     \
+   MINC(__VA_ARGS__),                                                     \
+   MAXC(__VA_ARGS__),                                                     \
+   {ROW_MASK(MINR(__VA_ARGS__) + 0, __VA_ARGS__),                         \
+    ROW_MASK(MINR(__VA_ARGS__) + 1, __VA_ARGS__),                         \
+    ROW_MASK(MINR(__VA_ARGS__) + 2, __VA_ARGS__),                         \
+    ROW_MASK(MINR(__VA_ARGS__) + 3, __VA_ARGS__)},                        \
+   {BOTTOM(MINC(__VA_ARGS__) + 0, __VA_ARGS__),                           \
+    BOTTOM(MINC(__VA_ARGS__) + 1, __VA_ARGS__),                           \
+    BOTTOM(MINC(__VA_ARGS__) + 2, __VA_ARGS__),                           \
+    BOTTOM(MINC(__VA_ARGS__) + 3, __VA_ARGS__)},                          \
+   {TOP(MINC(__VA_ARGS__) + 0, __VA_ARGS__),                              \
+    TOP(MINC(__VA_ARGS__) + 1, __VA_ARGS__),                              \
+    TOP(MINC(__VA_ARGS__) + 2, __VA_ARGS__),                              \
+    TOP(MINC(__VA_ARGS__) + 3, __VA_ARGS__)}}
+
+#define P0R(r0, c0, r1, c1, r2, c2, r3, c3) r0
+#define P0C(r0, c0, r1, c1, r2, c2, r3, c3) c0
+#define P1R(r0, c0, r1, c1, r2, c2, r3, c3) r1
+#define P1C(r0, c0, r1, c1, r2, c2, r3, c3) c1
+#define P2R(r0, c0, r1, c1, r2, c2, r3, c3) r2
+#define P2C(r0, c0, r1, c1, r2, c2, r3, c3) c2
+#define P3R(r0, c0, r1, c1, r2, c2, r3, c3) r3
+#define P3C(r0, c0, r1, c1, r2, c2, r3, c3) c3
+#define MINR(r0, c0, r1, c1, r2, c2, r3, c3) MIN4(r0, r1, r2, r3)
+#define MAXR(r0, c0, r1, c1, r2, c2, r3, c3) MAX4(r0, r1, r2, r3)
+#define MINC(r0, c0, r1, c1, r2, c2, r3, c3) MIN4(c0, c1, c2, c3)
+#define MAXC(r0, c0, r1, c1, r2, c2, r3, c3) MAX4(c0, c1, c2, c3)
+
+// базовые положения фигур во всех поворотах
+static const Shape_t shapes[COUNT_OF_FIGURES][COUNT_OF_ROTATIONS] = {
+    {SHAPE(0, 3, 0, 4, 0, 5, 0, 6), SHAPE(-1, 5, 0, 5, 1, 5, 2, 5),
+     SHAPE(1, 3, 1, 4, 1, 5, 1, 6), SHAPE(-1, 4, 0, 4, 1, 4, 2, 4)},  // I
+    {SHAPE(0, 4, 1, 4, 2, 4, 2, 5), SHAPE(2, 3, 1, 3, 1, 4, 1, 5),
+     SHAPE(0, 3, 0, 4, 1, 4, 2, 4), SHAPE(1, 3, 1, 4, 1, 5, 0, 5)},  // L
+    {SHAPE(0, 4, 1, 4, 2, 4, 2, 3), SHAPE(0, 3, 1, 3, 1, 4, 1, 5),
+     SHAPE(0, 5, 0, 4, 1, 4, 2, 4), SHAPE(1, 3, 1, 4, 1, 5, 2, 5)},  // J
+    {SHAPE(0, 4, 1, 4, 0, 5, 1, 5), SHAPE(0, 4, 1, 4, 0, 5, 1, 5),
+     SHAPE(0, 4, 1, 4, 0, 5, 1, 5), SHAPE(0, 4, 1, 4, 0, 5, 1, 5)},  // O
+    {SHAPE(1, 3, 1, 4, 0, 4, 0, 5), SHAPE(0, 4, 1, 4, 1, 5, 2, 5),
+     SHAPE(2, 3, 2, 4, 1, 4, 1, 5), SHAPE(0, 3, 1, 3, 1, 4, 2, 4)},  // S
+    {SHAPE(0, 3, 0, 4, 1, 4, 1, 5), SHAPE(0, 5, 1, 5, 1, 4, 2, 4),
+     SHAPE(1, 3, 1, 4, 2, 4, 2, 5), SHAPE(0, 4, 1, 4, 1, 3, 2, 3)},  // Z
+    {SHAPE(0, 4, 1, 4, 1, 3, 1, 5), SHAPE(0, 4, 1, 4, 2, 4, 1, 5),
+     SHAPE(1, 3, 1, 4, 1, 5, 2, 4), SHAPE(0, 4, 1, 4, 2, 4, 1, 3)}  // T
+};
+
+const Shape_t *shape_get(int figure, int rotation) {
+  return &shapes[figure][rotation];
+}
+
+// маска ряда фигуры, сдвинутой по горизонтали на y
+uint16_t shape_row_mask(const Shape_t *shape, int row, int y) {
+  return y >= 0 ? (uint16_t)(shape->rows[row] << y)
+                : (uint16_t)(shape->rows[row] >> -y);
+}
@@ -0,0 +1,67 @@
+#ifndef H_FILE_SHAPES
+#define H_FILE_SHAPES
+#include <stdint.h>
+
+#include "./../../tetris.h"
+
+/**
+ * @brief The maximum number of rows (and columns) a figure can occupy.
+ */
+#define SHAPE_SIZE 4
+
+/**
+ * @brief Precomputed description of one figure in one rotation.
+ *
+ * All the values of the `Shape_t` structure are built at compile time from
+ * the base coordinates of the figures, so the table is read-only and is never
+ * rebuilt during the game. Row offsets (`x`) grow downwards, column offsets
+ * (`y`) are absolute columns of the field when the figure has a zero
+ * horizontal displacement.
+ *
+ * @var cells    Coordinates (row, column) of the four parts of the figure.
+ * @var min_row  The smallest row offset of the figure (bounding box).
+ * @var max_row  The largest row offset of the figure (bounding box).
+ * @var min_col  The smallest column of the figure (bounding box).
+ * @var max_col  The largest column of the figure (bounding box).
+ * @var rows     Column masks of rows `min_row` .. `max_row` in the format of
+ * `Board_t::rows`. Masks past `max_row` are zero.
+ * @var bottom   For every column `min_col + k`, the largest row offset
+ * occupied in that column (used to find the landing row).
+ * @var top      For every column `min_col + k`, the smallest row offset
+ * occupied in that column (used to compute column heights).
+ */
+typedef struct {
+  signed char cells[FIGURE_PART][2];
+  signed char min_row;
+  signed char max_row;
+  signed char min_col;
+  signed char max_col;
+  uint16_t rows[SHAPE_SIZE];
+  signed char bottom[SHAPE_SIZE];
+  signed char top[SHAPE_SIZE];
+} Shape_t;
+
+/**
+ * @brief Returns the precomputed description of a figure.
+ *
+ * @param figure    The type of figure (0 to `COUNT_OF_FIGURES - 1`).
+ * @param rotation  The rotation of the figure (0 to `COUNT_OF_ROTATIONS - 1`).
+ *
+ * @return A pointer to the constant `Shape_t` entry of the figure.
+ */
+const Shape_t *shape_get(int figure, int rotation);
+
+/**
+ * @brief Returns the mask of one row of a figure moved horizontally.
+ *
+ * @param shape  The description of the figure.
+ * @param row    The index of the row inside the bounding box (0 is
+ * `min_row`).
+ * @param y      The horizontal displacement of the figure.
+ *
+ * @return The row mask in the format of `Board_t::rows`. The caller must check
+ * that `min_col + y` and `max_col + y` are inside the field.
+ */
+uint16_t shape_row_mask(const Shape_t *shape, int row, int y);
+
+#endif
@@ -0,0 +1,196 @@
+#include "snapshot.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "backend.h"
+
+// клетки поля упаковываются по две в байт: значения клеток меньше 16
+void tetris_save(const TetrisContext *ctx, TetrisSnapshot_t *snapshot) {
+  const GameInfo_t *game = &ctx->game;
+  memset(snapshot, 0, sizeof(TetrisSnapshot_t));
+  snapshot->started = game->field != NULL;
+  for (int i = 0; snapshot->started && i < FIELD_HEIGHT; ++i) {
+    const int *row = game->field[i];
+    unsigned char *packed = snapshot->cells[i];
+    for (int j = 0; j + 1 < FIELD_WIDTH; j += 2) {
+      packed[j / 2] = (unsigned char)((row[j] & 0xF) | (row[j + 1] & 0xF) << 4);
+    }
+    if (FIELD_WIDTH % 2) {
+      packed[FIELD_WIDTH / 2] = (unsigned char)(row[FIELD_WIDTH - 1] & 0xF);
+    }
+  }
+  for (int i = 0; game->next && i < FIGURE_PART; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      snapshot->next[i][j] = (unsigned char)game->next[i][j];
+    }
+  }
+  snapshot->board = ctx->board;
+  const Figure_position *figure = &ctx->figure;
+  snapshot->x = figure->x, snapshot->y = figure->y;
+  snapshot->rotation = figure->rotation, snapshot->figure = figure->figure;
+  snapshot->next_figure = figure->next_figure;
+  snapshot->score = game->score, snapshot->high_score = game->high_score;
+  snapshot->level = game->level, snapshot->speed = game->speed;
+  snapshot->pause = game->pause;
+  snapshot->initialized = ctx->initialized;
+  snapshot->headless = ctx->headless;
+  snapshot->timer = ctx->timer;
+  snapshot->delay = ctx->delay, snapshot->last_update = ctx->last_update;
+  snapshot->accumulator = ctx->accumulator;
+  snapshot->pieces = ctx->pieces, snapshot->lines = ctx->lines;
+  snapshot->version = ctx->version, snapshot->digest = ctx->digest;
+  snapshot->cleared = ctx->cleared;
+  snapshot->rng = ctx->rng, snapshot->seeded = ctx->seeded;
+  snapshot->randomizer = ctx->randomizer;
+  memcpy(snapshot->bag, ctx->bag, sizeof(snapshot->bag));
+  snapshot->bag_size = ctx->bag_size;
+  snapshot->input = ctx->input;
+}
+
+static int packed_cell(const TetrisSnapshot_t *snapshot, int i, int j) {
+  unsigned char packed = snapshot->cells[i][j / 2];
+  return j % 2 ? packed >> 4 : packed & 0xF;
+}
+
+// клетки - только цвета фигур, а у начатой игры биты доски совпадают с
+// занятыми клетками поля
+static bool field_valid(const TetrisSnapshot_t *snapshot) {
+  bool flag = true;
+  for (int i = 0; i < FIELD_HEIGHT && flag; ++i) {
+    flag = !snapshot->started || !(snapshot->board.rows[i] & ~BOARD_FULL_ROW);
+    for (int j = 0; j < FIELD_WIDTH && flag; ++j) {
+      int cell = packed_cell(snapshot, i, j);
+      bool occupied = j < REAL_FIELD_WIDTH && snapshot->board.rows[i] >> j & 1u;
+      flag = cell <= COUNT_OF_FIGURES &&
+             (!snapshot->started || j >= REAL_FIELD_WIDTH ||
+              occupied == (cell != EMPTY_PLACE));
+    }
+  }
+  return flag;
+}
+
+// все клетки текущей фигуры лежат внутри поля
+static bool figure_valid(const TetrisSnapshot_t *snapshot) {
+  bool flag = snapshot->figure >= 0 && snapshot->figure < COUNT_OF_FIGURES &&
+              snapshot->rotation >= 0 &&
+              snapshot->rotation < COUNT_OF_ROTATIONS &&
+              snapshot->next_figure >= 0 &&
+              snapshot->next_figure < COUNT_OF_FIGURES;
+  if (flag) {
+    const Shape_t *shape = shape_get(snapshot->figure, snapshot->rotation);
+    flag = snapshot->x + shape->min_row >= 0 &&
+           snapshot->x + shape->max_row < FIELD_HEIGHT &&
+           snapshot->y + shape->min_col >= 0 &&
+           snapshot->y + shape->max_col < REAL_FIELD_WIDTH;
+  }
+  return flag;
+}
+
+// время - конечное неотрицательное число миллисекунд
+static bool time_valid(double ms) { return isfinite(ms) && ms >= 0; }
+
+// у начатой игры уровень задает скорость падения: при нулевом уровне фигура
+// не падала бы никогда, при отрицательном - на каждом шаге
+static bool timing_valid(const TetrisSnapshot_t *snapshot) {
+  return time_valid(snapshot->timer.now_ms) &&
+         time_valid(snapshot->timer.step_ms) && time_valid(snapshot->delay) &&
+         time_valid(snapshot->last_update) &&
+         time_valid(snapshot->accumulator) &&
+         (!snapshot->started ||
+          (snapshot->level >= 1 && snapshot->level <= MAX_SPEED + 1 &&
+           snapshot->speed > 0 && snapshot->delay > 0));
+}
+
+bool tetris_snapshot_valid(const TetrisSnapshot_t *snapshot) {
+  bool flag = figure_valid(snapshot) && field_valid(snapshot) &&
+              timing_valid(snapshot) &&
+              snapshot->pause >= ready_to_start &&
+              snapshot->pause <= next_figure && snapshot->bag_size >= 0 &&
+              snapshot->bag_size <= COUNT_OF_FIGURES &&
+              (snapshot->randomizer == RANDOMIZER_UNIFORM ||
+               snapshot->randomizer == RANDOMIZER_BAG) &&
+              snapshot->timer.source >= TIMER_REAL &&
+              snapshot->timer.source <= TIMER_VIRTUAL &&
+              snapshot->input >= Start && snapshot->input <= Action;
+  for (int i = 0; i < snapshot->bag_size && flag; ++i) {
+    flag = snapshot->bag[i] < COUNT_OF_FIGURES;
+  }
+  return flag;
+}
+
+// строки поля восстанавливаются в порядке памяти, указатели строк - заново
+static void load_snapshot(TetrisContext *ctx,
+                          const TetrisSnapshot_t *snapshot) {
+  GameInfo_t *game = &ctx->game;
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    const unsigned char *packed = snapshot->cells[i];
+    int *row = ctx->rows[i] = ctx->cells[i];
+    for (int j = 0; j + 1 < FIELD_WIDTH; j += 2) {
+      row[j] = packed[j / 2] & 0xF, row[j + 1] = packed[j / 2] >> 4;
+    }
+    if (FIELD_WIDTH % 2) {
+      row[FIELD_WIDTH - 1] = packed[FIELD_WIDTH / 2] & 0xF;
+    }
+  }
+  for (int i = 0; i < FIGURE_PART; ++i) {
+    ctx->next_rows[i] = ctx->next_cells[i];
+    for (int j = 0; j < 3; ++j) {
+      ctx->next_cells[i][j] = snapshot->next[i][j];
+    }
+  }
+  game->field = snapshot->started ? ctx->rows : NULL;
+  game->next = snapshot->started ? ctx->next_rows : NULL;
+  ctx->board = snapshot->board;
+  features_load(&ctx->features, &ctx->board);
+  Figure_position *figure = &ctx->figure;
+  figure->x = snapshot->x, figure->y = snapshot->y;
+  figure->rotation = snapshot->rotation, figure->figure = snapshot->figure;
+  figure->next_figure = snapshot->next_figure;
+  game->score = snapshot->score, game->high_score = snapshot->high_score;
+  game->level = snapshot->level, game->speed = snapshot->speed;
+  game->pause = snapshot->pause;
+  ctx->initialized = snapshot->initialized;
+  ctx->headless = snapshot->headless;
+  ctx->timer = snapshot->timer;
+  ctx->delay = snapshot->delay, ctx->last_update = snapshot->last_update;
+  ctx->accumulator = snapshot->accumulator;
+  ctx->pieces = snapshot->pieces, ctx->lines = snapshot->lines;
+  ctx->version = snapshot->version, ctx->digest = snapshot->digest;
+  ctx->cleared = snapshot->cleared;
+  ctx->rng = snapshot->rng, ctx->seeded = snapshot->seeded;
+  ctx->randomizer = snapshot->randomizer;
+  memcpy(ctx->bag, snapshot->bag, sizeof(ctx->bag));
+  ctx->bag_size = snapshot->bag_size;
+  ctx->input = snapshot->input;
+  ctx->replay = NULL, ctx->feed = NULL;
+  memset(&ctx->frame, 0, sizeof(ctx->frame));
+  if (game->field) {
+    build_frame(ctx);
+  }
+}
+
+int tetris_restore(TetrisContext *ctx, const TetrisSnapshot_t *snapshot) {
+  int result = !tetris_snapshot_valid(snapshot);
+  if (!result) {
+    load_snapshot(ctx, snapshot);
+  }
+  return result;
+}
+
+// указатели копии должны указывать в ее собственные массивы
+void tetris_clone(TetrisContext *dst, const TetrisContext *src) {
+  if (dst != src) {
+    memcpy(dst, src, sizeof(TetrisContext));
+    for (int i = 0; i < FIELD_HEIGHT; ++i) {
+      dst->rows[i] = dst->cells[0] + (src->rows[i] - src->cells[0]);
+    }
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      dst->next_rows[i] =
+          dst->next_cells[0] + (src->next_rows[i] - src->next_cells[0]);
+    }
+    dst->game.field = src->game.field ? dst->rows : NULL;
+    dst->game.next = src->game.next ? dst->next_rows : NULL;
+    dst->replay = NULL, dst->feed = NULL;
+  }
+}
@@ -0,0 +1,144 @@
+#ifndef H_FILE_SNAPSHOT
+#define H_FILE_SNAPSHOT
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common.h"
+
+/**
+ * @brief The number of bytes of one packed row of the field of a snapshot
+ * (two cells per byte).
+ */
+#define SNAPSHOT_ROW_SIZE ((FIELD_WIDTH + 1) / 2)
+
+/**
+ * @brief The whole state of a game as plain data.
+ *
+ * A snapshot has no pointers, so it can be copied with `memcpy` or assignment,
+ * kept in arrays and written to a file by the same build of the program. It
+ * holds everything that decides the future of the game: the cells of the
+ * field, the figures, the score, the generator of the figures and the timer,
+ * so a game restored from a snapshot continues exactly the same way as the
+ * saved one. The row fill counts, the column heights and the frame of the
+ * interface are not stored, they are rebuilt by `tetris_restore`.
+ *
+ * @var cells        The cells of the field row by row, two cells per byte
+ * (the even column in the low 4 bits).
+ * @var next         The cells of the next figure grid.
+ * @var board        The bitboard of the fixed figures.
+ * @var x, y         The position of the current figure.
+ * @var rotation     The rotation of the current figure.
+ * @var figure       The current figure.
+ * @var next_figure  The next figure.
+ * @var score        The score.
+ * @var high_score   The high score.
+ * @var level        The level.
+ * @var speed        The speed.
+ * @var pause        The state of the game.
+ * @var started      `true` if the game has a field (started and not ended).
+ * @var initialized  `true` if the game was initialized.
+ * @var headless     `true` for games without a player.
+ * @var timer        The gravity timer.
+ * @var delay        The delay between shifts by the timer (ms).
+ * @var last_update  The time of the last shift by the timer (ms).
+ * @var accumulator  The time not yet spent on ticks (ms).
+ * @var pieces       The number of fixed figures.
+ * @var lines        The number of removed lines.
+ * @var version      The number of steps that changed the view of the game.
+ * @var digest       The packed visible state after the last step.
+ * @var cleared      The rows removed when the last figure was fixed.
+ * @var rng          The generator of the figures.
+ * @var seeded       `true` if the generator was seeded.
+ * @var randomizer   The way to choose the next figure.
+ * @var bag          The figures left in the current set.
+ * @var bag_size     The number of figures in `bag`.
+ * @var input        The last action given since the last step.
+ */
+typedef struct {
+  unsigned char cells[FIELD_HEIGHT][SNAPSHOT_ROW_SIZE];
+  unsigned char next[FIGURE_PART][3];
+  Board_t board;
+  int x;
+  int y;
+  int rotation;
+  int figure;
+  int next_figure;
+  int score;
+  int high_score;
+  int level;
+  int speed;
+  int pause;
+  bool started;
+  bool initialized;
+  bool headless;
+  Timer_t timer;
+  double delay;
+  double last_update;
+  double accumulator;
+  int pieces;
+  int lines;
+  unsigned long version;
+  unsigned long long digest;
+  uint32_t cleared;
+  Rng_t rng;
+  bool seeded;
+  Randomizer_t randomizer;
+  unsigned char bag[COUNT_OF_FIGURES];
+  int bag_size;
+  UserAction_t input;
+} TetrisSnapshot_t;
+
+/**
+ * @brief Saves the state of a game to a snapshot.
+ *
+ * @param ctx       The game context.
+ * @param snapshot  The snapshot to fill.
+ */
+void tetris_save(const TetrisContext *ctx, TetrisSnapshot_t *snapshot);
+
+/**
+ * @brief Checks that a snapshot describes a game the engine can continue.
+ *
+ * A snapshot read from a file may be corrupt or truncated. It is valid if the
+ * figures, the rotation, the state, the set of figures and the enumerations
+ * are in their ranges, the current figure lies inside the field, the cells
+ * hold only colors of figures, the times of the timer are finite and not
+ * negative and, for a started game, the bitboard has exactly the occupied
+ * cells of the field, the level is from 1 to `MAX_SPEED + 1` and the speed
+ * and the gravity delay are positive.
+ *
+ * @param snapshot  The snapshot.
+ *
+ * @return `true` if `tetris_restore` accepts the snapshot.
+ */
+bool tetris_snapshot_valid(const TetrisSnapshot_t *snapshot);
+
+/**
+ * @brief Replaces the state of a game with a snapshot.
+ *
+ * The game continues from the saved state: the same inputs at the same times
+ * give the same game as after `tetris_save`. The context stops recording (see
+ * `tetris_record`), because the recorded steps would no longer lead to its
+ * state, and stops publishing its frames (see `tetris_publish`).
+ *
+ * @param ctx       The game context.
+ * @param snapshot  The snapshot.
+ *
+ * @return 0 on success, 1 if the snapshot is not valid (see
+ * `tetris_snapshot_valid`); the context is not changed then.
+ */
+int tetris_restore(TetrisContext *ctx, const TetrisSnapshot_t *snapshot);
+
+/**
+ * @brief Makes one context an exact copy of another.
+ *
+ * The context is copied as a whole and its row pointers are moved into the
+ * copy, so cloning costs one `memcpy` of the context. The copy does not
+ * record its steps or publish its frames.
+ *
+ * @param dst  The context to overwrite.
+ * @param src  The context to copy.
+ */
+void tetris_clone(TetrisContext *dst, const TetrisContext *src);
+
+#endif
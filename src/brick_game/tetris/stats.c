@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L
+#include "stats.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Settings of the periodic dump.
+ *
+ * @var file    The file of the dump or `NULL`.
+ * @var json    `true` for JSON.
+ * @var period  The time between dumps (ms).
+ * @var last    The time of the last dump (ms).
+ * @var frame   The time of the last frame (ms), 0 before the first one.
+ */
+typedef struct {
+  FILE *file;
+  bool json;
+  double period;
+  double last;
+  double frame;
+} StatsDump_t;
+
+/**
+ * @brief The statistics of one thread in the list of all threads.
+ *
+ * @var stats  The statistics.
+ * @var next   The block of the next thread.
+ */
+typedef struct StatsBlock {
+  Stats_t stats;
+  struct StatsBlock *next;
+} StatsBlock_t;
+
+static _Thread_local StatsBlock_t block;
+static _Thread_local bool registered;
+static StatsBlock_t *blocks;   // блоки работающих потоков
+static Stats_t retired;        // сумма потоков, которые уже завершились
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+static StatsDump_t dump;
+static pthread_mutex_t dump_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *const state_names[STATS_STATES] = {
+    "ready_to_start", "pause",    "terminate", "move_left",
+    "move_right",     "no_signal", "fall",     "rotation",
+    "game_over",      "shift",    "next_figure"};
+
+// счетчик меняет только его поток, поэтому достаточно отдельных атомарных
+// чтения и записи без блокировки шины
+static void add_count(atomic_ullong *to, unsigned long long value) {
+  atomic_store_explicit(
+      to, atomic_load_explicit(to, memory_order_relaxed) + value,
+      memory_order_relaxed);
+}
+
+static double load(_Atomic double *from) {
+  return atomic_load_explicit(from, memory_order_relaxed);
+}
+
+static void store(_Atomic double *to, double value) {
+  atomic_store_explicit(to, value, memory_order_relaxed);
+}
+
+static void merge_timing(StatsTiming_t *to, StatsTiming_t *from) {
+  unsigned long long count =
+      atomic_load_explicit(&from->count, memory_order_relaxed);
+  unsigned long long before =
+      atomic_load_explicit(&to->count, memory_order_relaxed);
+  if (count > 0) {
+    if (before == 0 || load(&from->min) < load(&to->min)) {
+      store(&to->min, load(&from->min));
+    }
+    if (before == 0 || load(&from->max) > load(&to->max)) {
+      store(&to->max, load(&from->max));
+    }
+    add_count(&to->count, count);
+    store(&to->total, load(&to->total) + load(&from->total));
+    store(&to->squares, load(&to->squares) + load(&from->squares));
+  }
+}
+
+static void merge_stats(Stats_t *to, Stats_t *from) {
+  for (int i = 0; i < STATS_STATES; ++i) {
+    merge_timing(&to->state_time[i], &from->state_time[i]);
+  }
+  merge_timing(&to->steps, &from->steps);
+  merge_timing(&to->tick_late, &from->tick_late);
+  merge_timing(&to->renders, &from->renders);
+  merge_timing(&to->frames, &from->frames);
+  add_count(&to->collisions,
+            atomic_load_explicit(&from->collisions, memory_order_relaxed));
+  add_count(&to->clears,
+            atomic_load_explicit(&from->clears, memory_order_relaxed));
+  add_count(&to->lines,
+            atomic_load_explicit(&from->lines, memory_order_relaxed));
+  add_count(&to->polls,
+            atomic_load_explicit(&from->polls, memory_order_relaxed));
+}
+
+static void zero_timing(StatsTiming_t *timing) {
+  atomic_store_explicit(&timing->count, 0, memory_order_relaxed);
+  store(&timing->total, 0);
+  store(&timing->squares, 0);
+  store(&timing->min, 0);
+  store(&timing->max, 0);
+}
+
+static void zero_stats(Stats_t *stats) {
+  for (int i = 0; i < STATS_STATES; ++i) {
+    zero_timing(&stats->state_time[i]);
+  }
+  zero_timing(&stats->steps);
+  zero_timing(&stats->tick_late);
+  zero_timing(&stats->renders);
+  zero_timing(&stats->frames);
+  atomic_store_explicit(&stats->collisions, 0, memory_order_relaxed);
+  atomic_store_explicit(&stats->clears, 0, memory_order_relaxed);
+  atomic_store_explicit(&stats->lines, 0, memory_order_relaxed);
+  atomic_store_explicit(&stats->polls, 0, memory_order_relaxed);
+}
+
+// при завершении потока его статистика переходит в общую сумму
+static void retire_block(void *arg) {
+  StatsBlock_t *own = (StatsBlock_t *)arg;
+  pthread_mutex_lock(&blocks_lock);
+  merge_stats(&retired, &own->stats);
+  StatsBlock_t **link = &blocks;
+  while (*link != own) link = &(*link)->next;
+  *link = own->next;
+  pthread_mutex_unlock(&blocks_lock);
+}
+
+static void create_key(void) { pthread_key_create(&key, retire_block); }
+
+static void register_block(void) {
+  pthread_once(&key_once, create_key);
+  pthread_mutex_lock(&blocks_lock);
+  block.next = blocks;
+  blocks = &block;
+  pthread_mutex_unlock(&blocks_lock);
+  pthread_setspecific(key, &block);
+  registered = true;
+}
+
+Stats_t *tetris_stats(void) {
+  if (!registered) register_block();
+  return &block.stats;
+}
+
+void stats_collect(Stats_t *total) {
+  memset(total, 0, sizeof(*total));
+  pthread_mutex_lock(&blocks_lock);
+  merge_stats(total, &retired);
+  for (StatsBlock_t *item = blocks; item; item = item->next) {
+    merge_stats(total, &item->stats);
+  }
+  pthread_mutex_unlock(&blocks_lock);
+}
+
+bool stats_enabled(void) { return STATS_ENABLED; }
+
+void stats_reset(void) {
+  pthread_mutex_lock(&blocks_lock);
+  zero_stats(&retired);
+  for (StatsBlock_t *item = blocks; item; item = item->next) {
+    zero_stats(&item->stats);
+  }
+  pthread_mutex_unlock(&blocks_lock);
+  dump.frame = 0;
+}
+
+double stats_now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1e6;
+}
+
+void stats_add(atomic_ullong *counter, unsigned long long value) {
+  add_count(counter, value);
+}
+
+void stats_time(StatsTiming_t *timing, double ms) {
+  bool first = atomic_load_explicit(&timing->count, memory_order_relaxed) == 0;
+  if (first || ms < load(&timing->min)) store(&timing->min, ms);
+  if (first || ms > load(&timing->max)) store(&timing->max, ms);
+  add_count(&timing->count, 1);
+  store(&timing->total, load(&timing->total) + ms);
+  store(&timing->squares, load(&timing->squares) + ms * ms);
+}
+
+void stats_frame(double now) {
+  if (dump.frame > 0) {
+    stats_time(&tetris_stats()->frames, now - dump.frame);
+  }
+  dump.frame = now;
+}
+
+static double timing_mean(const StatsTiming_t *timing) {
+  return timing->count ? timing->total / (double)timing->count : 0;
+}
+
+static double timing_deviation(const StatsTiming_t *timing) {
+  double mean = timing_mean(timing), deviation = 0;
+  if (timing->count > 1) {
+    double variance = (timing->squares - mean * timing->total) /
+                      (double)(timing->count - 1);
+    deviation = variance > 0 ? sqrt(variance) : 0;
+  }
+  return deviation;
+}
+
+static void dump_timing(FILE *file, bool json, const char *name,
+                        const StatsTiming_t *timing, bool last) {
+  if (json) {
+    fprintf(file,
+            "\"%s\": {\"count\": %llu, \"mean_ms\": %.6f, "
+            "\"stddev_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f}%s",
+            name, timing->count, timing_mean(timing),
+            timing_deviation(timing), timing->min, timing->max,
+            last ? "" : ", ");
+  } else {
+    fprintf(file,
+            "%-24s %12llu  mean %10.6f  sd %10.6f  min %10.6f  max %10.6f "
+            "ms\n",
+            name, timing->count, timing_mean(timing),
+            timing_deviation(timing), timing->min, timing->max);
+  }
+}
+
+static void dump_counter(FILE *file, bool json, const char *name,
+                         unsigned long long value) {
+  if (json) {
+    fprintf(file, "\"%s\": %llu, ", name, value);
+  } else {
+    fprintf(file, "%-24s %12llu\n", name, value);
+  }
+}
+
+// пишет сумму всех потоков; вызывается под dump_lock
+static void write_stats(FILE *file, bool json) {
+  static Stats_t stats;  // защищена dump_lock
+  stats_collect(&stats);
+  if (json) {
+    fprintf(file, "{\"enabled\": %s, \"time_ms\": %.3f, ",
+            STATS_ENABLED ? "true" : "false", stats_now());
+  } else {
+    fprintf(file, "statistics%s\n", STATS_ENABLED ? "" : " (disabled)");
+  }
+  dump_counter(file, json, "collisions", stats.collisions);
+  dump_counter(file, json, "clears", stats.clears);
+  dump_counter(file, json, "lines", stats.lines);
+  dump_counter(file, json, "polls", stats.polls);
+  if (json) fprintf(file, "\"states\": {");
+  for (int i = 0; i < STATS_STATES; ++i) {
+    dump_timing(file, json, state_names[i], &stats.state_time[i],
+                i == STATS_STATES - 1);
+  }
+  if (json) fprintf(file, "}, ");
+  dump_timing(file, json, "steps", &stats.steps, false);
+  dump_timing(file, json, "tick_late", &stats.tick_late, false);
+  dump_timing(file, json, "renders", &stats.renders, false);
+  dump_timing(file, json, "frames", &stats.frames, true);
+  fprintf(file, json ? "}\n" : "\n");
+  fflush(file);
+}
+
+void stats_dump(FILE *file, bool json) {
+  pthread_mutex_lock(&dump_lock);
+  write_stats(file, json);
+  pthread_mutex_unlock(&dump_lock);
+}
+
+void stats_set_dump(FILE *file, bool json, double period_ms) {
+  pthread_mutex_lock(&dump_lock);
+  dump.file = STATS_ENABLED ? file : NULL;
+  dump.json = json;
+  dump.period = period_ms;
+  dump.last = stats_now();
+  pthread_mutex_unlock(&dump_lock);
+}
+
+// пока один поток пишет статистику, остальные не ждут и не пишут
+void stats_poll(void) {
+  if (!pthread_mutex_trylock(&dump_lock)) {
+    double now = dump.file ? stats_now() : 0;
+    if (dump.file && now - dump.last >= dump.period) {
+      dump.last = now;
+      write_stats(dump.file, dump.json);
+    }
+    pthread_mutex_unlock(&dump_lock);
+  }
+}
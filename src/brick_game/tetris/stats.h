@@ -0,0 +1,176 @@
+#ifndef H_FILE_STATS
+#define H_FILE_STATS
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../../tetris.h"
+
+/**
+ * @brief The number of game states counted by the statistics.
+ */
+#define STATS_STATES (next_figure + 1)
+
+/**
+ * @brief Durations of one kind of event.
+ *
+ * The fields are atomic so that a dump can read the timings of a thread while
+ * the thread updates them; only the owner of a timing writes it.
+ *
+ * @var count   The number of events.
+ * @var total   The sum of the durations (ms).
+ * @var squares The sum of the squared durations, for the deviation.
+ * @var min     The shortest duration (ms).
+ * @var max     The longest duration (ms).
+ */
+typedef struct {
+  atomic_ullong count;
+  _Atomic double total;
+  _Atomic double squares;
+  _Atomic double min;
+  _Atomic double max;
+} StatsTiming_t;
+
+/**
+ * @brief Counters and timings of the hot paths of the engine and the
+ * interface.
+ *
+ * The statistics are collected only when the program is built with the
+ * `TETRIS_STATS` macro (`make ... STATS=1`); otherwise the hooks compile to
+ * nothing and all values stay zero. Every thread counts into statistics of
+ * its own (`tetris_stats`), so the hooks need no locks even when games run
+ * on several threads; `stats_collect` and `stats_dump` sum the statistics of
+ * all threads, including the threads that have already exited.
+ *
+ * @var state_time   The number and the time of `game_active` calls by the
+ * state handled (after the gravity timer is checked).
+ * @var steps        The time of `tetris_step` (`updateCurrentState`).
+ * @var collisions   The number of collision checks (`can_move`).
+ * @var clears       The number of line clears (`clear_lines`).
+ * @var lines        The number of removed lines.
+ * @var tick_late    How late the gravity shifts were against the delay of the
+ * level (ms); its deviation is the tick jitter.
+ * @var renders      The time of `print_game`.
+ * @var frames       The time between two `print_game` calls.
+ * @var polls        The number of input polls (`process_signal`).
+ */
+typedef struct {
+  StatsTiming_t state_time[STATS_STATES];
+  StatsTiming_t steps;
+  atomic_ullong collisions;
+  atomic_ullong clears;
+  atomic_ullong lines;
+  StatsTiming_t tick_late;
+  StatsTiming_t renders;
+  StatsTiming_t frames;
+  atomic_ullong polls;
+} Stats_t;
+
+#ifdef TETRIS_STATS
+#define STATS_ENABLED 1
+#define STATS_ADD(field, value) stats_add(&tetris_stats()->field, (value))
+#define STATS_BEGIN(name) double name = stats_now()
+#define STATS_END(timing, name) \
+  stats_time(&tetris_stats()->timing, stats_now() - (name))
+#define STATS_TIME(timing, ms) stats_time(&tetris_stats()->timing, (ms))
+#define STATS_FRAME(name) stats_frame(name)
+#define STATS_POLL() stats_poll()
+#else
+#define STATS_ENABLED 0
+#define STATS_ADD(field, value) ((void)0)
+#define STATS_BEGIN(name) ((void)0)
+#define STATS_END(timing, name) ((void)0)
+#define STATS_TIME(timing, ms) ((void)0)
+#define STATS_FRAME(name) ((void)0)
+#define STATS_POLL() ((void)0)
+#endif
+
+/**
+ * @brief Returns the statistics of the calling thread.
+ */
+Stats_t *tetris_stats(void);
+
+/**
+ * @brief Sums the statistics of all threads.
+ *
+ * @param total  The sum.
+ */
+void stats_collect(Stats_t *total);
+
+/**
+ * @brief Returns `true` if the program collects statistics (`TETRIS_STATS`).
+ */
+bool stats_enabled(void);
+
+/**
+ * @brief Sets the statistics of all threads to zero.
+ *
+ * Events counted by other threads during the call may be kept in part.
+ */
+void stats_reset(void);
+
+/**
+ * @brief Returns the monotonic time of the system (ms).
+ */
+double stats_now(void);
+
+/**
+ * @brief Adds a value to a counter of the calling thread.
+ *
+ * @param counter  The counter.
+ * @param value    The value.
+ */
+void stats_add(atomic_ullong *counter, unsigned long long value);
+
+/**
+ * @brief Adds a duration to a timing of the calling thread.
+ *
+ * @param timing  The timing.
+ * @param ms      The duration (ms).
+ */
+void stats_time(StatsTiming_t *timing, double ms);
+
+/**
+ * @brief Adds the time since the previous frame to the frame timing.
+ *
+ * @param now  The time the frame started (`stats_now`).
+ */
+void stats_frame(double now);
+
+/**
+ * @brief Writes the sum of the statistics of all threads to a file.
+ *
+ * Dumps from several threads do not interleave.
+ *
+ * The text form has one line per counter or timing; timings show the number
+ * of events, the mean, the deviation, the minimum and the maximum (ms). The
+ * JSON form is one object per dump on one line.
+ *
+ * @param file  The file.
+ * @param json  `true` for JSON, `false` for text.
+ */
+void stats_dump(FILE *file, bool json);
+
+/**
+ * @brief Turns on the periodic dump of the statistics.
+ *
+ * Every `tetris_step` checks the time and writes the statistics with
+ * `stats_dump` when `period_ms` has passed since the last dump; when games
+ * run on several threads, only one of them writes each dump. Does nothing
+ * when statistics are not collected.
+ *
+ * @param file       The file or `NULL` to turn the dump off. It is flushed
+ * after every dump and not closed.
+ * @param json       `true` for JSON.
+ * @param period_ms  The time between dumps (ms).
+ */
+void stats_set_dump(FILE *file, bool json, double period_ms);
+
+/**
+ * @brief Writes the statistics if the period of the dump has passed.
+ *
+ * Called by `tetris_step`.
+ */
+void stats_poll(void);
+
+#endif
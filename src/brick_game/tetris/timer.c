@@ -0,0 +1,33 @@
+#define _POSIX_C_SOURCE 200809L
+#include "timer.h"
+
+#include <time.h>
+
+void timer_init(Timer_t *timer, TimeSource_t source, double step_ms) {
+  timer->source = source;
+  timer->now_ms = 0;
+  timer->step_ms = step_ms;
+}
+
+// монотонное время системы или собственное время таймера
+double timer_now(const Timer_t *timer) {
+  double now = timer->now_ms;
+  if (timer->source == TIMER_REAL) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    now = (double)time.tv_sec * 1000.0 + (double)time.tv_nsec / 1e6;
+  }
+  return now;
+}
+
+void timer_tick(Timer_t *timer) {
+  if (timer->source == TIMER_FIXED_STEP) {
+    timer->now_ms += timer->step_ms;
+  }
+}
+
+void timer_advance(Timer_t *timer, double ms) {
+  if (timer->source != TIMER_REAL) {
+    timer->now_ms += ms;
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef H_FILE_TIMER
+#define H_FILE_TIMER
+
+/**
+ * @brief Sources of time for the gravity timer of a game.
+ *
+ *   - `TIMER_REAL`: The monotonic wall clock of the system. The figures fall
+ * at the same rate however often the game is stepped. It is the default
+ * source (a zero-initialized `Timer_t` uses it).
+ *   - `TIMER_FIXED_STEP`: Every step of the game advances the time by a fixed
+ * amount, so a game is a pure function of its inputs.
+ *   - `TIMER_VIRTUAL`: The time only moves when the caller advances it with
+ * `timer_advance`, for tests and tools that control time explicitly.
+ */
+typedef enum { TIMER_REAL, TIMER_FIXED_STEP, TIMER_VIRTUAL } TimeSource_t;
+
+/**
+ * @brief Gravity timer of one game.
+ *
+ * @var source   The source of time.
+ * @var now_ms   The current time of `TIMER_FIXED_STEP` and `TIMER_VIRTUAL`
+ * sources (ms).
+ * @var step_ms  The time added by every step for `TIMER_FIXED_STEP` (ms).
+ */
+typedef struct {
+  TimeSource_t source;
+  double now_ms;
+  double step_ms;
+} Timer_t;
+
+/**
+ * @brief Sets the source of time of a timer and resets its time to zero.
+ *
+ * @param timer    A pointer to the timer.
+ * @param source   The new source of time.
+ * @param step_ms  The time added by every step (only for `TIMER_FIXED_STEP`).
+ */
+void timer_init(Timer_t *timer, TimeSource_t source, double step_ms);
+
+/**
+ * @brief Returns the current time of a timer in milliseconds.
+ *
+ * @param timer A pointer to the timer.
+ *
+ * @return The time in milliseconds. Only differences between two values
+ * returned by the same timer are meaningful.
+ */
+double timer_now(const Timer_t *timer);
+
+/**
+ * @brief Notifies the timer about a step of the game.
+ *
+ * Advances a `TIMER_FIXED_STEP` timer by `step_ms`, does nothing for other
+ * sources.
+ *
+ * @param timer A pointer to the timer.
+ */
+void timer_tick(Timer_t *timer);
+
+/**
+ * @brief Moves a `TIMER_FIXED_STEP` or `TIMER_VIRTUAL` timer forward.
+ *
+ * Does nothing for `TIMER_REAL` timers.
+ *
+ * @param timer  A pointer to the timer.
+ * @param ms     The time to add (ms).
+ */
+void timer_advance(Timer_t *timer, double ms);
+
+#endif
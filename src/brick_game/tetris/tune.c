@@ -0,0 +1,305 @@
+#define _GNU_SOURCE
+#include "tune.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+
+/**
+ * @brief Result of one game.
+ *
+ * @var score     The final score.
+ * @var lines     The removed lines.
+ * @var pieces    The fixed figures.
+ * @var survived  `true` if the game reached `max_pieces`.
+ */
+typedef struct {
+  int score;
+  int lines;
+  int pieces;
+  bool survived;
+} TuneGame_t;
+
+/**
+ * @brief Games not yet played by one worker.
+ *
+ * The games of all weight sets are numbered in a row (game `i` of set `s` is
+ * task `s * games + i`), and every worker keeps a range of these numbers. The
+ * owner takes tasks from the beginning of its range, other workers steal the
+ * end of it.
+ *
+ * @var lock   Protects the range.
+ * @var begin  The first task of the range.
+ * @var end    The task after the last one.
+ */
+typedef struct {
+  pthread_mutex_t lock;
+  long long begin;
+  long long end;
+} TuneQueue_t;
+
+/**
+ * @brief The shared state of one `tune_run`.
+ *
+ * @var config   The settings.
+ * @var weights  The weight sets.
+ * @var count    The number of weight sets.
+ * @var queues   The queues of the workers.
+ * @var workers  The number of workers.
+ * @var results  The results of all games by task.
+ */
+typedef struct {
+  const TuneConfig_t *config;
+  const BotWeights_t *weights;
+  int count;
+  TuneQueue_t *queues;
+  int workers;
+  TuneGame_t *results;
+} Tuner_t;
+
+/**
+ * @brief One worker thread with its own game and bots.
+ *
+ * @var tuner    The shared state.
+ * @var id       The number of the worker (its queue).
+ * @var ctx      The game context of the worker.
+ * @var bots     The bots of the worker, one per weight set.
+ * @var steals   The number of ranges stolen by the worker.
+ * @var thread   The thread of the worker.
+ * @var started  `true` if the thread was started.
+ */
+typedef struct {
+  Tuner_t *tuner;
+  int id;
+  TetrisContext *ctx;
+  Bot_t **bots;
+  long long steals;
+  pthread_t thread;
+  bool started;
+} TuneWorker_t;
+
+int tune_processors(void) {
+  int count = 1;
+#ifdef __linux__
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+    count = CPU_COUNT(&set);
+  }
+#endif
+  return count;
+}
+
+// вторая половина оставшихся игр другого работника, -1 если игр не осталось
+static long long steal(TuneWorker_t *worker) {
+  Tuner_t *tuner = worker->tuner;
+  long long task = -1, end = 0;
+  for (int k = 1; k < tuner->workers && task < 0; ++k) {
+    TuneQueue_t *victim = &tuner->queues[(worker->id + k) % tuner->workers];
+    pthread_mutex_lock(&victim->lock);
+    long long left = victim->end - victim->begin;
+    if (left > 0) {
+      task = victim->end - (left + 1) / 2;
+      end = victim->end;
+      victim->end = task;
+    }
+    pthread_mutex_unlock(&victim->lock);
+  }
+  if (task >= 0) {
+    TuneQueue_t *own = &tuner->queues[worker->id];
+    pthread_mutex_lock(&own->lock);
+    own->begin = task + 1, own->end = end;
+    pthread_mutex_unlock(&own->lock);
+    worker->steals++;
+  }
+  return task;
+}
+
+static long long take(TuneWorker_t *worker) {
+  TuneQueue_t *own = &worker->tuner->queues[worker->id];
+  long long task = -1;
+  pthread_mutex_lock(&own->lock);
+  if (own->begin < own->end) {
+    task = own->begin++;
+  }
+  pthread_mutex_unlock(&own->lock);
+  return task < 0 ? steal(worker) : task;
+}
+
+// игра бота до конца или до max_pieces фигур; контекст обнуляется, как новый
+// контекст из tetris_create
+static void play_game(const TuneConfig_t *config, TetrisContext *ctx,
+                      Bot_t *bot, unsigned long long seed, TuneGame_t *game) {
+  memset(ctx, 0, sizeof(TetrisContext));
+  ctx->headless = true;
+  tetris_seed(ctx, seed);
+  tetris_set_randomizer(ctx, config->randomizer);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, TUNE_STEP_MS);
+  tetris_input(ctx, Start, 0);
+  GameInfo_t info = tetris_step(ctx);
+  while (info.pause != game_over && info.pause != terminate &&
+         ctx->pieces < config->max_pieces) {
+    tetris_input(ctx, bot_action(bot, ctx), 0);
+    info = tetris_step(ctx);
+  }
+  game->score = info.score;
+  game->lines = ctx->lines;
+  game->pieces = ctx->pieces;
+  game->survived = info.pause != game_over && info.pause != terminate;
+}
+
+static void *work(void *arg) {
+  TuneWorker_t *worker = (TuneWorker_t *)arg;
+  Tuner_t *tuner = worker->tuner;
+  const TuneConfig_t *config = tuner->config;
+  long long task;
+  while ((task = take(worker)) >= 0) {
+    int set = (int)(task / config->games), game = (int)(task % config->games);
+    play_game(config, worker->ctx, worker->bots[set],
+              config->seed + (unsigned long long)game, &tuner->results[task]);
+  }
+  return NULL;
+}
+
+static int compare_ints(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+// значения берутся в порядке номеров игр, поэтому сводка не зависит от того,
+// какой поток сыграл игру
+static void summarize(const TuneGame_t *games, int count, size_t offset,
+                      int *values, TuneSummary_t *summary) {
+  double total = 0, squares = 0;
+  for (int i = 0; i < count; ++i) {
+    values[i] = *(const int *)((const char *)&games[i] + offset);
+    total += values[i];
+    squares += (double)values[i] * values[i];
+  }
+  qsort(values, count, sizeof(int), compare_ints);
+  summary->mean = total / count;
+  double variance =
+      count > 1 ? (squares - summary->mean * total) / (count - 1) : 0;
+  summary->deviation = variance > 0 ? sqrt(variance) : 0;
+  summary->min = values[0];
+  summary->p10 = values[(count - 1) / 10];
+  summary->median = values[(count - 1) / 2];
+  summary->p90 = values[(count - 1) * 9 / 10];
+  summary->max = values[count - 1];
+}
+
+static int report(const Tuner_t *tuner, TuneReport_t *reports) {
+  int games = tuner->config->games, result = 0;
+  int *values = (int *)malloc(games * sizeof(int));
+  result = values == NULL;
+  for (int s = 0; s < tuner->count && !result; ++s) {
+    const TuneGame_t *results = &tuner->results[(long long)s * games];
+    TuneReport_t *out = &reports[s];
+    memset(out, 0, sizeof(TuneReport_t));
+    out->weights = tuner->weights[s];
+    out->games = games;
+    summarize(results, games, offsetof(TuneGame_t, score), values,
+              &out->score);
+    summarize(results, games, offsetof(TuneGame_t, lines), values,
+              &out->lines);
+    summarize(results, games, offsetof(TuneGame_t, pieces), values,
+              &out->pieces);
+    int survived = 0;
+    for (int i = 0; i < games; ++i) {
+      survived += results[i].survived;
+    }
+    out->survival = (double)survived / games;
+  }
+  free(values);
+  return result;
+}
+
+static void free_workers(TuneWorker_t *workers, int count, int sets) {
+  for (int i = 0; workers && i < count; ++i) {
+    for (int s = 0; workers[i].bots && s < sets; ++s) {
+      bot_destroy(workers[i].bots[s]);
+    }
+    free(workers[i].bots);
+    tetris_destroy(workers[i].ctx);
+  }
+  free(workers);
+}
+
+// у каждого работника свой контекст и свои боты (боты без потоков поиска)
+static TuneWorker_t *create_workers(Tuner_t *tuner) {
+  TuneWorker_t *workers =
+      (TuneWorker_t *)calloc(tuner->workers, sizeof(TuneWorker_t));
+  bool flag = workers != NULL;
+  for (int i = 0; flag && i < tuner->workers; ++i) {
+    TuneWorker_t *worker = &workers[i];
+    worker->tuner = tuner, worker->id = i;
+    worker->ctx = tetris_create();
+    worker->bots = (Bot_t **)calloc(tuner->count, sizeof(Bot_t *));
+    flag = worker->ctx && worker->bots;
+    for (int s = 0; flag && s < tuner->count; ++s) {
+      worker->bots[s] = bot_create(0, &tuner->weights[s]);
+      flag = worker->bots[s] != NULL;
+    }
+  }
+  if (!flag) {
+    free_workers(workers, tuner->workers, tuner->count);
+    workers = NULL;
+  }
+  return workers;
+}
+
+int tune_run(const TuneConfig_t *config, const BotWeights_t *weights,
+             int count, TuneReport_t *reports, TuneStats_t *stats) {
+  int result = config->games <= 0 || config->max_pieces <= 0 ||
+               config->threads < 0 || count <= 0;
+  Tuner_t tuner = {.config = config, .weights = weights, .count = count};
+  long long tasks = (long long)config->games * count;
+  TuneWorker_t *workers = NULL;
+  if (!result) {
+    tuner.workers = config->threads ? config->threads : tune_processors();
+    if (tuner.workers > tasks) tuner.workers = (int)tasks;
+    tuner.queues = (TuneQueue_t *)calloc(tuner.workers, sizeof(TuneQueue_t));
+    tuner.results = (TuneGame_t *)calloc(tasks, sizeof(TuneGame_t));
+    result = !tuner.queues || !tuner.results;
+  }
+  if (!result) {
+    workers = create_workers(&tuner);
+    result = workers == NULL;
+  }
+  if (!result) {
+    for (int i = 0; i < tuner.workers; ++i) {
+      pthread_mutex_init(&tuner.queues[i].lock, NULL);
+      tuner.queues[i].begin = tasks * i / tuner.workers;
+      tuner.queues[i].end = tasks * (i + 1) / tuner.workers;
+    }
+    // игры работника, чей поток не запустился, разберут остальные
+    for (int i = 1; i < tuner.workers; ++i) {
+      workers[i].started =
+          pthread_create(&workers[i].thread, NULL, work, &workers[i]) == 0;
+    }
+    work(&workers[0]);
+    long long steals = workers[0].steals;
+    for (int i = 1; i < tuner.workers; ++i) {
+      if (workers[i].started) {
+        pthread_join(workers[i].thread, NULL);
+      }
+      steals += workers[i].steals;
+    }
+    for (int i = 0; i < tuner.workers; ++i) {
+      pthread_mutex_destroy(&tuner.queues[i].lock);
+    }
+    if (stats) {
+      stats->threads = tuner.workers;
+      stats->steals = steals;
+    }
+    result = report(&tuner, reports);
+  }
+  free_workers(workers, tuner.workers, count);
+  free(tuner.queues);
+  free(tuner.results);
+  return result;
+}
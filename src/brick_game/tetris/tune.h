@@ -0,0 +1,114 @@
+#ifndef H_FILE_TUNE
+#define H_FILE_TUNE
+#include <stdbool.h>
+
+#include "bot.h"
+#include "common.h"
+
+/**
+ * @brief The time of one step of the games played by `tune_run` (ms).
+ */
+#define TUNE_STEP_MS 10
+
+/**
+ * @brief Settings of an evaluation of weight sets of the bot.
+ *
+ * @var games       The number of games played with every weight set.
+ * @var max_pieces  The number of fixed figures after which a game is stopped
+ * and counted as survived.
+ * @var seed        Game `i` of every weight set is seeded with `seed + i`, so
+ * all sets play the same sequences of figures.
+ * @var randomizer  The way the figures are chosen.
+ * @var threads     The number of worker threads, the calling thread included
+ * (0 uses one worker per processor).
+ */
+typedef struct {
+  int games;
+  int max_pieces;
+  unsigned long long seed;
+  Randomizer_t randomizer;
+  int threads;
+} TuneConfig_t;
+
+/**
+ * @brief Distribution of one result of the games of a weight set.
+ *
+ * @var mean       The mean value.
+ * @var deviation  The standard deviation.
+ * @var min        The smallest value.
+ * @var p10        The 10th percentile.
+ * @var median     The median.
+ * @var p90        The 90th percentile.
+ * @var max        The largest value.
+ */
+typedef struct {
+  double mean;
+  double deviation;
+  int min;
+  int p10;
+  int median;
+  int p90;
+  int max;
+} TuneSummary_t;
+
+/**
+ * @brief Results of the games of one weight set.
+ *
+ * @var weights   The weight set.
+ * @var games     The number of games played.
+ * @var score     The final scores.
+ * @var lines     The removed lines.
+ * @var pieces    The fixed figures (the survival time of the games).
+ * @var survival  The share of games that reached `max_pieces`.
+ */
+typedef struct {
+  BotWeights_t weights;
+  int games;
+  TuneSummary_t score;
+  TuneSummary_t lines;
+  TuneSummary_t pieces;
+  double survival;
+} TuneReport_t;
+
+/**
+ * @brief Counters of the scheduler of the last `tune_run`.
+ *
+ * @var threads  The number of workers.
+ * @var steals   The number of times a worker took games from another one.
+ */
+typedef struct {
+  int threads;
+  long long steals;
+} TuneStats_t;
+
+/**
+ * @brief Returns the number of processors available to the process.
+ *
+ * @return The number of processors, at least 1.
+ */
+int tune_processors(void);
+
+/**
+ * @brief Plays many games by the bot with every weight set and summarizes
+ * them.
+ *
+ * The games of all sets are split evenly between the workers; a worker that
+ * has played all its games takes the second half of the remaining games of
+ * another worker (work stealing), so slow games do not leave threads idle.
+ * Every worker owns its game context and one bot per weight set, and every
+ * game is a pure function of its seed and weights (`TIMER_FIXED_STEP` with
+ * `TUNE_STEP_MS`), so the reports do not depend on the number of threads.
+ *
+ * @param config   The settings.
+ * @param weights  The weight sets.
+ * @param count    The number of weight sets.
+ * @param reports  The reports to fill, one per weight set.
+ * @param stats    The counters of the scheduler to fill or `NULL`.
+ *
+ * @return 0 on success, 1 if the settings are invalid or there is not enough
+ * memory.
+ */
+int tune_run(const TuneConfig_t *config, const BotWeights_t *weights,
+             int count, TuneReport_t *reports, TuneStats_t *stats);
+
+#endif
@@ -1,36 +1,132 @@
 #include "frontend.h"
 
-bool game_loop() {
+// ожидание ввода до ближайшего события: сдвига фигуры, такта для нажатой
+// клавиши или кадра, который еще нельзя было вывести
+static int wake_time(TetrisContext *ctx, bool pending, bool dirty,
+                     double frame_left, bool demo) {
+  int wait = tetris_sleep_time(ctx, TICK_MAX_CATCH_UP);
+  int tick = tetris_tick_wait(ctx);
+  if (pending) {
+    wait = tick;
+  }
+  if (dirty) {
+    int frame = frame_left > 0 ? (int)ceil(frame_left) : 0;
+    if (wait < 0 || frame < wait) wait = frame;
+  }
+  if (demo && (wait < 0 || wait > DEMO_DELAY)) {
+    wait = DEMO_DELAY;
+  }
+  return wait;
+}
+
+bool game_loop(Bot_t *bot) {
   init_ncurses();
-  bool game_flag = TRUE;
+  bool game_flag = TRUE, dirty = TRUE, started = FALSE, pending = FALSE;
   UserAction_t action = 0;
   GameInfo_t game = {
       0};  // локальная переменная, не имеющая доступа к статической
+  TetrisContext *ctx = tetris_default();
+  unsigned long version = tetris_version(ctx);
+  Screen_t screen = {0};  // на экран еще ничего не выведено
   WINDOW *field =
       newwin(FIELD_HEIGHT, FIELD_WIDTH * 2, START_POSITION, START_POSITION);
   WINDOW *info =
       newwin(FIELD_HEIGHT, INFO_WIDTH, START_POSITION, INFO_START_POSITION);
+  Timer_t clock;  // настоящее время, которое превращается в такты игры
+  timer_init(&clock, TIMER_REAL, 0);
+  double frame_ms = 1000.0 / FRAME_RATE, last = timer_now(&clock);
+  double drawn = last - frame_ms;
   while (game_flag) {
     if (game.pause == terminate || game.pause == game_over) {
       game_flag = FALSE;
     }
-    print_game(game, field, info);
-    process_signal(&action);
-    userInput(action, 0);
+    double now = timer_now(&clock);
+    if ((dirty && now - drawn >= frame_ms) || !game_flag) {
+      print_game(game, tetris_frame(ctx), field, info, &screen);
+      drawn = now, dirty = FALSE;
+    }
     if (game_flag) {
-      game = updateCurrentState();
+      int wait = wake_time(ctx, pending, dirty, drawn + frame_ms - now, bot);
+      action = Up;
+      if (pending) {
+        napms(wait);  // одна клавиша на такт, следующие ждут в буфере
+      } else {
+        timeout(wait);
+        process_signal(&action);
+        if (bot && action == Up && game.pause != pause) {
+          action = started ? bot_action(bot, ctx) : Start;
+        }
+      }
+      if (action != Up) {
+        userInput(action, 0);  // клавиша обрабатывается следующим тактом
+        started = pending = TRUE;
+      }
+      now = timer_now(&clock);
+      if (started) {
+        int ticks = 0;
+        game = tetris_advance(ctx, now - last, TICK_MAX_CATCH_UP, &ticks);
+        pending = pending && ticks == 0;
+        dirty = dirty || version != tetris_version(ctx);
+        version = tetris_version(ctx);
+      }
+      last = now;
     }
   }
   if (game.pause == game_over) {
     game_flag = TRUE;
+    userInput(Up, 0);  // следующий ввод начнет новую игру
   }
   endwin();  // конец работы с ncurses
   return game_flag;
 }
 
+// события записи применяются, когда до них доходит настоящее время
+void replay_loop(const Replay_t *replay) {
+  init_ncurses();
+  TetrisContext *ctx = tetris_default();
+  replay_prepare(replay, ctx);
+  GameInfo_t game = {0};
+  Screen_t screen = {0};
+  WINDOW *field =
+      newwin(FIELD_HEIGHT, FIELD_WIDTH * 2, START_POSITION, START_POSITION);
+  WINDOW *info =
+      newwin(FIELD_HEIGHT, INFO_WIDTH, START_POSITION, INFO_START_POSITION);
+  Timer_t clock;
+  timer_init(&clock, TIMER_REAL, 0);
+  double start = timer_now(&clock);
+  ReplayCursor_t cursor = {0};
+  ReplayEvent_t event;
+  bool playing = replay_next(replay, &cursor, &event), redraw = TRUE;
+  UserAction_t action = Up;
+  while (playing) {
+    if (redraw) {
+      print_game(game, tetris_frame(ctx), field, info, &screen);
+    }
+    double left = (double)event.time - (timer_now(&clock) - start);
+    timeout(left > 0 ? (int)ceil(left) : 0);
+    process_signal(&action);
+    redraw = FALSE;
+    if (action == Terminate) {
+      playing = FALSE;
+    } else if (timer_now(&clock) - start >= (double)event.time) {
+      unsigned long version = tetris_version(ctx);
+      game = replay_apply(ctx, &event);
+      redraw = version != tetris_version(ctx);
+      playing = replay_next(replay, &cursor, &event);
+    }
+  }
+  print_game(game, tetris_frame(ctx), field, info, &screen);
+  if (action != Terminate) {
+    timeout(-1);
+    getch();
+  }
+  endwin();
+}
+
 // преобразуем сигнал от пользователя в действие
 void process_signal(UserAction_t *action) {
   int signal = getch();
+  STATS_ADD(polls, 1);
   switch (signal) {
     case KEY_DOWN:
       *action = Down;
@@ -59,37 +155,69 @@ void process_signal(UserAction_t *action) {
   }
 }
 
-void print_game(GameInfo_t game, WINDOW *field, WINDOW *info) {
-  werase(info);
-  werase(field);
-  box(field, 0, 0);
-  box(info, 0, 0);
+// экран, который соответствует состоянию игры
+int screen_mode(GameInfo_t game) {
+  int mode = SCREEN_PLAY;
   if (game.pause == ready_to_start) {
-    print_start_status(field);
+    mode = SCREEN_START;
   } else if (game.pause == pause) {
-    print_pause_status(field);
+    mode = SCREEN_PAUSE;
   } else if (game.pause == terminate || game.pause == game_over) {
-    print_end_status(field, game);
-  } else {
-    print_game_field(game, field);
-    if (game.pause == game_over) {
-      napms(1000);
+    mode = SCREEN_END;
+  }
+  return mode;
+}
+
+// при смене экрана окна перерисовываются полностью, иначе выводятся только
+// изменившиеся клетки поля и значения в окне информации
+void print_game(GameInfo_t game, const Frame_t *frame, WINDOW *field,
+                WINDOW *info, Screen_t *screen) {
+  STATS_BEGIN(start);
+  STATS_FRAME(start);
+  int mode = screen_mode(game);
+  if (mode != screen->mode) {
+    werase(info);
+    werase(field);
+    box(field, 0, 0);
+    box(info, 0, 0);
+    reset_screen(screen, mode);
+    if (mode == SCREEN_START) {
+      print_start_status(field);
+      print_start_info(info);
+    } else if (mode == SCREEN_PAUSE) {
+      print_pause_status(field);
+      print_info_labels(info);
+    } else if (mode == SCREEN_END) {
+      print_end_status(field, game);
+    } else {
+      print_info_labels(info);
     }
   }
-  if (game.pause == ready_to_start) {
-    print_start_info(info);
-  } else if (game.pause != game_over && game.pause != terminate) {
-    print_info(info, game);
+  if (mode == SCREEN_PLAY) {
+    print_game_field(frame, field, screen);
+  }
+  if (mode == SCREEN_PLAY || mode == SCREEN_PAUSE) {
+    print_info(info, game, screen);
   }
-  wrefresh(info);
-  wrefresh(field);
-  if (game.pause == terminate || game.pause == game_over) {
+  wnoutrefresh(info);
+  wnoutrefresh(field);
+  doupdate();
+  STATS_END(renders, start);
+  if (mode == SCREEN_END) {
     napms(1000);
     delwin(field);
     delwin(info);
   }
 }
 
+// все клетки окна поля пустые, значения в окне информации не выведены
+void reset_screen(Screen_t *screen, int mode) {
+  screen->mode = mode;
+  memset(screen->cells, EMPTY_PLACE, sizeof(screen->cells));
+  screen->next_figure = -1, screen->score = -1, screen->high_score = -1,
+  screen->level = -1;
+}
+
 void print_start_status(WINDOW *field) {
   mvwprintw(field, 9, 4, "Press ENTER to");
   mvwprintw(field, 11, 4, "start the game");
@@ -127,27 +255,42 @@ void print_start_info(WINDOW *info) {
   mvwprintw(info, 22, 2, "enter - start");
 }
 
-void print_game_field(GameInfo_t game, WINDOW *field) {
-  for (int i = 1; i < FIELD_HEIGHT; ++i) {
-    for (int j = 0; j < FIELD_WIDTH * 2; ++j) {
-      if (game.field[i][j] != EMPTY_PLACE) {
-        if (game.field[i][j] > 0 && game.field[i][j] < 8) {
-          wattron(field, COLOR_PAIR(game.field[i][j]));
-          mvwprintw(field, i, j * 2 + 1, "[]");
-          wattroff(field, COLOR_PAIR(game.field[i][j]));
-        } else {
-          wattron(field, COLOR_PAIR(game.next[2][2]));
-          mvwprintw(field, i, j * 2 + 1, "[]");
-          wattroff(field, COLOR_PAIR(game.next[2][2]));
-        }
+// нулевой ряд кадра находится над видимым полем и не выводится
+void print_game_field(const Frame_t *frame, WINDOW *field, Screen_t *screen) {
+  for (int k = FRAME_WIDTH; k < FRAME_SIZE; ++k) {
+    int color = frame->cells[k];
+    if (color != screen->cells[k]) {
+      int i = k / FRAME_WIDTH, j = k % FRAME_WIDTH;
+      screen->cells[k] = (unsigned char)color;
+      if (color == EMPTY_PLACE) {
+        mvwprintw(field, i, j * 2 + 1, "  ");
+      } else if (color == FRAME_GHOST) {  // место падения фигуры
+        mvwprintw(field, i, j * 2 + 1, "::");
+      } else {
+        wattron(field, COLOR_PAIR(color));
+        mvwprintw(field, i, j * 2 + 1, "[]");
+        wattroff(field, COLOR_PAIR(color));
       }
     }
   }
 }
 
-void print_info(WINDOW *info, GameInfo_t game) {
+void print_info_labels(WINDOW *info) {
   mvwprintw(info, 1, 2, "Next figure");
-  if (game.pause != ready_to_start) {
+  mvwprintw(info, 6, 2, "High score:");
+  mvwprintw(info, 14, 2, "p - pause");
+  mvwprintw(info, 16, 2, "space - ");
+  mvwprintw(info, 18, 2, "rotation figure");
+  mvwprintw(info, 20, 2, "q - quit");
+  mvwprintw(info, 22, 2, "enter - start");
+}
+
+void print_info(WINDOW *info, GameInfo_t game, Screen_t *screen) {
+  if (game.next[3][2] != screen->next_figure) {
+    screen->next_figure = game.next[3][2];
+    for (int i = 2; i < 6; ++i) {
+      mvwprintw(info, i, 1, "%*s", INFO_WIDTH - 2, "");
+    }
     for (int i = 0; i < FIGURE_PART; ++i) {
       int x = game.next[i][0] + 5;
       int y = game.next[i][1];
@@ -156,15 +299,18 @@ void print_info(WINDOW *info, GameInfo_t game) {
       wattroff(info, COLOR_PAIR(game.next[3][2]));
     }
   }
-  mvwprintw(info, 6, 2, "High score:");
-  mvwprintw(info, 8, 2, "%d", game.high_score);
-  mvwprintw(info, 10, 2, "Score: %d", game.score);
-  mvwprintw(info, 12, 2, "Level: %d", game.level);
-  mvwprintw(info, 14, 2, "p - pause");
-  mvwprintw(info, 16, 2, "space - ");
-  mvwprintw(info, 18, 2, "rotation figure");
-  mvwprintw(info, 20, 2, "q - quit");
-  mvwprintw(info, 22, 2, "enter - start");
+  if (game.high_score != screen->high_score) {
+    screen->high_score = game.high_score;
+    mvwprintw(info, 8, 2, "%-*d", INFO_WIDTH - 4, game.high_score);
+  }
+  if (game.score != screen->score) {
+    screen->score = game.score;
+    mvwprintw(info, 10, 2, "Score: %-*d", INFO_WIDTH - 11, game.score);
+  }
+  if (game.level != screen->level) {
+    screen->level = game.level;
+    mvwprintw(info, 12, 2, "Level: %-*d", INFO_WIDTH - 11, game.level);
+  }
 }
 
 void init_ncurses(void) {
@@ -173,7 +319,6 @@ void init_ncurses(void) {
   curs_set(0);            // скрывает курсор
   keypad(stdscr, TRUE);   // ввод клавиш вверх, вниз и тд
   setlocale(LC_ALL, "");  // использование локализованных настроек
-  nodelay(stdscr, TRUE);  //
   start_color();          // инициализация цветовой системы
   init_pair(1, COLOR_RED, COLOR_BLACK);
   init_pair(2, COLOR_GREEN, COLOR_BLACK);
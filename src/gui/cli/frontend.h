@@ -3,13 +3,99 @@
 #include <locale.h>
 #include <math.h>
 #include <ncurses.h>
+#include <string.h>
 
+#include "../../brick_game/tetris/bot.h"
 #include "../../brick_game/tetris/common.h"
+#include "../../brick_game/tetris/replay.h"
+#include "../../brick_game/tetris/stats.h"
 #include "./../../tetris.h"
 
+/**
+ * @brief The longest wait for a key in the demo mode (ms), so the bot makes
+ * its moves at a speed a viewer can follow.
+ */
+#define DEMO_DELAY 60
+
+/**
+ * @brief The number of game ticks per second.
+ */
+#define TICK_RATE 100
+
+/**
+ * @brief The most ticks made at once after the program was stalled.
+ */
+#define TICK_MAX_CATCH_UP 25
+
+/**
+ * @brief The most frames drawn per second.
+ */
+#define FRAME_RATE 60
+
+/**
+ * @brief The number of search threads of the bot in the demo mode.
+ */
+#define DEMO_THREADS 2
+
+/**
+ * @brief The time between dumps of the statistics (ms).
+ */
+#define STATS_DUMP_PERIOD 1000
+
+/**
+ * @brief Screens of the interface.
+ *
+ * `SCREEN_NONE` means that nothing has been drawn yet, so the first call of
+ * `print_game` always redraws the windows completely.
+ */
+typedef enum {
+  SCREEN_NONE,
+  SCREEN_START,
+  SCREEN_PAUSE,
+  SCREEN_END,
+  SCREEN_PLAY
+} Screen_mode_t;
+
+/**
+ * @brief What is currently drawn in the ncurses windows.
+ *
+ * `print_game` compares the new game state with this structure and redraws
+ * only the cells and values that have changed.
+ *
+ * @var mode         The screen that is drawn (`Screen_mode_t`).
+ * @var cells        The color pair of every drawn cell of the field, in the
+ * order of `Frame_t::cells` (`EMPTY_PLACE` for an empty cell).
+ * @var next_figure  The color of the drawn next figure (-1 if not drawn).
+ * @var score        The drawn score (-1 if not drawn).
+ * @var high_score   The drawn high score (-1 if not drawn).
+ * @var level        The drawn level (-1 if not drawn).
+ */
+typedef struct {
+  int mode;
+  unsigned char cells[FRAME_SIZE];
+  int next_figure;
+  int score;
+  int high_score;
+  int level;
+} Screen_t;
+
 /**
  * @brief The main game loop.
  *
+ * In the demo mode (`bot` is not `NULL`) the game is played by the bot: when
+ * no key is pressed within `DEMO_DELAY` ms, the action of the bot is used.
+ * The keys still work, so the viewer can pause or quit the game.
+ *
+ * The game runs on fixed ticks (`tetris_set_tick_rate`, `TICK_RATE` by
+ * default): the loop gives the passed wall time to `tetris_advance`, so the
+ * game speed does not depend on how often the screen is drawn. After a stall
+ * at most `TICK_MAX_CATCH_UP` ticks are made at once, and the loop itself
+ * never sleeps longer than that (`tetris_sleep_time`). A key is handled by the
+ * next tick, and the next key is read only after it, so every tick gets at
+ * most one key; the screen is drawn only when the game changed and at most
+ * `FRAME_RATE` times per second. A recorded game (see `tetris_record`) is
+ * replayed exactly, because its times are whole ticks.
+ *
  * The `game_loop` function represents the main game loop, which
  * manages game logic, graphics rendering, and user input processing.
  *
@@ -24,24 +110,46 @@
  *     - If the game is in the `terminate` or `game_over` state,
  *       it sets `game_flag` to `FALSE` to terminate the game loop.
  *     - Calls the `print_game` function to display the current game state in
- * the `field` and `info` windows.
+ * the `field` and `info` windows, only if the ticks changed it
+ * (`tetris_version`) and the previous frame is older than `1000 / FRAME_RATE`
+ * ms.
+ *     - Waits for user input no longer than the time until the next shift of
+ * the figure by the timer (`tetris_wait_time`), the next tick when a key
+ * waits for it (`tetris_tick_wait`) or the next frame when one is due; if the
+ * game is not running, it waits for a key without a timeout. The loop does
+ * not spin while the player is idle.
  *     - Calls the `process_signal` function to process user input and
  *       determine the action (`action`).
- *     - Calls the `userInput` function to handle the user's action and
- *       change the game state.
- *     - If `game_flag` remains `TRUE` (the game is not over), it calls the
- *       `updateCurrentState` function to update the game state.
+ *     - Calls the `userInput` function to pass a pressed key to the game.
+ *     - If the game was started, it calls `tetris_advance` with the time since
+ * the previous call to run the ticks of the game.
+ *
+ * @param bot  The automatic player for the demo mode or `NULL` to play from
+ * the keyboard.
  *
  * @return `TRUE` if the game ended in the `game_over` state, `FALSE` otherwise.
  */
-bool game_loop();
+bool game_loop(Bot_t *bot);
+
+/**
+ * @brief Shows a recorded game at the speed it was played.
+ *
+ * The game is played on the default context (`replay_prepare`): every event
+ * of the replay is applied when the wall clock reaches its time. The `q` key
+ * stops the playback; after the last event the final state stays on the
+ * screen until any key is pressed.
+ *
+ * @param replay  The replay.
+ */
+void replay_loop(const Replay_t *replay);
 
 /**
  * @brief Processes user input and determines the corresponding action.
  *
  * The `process_signal` function reads a character entered by the user and,
  * based on that character, determines the corresponding action, which is then
- * passed for further processing.
+ * passed for further processing. `getch` waits for the input as long as it was
+ * set by `timeout`; if there is no input, the action is `Up`.
  *
  * The function performs the following actions:
  *   - Reads a character entered by the user using the `getch` function.
@@ -65,18 +173,40 @@ void process_signal(UserAction_t *action);
  * ncurses windows (`field` and `info`), depending on the current game state.
  *
  * The function performs the following actions:
- *   - Clears the windows and draws borders.
- *   - Depending on the current game state (`game.pause`), draws the
- * corresponding game state or the field with figures, updates or deletes
- * windows, and makes a delay.
+ *   - If the screen (`screen_mode`) has changed, clears the windows, draws
+ * borders and the static text of the new screen.
+ *   - During the game, draws only the cells of the field and the values of the
+ * game information that differ from `screen`.
+ *   - Sends the changes to the terminal with one `doupdate` call; on the end
+ * screen makes a delay and deletes the windows.
  *
  * @param game    The `GameInfo_t` structure containing game information.
+ * @param frame   The last frame of the game (`tetris_frame`).
  * @param field   A pointer to the ncurses window intended for displaying the
  * game field.
  * @param info    A pointer to the ncurses window intended for displaying game
  * information.
+ * @param screen  What is currently drawn in the windows; it is updated.
+ */
+void print_game(GameInfo_t game, const Frame_t *frame, WINDOW *field,
+                WINDOW *info, Screen_t *screen);
+
+/**
+ * @brief Returns the screen corresponding to the game state.
+ *
+ * @param game The `GameInfo_t` structure containing game information.
+ *
+ * @return The screen (`Screen_mode_t`).
  */
-void print_game(GameInfo_t game, WINDOW *field, WINDOW *info);
+int screen_mode(GameInfo_t game);
+
+/**
+ * @brief Marks all the cells and values of the windows as not drawn.
+ *
+ * @param screen  What is drawn in the windows.
+ * @param mode    The new screen.
+ */
+void reset_screen(Screen_t *screen, int mode);
 
 /**
  * @brief Displays a start game message in the specified ncurses window.
@@ -131,16 +261,25 @@ void print_start_info(WINDOW *info);
 /**
  * @brief Displays the game field in the specified ncurses window.
  *
- * The `print_game_field` function draws the contents of the game field in the
- * specified ncurses window (`field`). The colors of the field cells depend on
- * their values.
+ * The `print_game_field` function walks the cells of the frame in one pass
+ * and draws in the specified ncurses window (`field`) only the cells that
+ * differ from `screen`. The colors of the field cells depend on their values;
+ * the cells where the falling figure would land are drawn as "::".
  *
- * @param game  The `GameInfo_t` structure containing game information,
- * including the game field.
- * @param field A pointer to the ncurses window in which the game field will be
+ * @param frame  The frame of the game field.
+ * @param field  A pointer to the ncurses window in which the game field will
+ * be displayed.
+ * @param screen What is currently drawn in the window; it is updated.
+ */
+void print_game_field(const Frame_t *frame, WINDOW *field, Screen_t *screen);
+
+/**
+ * @brief Displays the labels and control keys of the game information window.
+ *
+ * @param info A pointer to the ncurses window in which the information will be
  * displayed.
  */
-void print_game_field(GameInfo_t game, WINDOW *field);
+void print_info_labels(WINDOW *info);
 
 /**
  * @brief Displays game information (next figure, score, high score, level) in
@@ -148,13 +287,14 @@ void print_game_field(GameInfo_t game, WINDOW *field);
  *
  * The `print_info` function displays information about the current game state
  * in the specified ncurses window (`info`). Displays the next figure, the
- * current score, high score, level, and control keys.
+ * current score, high score and level if they differ from `screen`.
  *
- * @param info A pointer to the ncurses window in which the information will be
- * displayed.
- * @param game The `GameInfo_t` structure containing game information.
+ * @param info   A pointer to the ncurses window in which the information will
+ * be displayed.
+ * @param game   The `GameInfo_t` structure containing game information.
+ * @param screen What is currently drawn in the window; it is updated.
  */
-void print_info(WINDOW *info, GameInfo_t game);
+void print_info(WINDOW *info, GameInfo_t game, Screen_t *screen);
 
 /**
  * @brief Initializes the ncurses library and configures terminal settings.
@@ -166,8 +306,6 @@ void print_info(WINDOW *info, GameInfo_t game);
  *   - Enables the processing of special keys (arrows, Home, End, Page Up, Page
  * Down, etc.).
  *   - Sets localized settings for correct handling of characters and text.
- *   - Sets non-blocking mode for `stdscr` so that `getch` returns `ERR` if
- * there is no input.
  *   - Initializes the ncurses color system and defines color pairs for use in
  * the game.
  */
@@ -4,15 +4,33 @@
  */
 
 #include <check.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 
 #include "./../brick_game/tetris/backend.h"
+#include "./../brick_game/tetris/batch.h"
+#include "./../brick_game/tetris/bot.h"
 #include "./../brick_game/tetris/common.h"
+#include "./../brick_game/tetris/feed.h"
+#include "./../brick_game/tetris/net.h"
+#include "./../brick_game/tetris/placement.h"
+#include "./../brick_game/tetris/pool.h"
+#include "./../brick_game/tetris/replay.h"
+#include "./../brick_game/tetris/server.h"
+#include "./../brick_game/tetris/snapshot.h"
+#include "./../brick_game/tetris/stats.h"
+#include "./../brick_game/tetris/tune.h"
+
+static int frame_cell(TetrisContext *ctx, int i, int j) {
+  build_frame(ctx);
+  return tetris_frame(ctx)->cells[i * FRAME_WIDTH + j];
+}
 
 START_TEST(test1) {
   GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
@@ -32,7 +50,8 @@ START_TEST(test1) {
   game->field[20][3] = 1, game->field[20][4] = 1, game->field[20][5] = 1,
   game->field[20][6] = 1, game->field[20][7] = 7, game->field[20][8] = 7,
   game->field[20][9] = 7;
-  check_field(game);
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
   ck_assert_int_eq(game->score, THREE_LINES);
   ck_assert_int_eq(game->level, 2);
   for (int i = 0; i < FIELD_HEIGHT - 3; ++i) {
@@ -57,8 +76,8 @@ END_TEST
 
 START_TEST(test2) {
   GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
@@ -68,7 +87,8 @@ START_TEST(test2) {
   game->field[20][3] = 1, game->field[20][4] = 1, game->field[20][5] = 1,
   game->field[20][6] = 1, game->field[20][7] = 7, game->field[20][8] = 7,
   game->field[20][9] = 7;
-  check_field(game);
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
   ck_assert_int_eq(game->score, ONE_LINE);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
@@ -81,8 +101,8 @@ END_TEST
 
 START_TEST(test3) {
   GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
@@ -95,7 +115,8 @@ START_TEST(test3) {
   game->field[20][2] = 2, game->field[20][3] = 1, game->field[20][4] = 1,
   game->field[20][5] = 1, game->field[20][6] = 1, game->field[20][7] = 7,
   game->field[20][8] = 7, game->field[20][9] = 7;
-  check_field(game);
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
   ck_assert_int_eq(game->score, TWO_LINES);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
@@ -108,8 +129,8 @@ END_TEST
 
 START_TEST(test4) {
   GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
@@ -117,10 +138,11 @@ START_TEST(test4) {
   }
   for (int i = 17; i < FIELD_HEIGHT - 1; ++i) {
     for (int j = 0; j < FIELD_WIDTH - 1; ++j) {
-      game->field[i][j] = 5 + MOVING_PLACE + 1;
+      game->field[i][j] = 5 + 1;
     }
   }
-  check_field(game);
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
   ck_assert_int_eq(game->score, FOUR_LINES);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
@@ -134,7 +156,8 @@ END_TEST
 START_TEST(test5) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 4;
   figure->x = 1, figure->y = 0, figure->rotation = 0;
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
@@ -142,19 +165,11 @@ START_TEST(test5) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[1][5] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][3] = MOVING_PLACE + figure->figure + 1;
-  shift_figure(figure, game);
-  ck_assert_int_eq(game->field[1][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[1][5], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][3], EMPTY_PLACE);
-
-  ck_assert_int_eq(game->field[2][4], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][5], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][4], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][3], MOVING_PLACE + figure->figure + 1);
+  shift_figure(ctx);
+  ck_assert_int_eq(frame_cell(ctx, 2, 4), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 5), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 4), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -162,18 +177,15 @@ END_TEST
 START_TEST(test6) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
   figure->figure = 0, figure->x = 19, figure->y = 0;
-  game->field[19][3] = MOVING_PLACE + figure->figure + 1,
-  game->field[19][4] = MOVING_PLACE + figure->figure + 1,
-  game->field[19][5] = MOVING_PLACE + figure->figure + 1,
-  game->field[19][6] = MOVING_PLACE + figure->figure + 1;
-  fix_figure(figure, game);
+  fix_figure(ctx);
   ck_assert_int_eq(game->field[19][3], figure->figure + 1);
   ck_assert_int_eq(game->field[19][4], figure->figure + 1);
   ck_assert_int_eq(game->field[19][5], figure->figure + 1);
@@ -184,7 +196,8 @@ END_TEST
 START_TEST(test7) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 6;
   figure->x = 1, figure->y = 0, figure->rotation = 0;
   game->pause = fall;
@@ -193,17 +206,9 @@ START_TEST(test7) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][3] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][5] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = fall;
   updateCurrentState();
-  ck_assert_int_eq(game->field[1][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][3], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][5], EMPTY_PLACE);
   ck_assert_int_eq(game->field[19][4], 7);
   ck_assert_int_eq(game->field[20][4], 7);
   ck_assert_int_eq(game->field[20][3], 7);
@@ -215,7 +220,8 @@ END_TEST
 START_TEST(test8) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 5;
   figure->x = 1, figure->y = 0, figure->rotation = 0;
   game->pause = rotation;
@@ -224,22 +230,16 @@ START_TEST(test8) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[1][3] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][5] = MOVING_PLACE + figure->figure + 1;
 
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
-  ck_assert_int_eq(game->field[1][3], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][5], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[1][4], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][4], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][3], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][3], MOVING_PLACE + figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 1, 4), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 4), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 3), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -247,7 +247,8 @@ END_TEST
 START_TEST(test9) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 6;
   figure->x = 1, figure->y = 0, figure->rotation = 0;
   game->pause = move_right;
@@ -256,23 +257,15 @@ START_TEST(test9) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][3] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][5] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = move_right;
   updateCurrentState();
   game->pause = move_right;
   updateCurrentState();
-  ck_assert_int_eq(game->field[1][7], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[1][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][6], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][7], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][8], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][3], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][5], EMPTY_PLACE);
+  ck_assert_int_eq(frame_cell(ctx, 1, 7), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 6), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 7), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 8), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -280,7 +273,8 @@ END_TEST
 START_TEST(test10) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 6;
   figure->x = 1, figure->y = 0, figure->rotation = 0;
   game->pause = move_left;
@@ -289,23 +283,15 @@ START_TEST(test10) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][3] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][4] = MOVING_PLACE + figure->figure + 1;
-  game->field[2][5] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = move_left;
   updateCurrentState();
   game->pause = move_left;
   updateCurrentState();
-  ck_assert_int_eq(game->field[1][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][0], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][2], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][3], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][4], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[2][5], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[1][4], EMPTY_PLACE);
+  ck_assert_int_eq(frame_cell(ctx, 1, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 0), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 2), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -313,7 +299,8 @@ END_TEST
 START_TEST(test11) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 0;
   figure->x = 3, figure->y = -5, figure->rotation = 1;
   game->pause = rotation;
@@ -322,23 +309,15 @@ START_TEST(test11) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[2][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[3][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[4][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[5][0] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
-  ck_assert_int_eq(game->field[2][0], EMPTY_PLACE);
-
-  ck_assert_int_eq(game->field[4][0], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[5][0], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[3][0], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][2], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[3][3], MOVING_PLACE + figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 0), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 2), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 3, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -346,7 +325,8 @@ END_TEST
 START_TEST(test12) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 0;
   figure->x = 2, figure->y = -4, figure->rotation = 1;
   game->pause = rotation;
@@ -355,23 +335,15 @@ START_TEST(test12) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[1][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[2][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[3][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[4][1] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
-  ck_assert_int_eq(game->field[1][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[3][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[4][1], EMPTY_PLACE);
-
-  ck_assert_int_eq(game->field[2][0], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][2], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[2][3], MOVING_PLACE + figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 0), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 2), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 2, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -379,7 +351,8 @@ END_TEST
 START_TEST(test13) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 0;
   figure->x = 3, figure->y = -3, figure->rotation = 3;
   game->pause = rotation;
@@ -388,23 +361,15 @@ START_TEST(test13) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[2][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[3][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[4][1] = MOVING_PLACE + figure->figure + 1,
-  game->field[5][1] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
-  ck_assert_int_eq(game->field[2][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[3][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[5][1], EMPTY_PLACE);
-
-  ck_assert_int_eq(game->field[4][0], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][2], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][3], MOVING_PLACE + figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 0), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 2), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -412,7 +377,8 @@ END_TEST
 START_TEST(test14) {
   GameInfo_t *game = set_game_info();
   Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   figure->figure = 0;
   figure->x = 3, figure->y = -4, figure->rotation = 3;
   game->pause = rotation;
@@ -421,23 +387,15 @@ START_TEST(test14) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
-  game->field[2][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[3][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[4][0] = MOVING_PLACE + figure->figure + 1,
-  game->field[5][0] = MOVING_PLACE + figure->figure + 1;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
   game->pause = rotation;
   updateCurrentState();
-  ck_assert_int_eq(game->field[2][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[3][1], EMPTY_PLACE);
-  ck_assert_int_eq(game->field[5][1], EMPTY_PLACE);
-
-  ck_assert_int_eq(game->field[4][0], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][1], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][2], MOVING_PLACE + figure->figure + 1);
-  ck_assert_int_eq(game->field[4][3], MOVING_PLACE + figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 0), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 1), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 2), figure->figure + 1);
+  ck_assert_int_eq(frame_cell(ctx, 4, 3), figure->figure + 1);
   free_game(game);
 }
 END_TEST
@@ -575,19 +533,1381 @@ END_TEST
 
 START_TEST(test29) {
   GameInfo_t *game = set_game_info();
-  Figure_position *figure = set_figure_info();
-  init_game(game, figure);
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
   for (int i = 0; i < FIELD_HEIGHT; ++i) {
     for (int j = 0; j < FIELD_WIDTH; ++j) {
       game->field[i][j] = EMPTY_PLACE;
     }
   }
   game->field[0][5] = 3;
-  check_field(game);
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
   ck_assert_int_eq(game->pause, game_over);
 }
 END_TEST
 
+START_TEST(test30) {
+  GameInfo_t *game = set_game_info();
+  Figure_position *figure = set_figure_info();
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
+  Board_t *board = set_board_info();
+  game->field[20][3] = 2, game->field[19][9] = 5;
+  board_load(board, game->field);
+  ck_assert_int_eq(board->rows[20], 1 << 3);
+  ck_assert_int_eq(board->rows[19], 1 << 9);
+  figure->figure = 0, figure->x = 19, figure->y = 0, figure->rotation = 0;
+  ck_assert_int_eq(can_move(ctx, MOVE_DOWN), false);
+  ck_assert_int_eq(can_move(ctx, MOVE_LEFT), true);
+  board->rows[18] = BOARD_FULL_ROW;
+  board_remove_row(board, 19);
+  ck_assert_int_eq(board->rows[19], BOARD_FULL_ROW);
+  ck_assert_int_eq(board->rows[20], 1 << 3);
+  ck_assert_int_eq(board->rows[0], 0);
+  free_game(game);
+}
+END_TEST
+
+START_TEST(test31) {
+  for (int f = 0; f < COUNT_OF_FIGURES; ++f) {
+    for (int r = 0; r < COUNT_OF_ROTATIONS; ++r) {
+      const Shape_t *shape = shape_get(f, r);
+      uint16_t rows[SHAPE_SIZE] = {0};
+      for (int i = 0; i < FIGURE_PART; ++i) {
+        int x = shape->cells[i][0], y = shape->cells[i][1];
+        ck_assert_int_ge(x, shape->min_row);
+        ck_assert_int_le(x, shape->max_row);
+        ck_assert_int_ge(y, shape->min_col);
+        ck_assert_int_le(y, shape->max_col);
+        ck_assert_int_ge(shape->bottom[y - shape->min_col], x);
+        ck_assert_int_le(shape->top[y - shape->min_col], x);
+        rows[x - shape->min_row] |= (uint16_t)(1u << y);
+      }
+      uint16_t left = 0;
+      for (int i = 0; i < SHAPE_SIZE; ++i) {
+        ck_assert_int_eq(shape->rows[i], rows[i]);
+        left |= shape_row_mask(shape, i, -shape->min_col);
+      }
+      ck_assert_int_eq(left & 1u, 1u);
+    }
+  }
+  ck_assert_int_eq(figures_mass(0, 1, 0, 0), -1);
+  ck_assert_int_eq(figures_mass(6, 2, 3, 1), 4);
+}
+END_TEST
+
+START_TEST(test32) {
+  TetrisContext *first = tetris_create();
+  TetrisContext *second = tetris_create();
+  ck_assert_ptr_nonnull(first);
+  ck_assert_ptr_nonnull(second);
+  tetris_input(first, Start, 0);
+  tetris_input(second, Up, 0);
+  ck_assert_int_eq(first->game.pause, shift);
+  ck_assert_int_eq(second->game.pause, ready_to_start);
+  first->figure.figure = 3, first->figure.x = 1, first->figure.y = 0;
+  first->game.pause = move_left;
+  tetris_step(first);
+  ck_assert_int_eq(first->figure.y, -1);
+  ck_assert_int_eq(second->figure.y, 0);
+  tetris_input(first, Terminate, 0);
+  GameInfo_t info = tetris_step(first);
+  ck_assert_int_eq(info.pause, terminate);
+  ck_assert_ptr_null(first->game.field);
+  tetris_step(first);
+  tetris_destroy(first);
+  tetris_destroy(second);
+}
+END_TEST
+
+START_TEST(test33) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  int x = ctx->figure.x;
+  for (int i = 0; i < 10; ++i) {
+    tetris_input(ctx, Up, 0);
+    tetris_step(ctx);
+  }
+  ck_assert_int_eq(ctx->figure.x, x);
+  tetris_advance_time(ctx, START_TIMEOUT);
+  tetris_input(ctx, Up, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(ctx->figure.x, x + 1);
+  tetris_input(ctx, Down, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(ctx->pieces, 1);
+  ck_assert_int_eq(ctx->lines, 0);
+  ck_assert_int_eq(ctx->game.high_score, 0);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test34) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  ck_assert_int_eq(tetris_wait_time(ctx), -1);
+  tetris_input(ctx, Up, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(tetris_wait_time(ctx), -1);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  ck_assert_int_gt(tetris_wait_time(ctx), 0);
+  ck_assert_int_le(tetris_wait_time(ctx), START_TIMEOUT);
+  unsigned long version = tetris_version(ctx);
+  tetris_input(ctx, Up, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(tetris_version(ctx), version);
+  tetris_input(ctx, Left, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(tetris_version(ctx), version + 1);
+  tetris_advance_time(ctx, START_TIMEOUT);
+  ck_assert_int_eq(tetris_wait_time(ctx), 0);
+  tetris_input(ctx, Pause, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(tetris_wait_time(ctx), -1);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test35) {
+  Timer_t timer = {0};
+  ck_assert_int_eq(timer.source, TIMER_REAL);
+  double start = timer_now(&timer);
+  timer_advance(&timer, 100000);
+  ck_assert(timer_now(&timer) - start < 100000);
+  timer_init(&timer, TIMER_FIXED_STEP, 16);
+  timer_tick(&timer);
+  timer_tick(&timer);
+  timer_advance(&timer, 4);
+  ck_assert_double_eq_tol(timer_now(&timer), 36, 1e-9);
+  timer_init(&timer, TIMER_VIRTUAL, 16);
+  timer_tick(&timer);
+  ck_assert_double_eq_tol(timer_now(&timer), 0, 1e-9);
+
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 100);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  int x = ctx->figure.x;
+  for (int i = 0; i < 10; ++i) {
+    tetris_input(ctx, Up, 0);
+    tetris_step(ctx);
+  }
+  ck_assert_int_eq(ctx->figure.x, x + 1);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test36) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  const Frame_t *frame = tetris_frame(ctx);
+  ck_assert_int_eq(frame->version, tetris_version(ctx));
+  int color = ctx->figure.figure + 1, moving = 0, ghost = 0;
+  const Shape_t *shape = shape_get(ctx->figure.figure, ctx->figure.rotation);
+  for (int i = 0; i < FRAME_HEIGHT; ++i) {
+    for (int j = 0; j < FRAME_WIDTH; ++j) {
+      int cell = ctx->game.field[i][j], part = 0;
+      for (int k = 0; k < FIGURE_PART; ++k) {
+        part |= ctx->figure.x + shape->cells[k][0] == i &&
+                ctx->figure.y + shape->cells[k][1] == j;
+      }
+      ck_assert_int_le(cell, COUNT_OF_FIGURES);
+      if (part) {
+        ck_assert_int_eq(frame->cells[i * FRAME_WIDTH + j], color);
+        moving++;
+      } else if (frame->cells[i * FRAME_WIDTH + j] == FRAME_GHOST) {
+        ck_assert_int_eq(cell, EMPTY_PLACE);
+        ck_assert_int_gt(i, BOARD_FLOOR - SHAPE_SIZE - 1);
+        ghost++;
+      } else {
+        ck_assert_int_eq(frame->cells[i * FRAME_WIDTH + j], cell);
+      }
+    }
+  }
+  ck_assert_int_eq(moving, FIGURE_PART);
+  ck_assert_int_eq(ghost, FIGURE_PART);
+  unsigned long version = frame->version;
+  tetris_input(ctx, Up, 0);
+  tetris_step(ctx);
+  ck_assert_int_eq(frame->version, version);
+  tetris_input(ctx, Down, 0);
+  tetris_step(ctx);
+  ck_assert_int_gt(frame->version, version);
+  int fixed = 0;
+  for (int k = 0; k < FRAME_SIZE; ++k) {
+    fixed += frame->cells[k] != EMPTY_PLACE && frame->cells[k] != FRAME_GHOST;
+  }
+  ck_assert_int_eq(fixed, FIGURE_PART);
+  tetris_input(ctx, Terminate, 0);
+  tetris_step(ctx);
+  ck_assert_ptr_null(ctx->game.field);
+  ck_assert_int_eq(frame->version, tetris_version(ctx));
+  tetris_destroy(ctx);
+
+  // поле и кадр проверяются после каждого шага целой игры
+  ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 36);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 50);
+  Bot_t *bot = bot_create(0, NULL);
+  tetris_input(ctx, Start, 0);
+  int checked = 0;
+  for (int step = 0; step < 3000 && ctx->game.field; ++step) {
+    tetris_input(ctx, bot_action(bot, ctx), 0);
+    tetris_step(ctx);
+    // после конца игры поле освобождено
+    if (!ctx->game.field) break;
+    // на поле только зафиксированные клетки, падающей фигуры там нет
+    Board_t loaded;
+    board_load(&loaded, ctx->game.field);
+    for (int i = 0; i < FIELD_HEIGHT; ++i) {
+      ck_assert_uint_eq(loaded.rows[i], ctx->board.rows[i]);
+    }
+    // кадр - это поле, фигура и ее тень
+    int landing[FIGURE_PART][2];
+    if (!tetris_ghost(ctx, landing)) continue;
+    const Figure_position *figure = &ctx->figure;
+    const Shape_t *shape = shape_get(figure->figure, figure->rotation);
+    frame = tetris_frame(ctx);
+    bool visible = figure->x + shape->min_row > ZERO_X;
+    for (int i = 0; i < FRAME_HEIGHT; ++i) {
+      for (int j = 0; j < FRAME_WIDTH; ++j) {
+        int part = 0, shadow = 0;
+        for (int k = 0; k < FIGURE_PART; ++k) {
+          part |= figure->x + shape->cells[k][0] == i &&
+                  figure->y + shape->cells[k][1] == j;
+          shadow |= landing[k][0] == i && landing[k][1] == j;
+        }
+        int cell = ctx->game.field[i][j], expected = cell;
+        if (part && visible) {
+          expected = figure->figure + 1;
+        } else if (shadow && cell == EMPTY_PLACE) {
+          expected = FRAME_GHOST;
+        }
+        ck_assert_int_eq(frame->cells[i * FRAME_WIDTH + j], expected);
+      }
+    }
+    checked++;
+  }
+  ck_assert_int_gt(ctx->pieces, 100);
+  ck_assert_int_gt(ctx->lines, 10);
+  ck_assert_int_gt(checked, 2000);
+  bot_destroy(bot);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test37) {
+  TetrisPool_t *pool = tetris_pool_create(2);
+  ck_assert_ptr_nonnull(pool);
+  ck_assert_ptr_null(tetris_pool_create(0));
+  TetrisContext *first = tetris_pool_acquire(pool);
+  TetrisContext *second = tetris_pool_acquire(pool);
+  ck_assert_ptr_nonnull(first);
+  ck_assert_ptr_nonnull(second);
+  ck_assert_ptr_ne(first, second);
+  ck_assert_ptr_null(tetris_pool_acquire(pool));
+  first->headless = true;
+  tetris_input(first, Start, 0);
+  tetris_step(first);
+  const char *begin = (const char *)first;
+  const char *end = begin + sizeof(TetrisContext);
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    ck_assert((const char *)first->game.field[i] >= begin);
+    ck_assert((const char *)first->game.field[i] < end);
+  }
+  ck_assert((const char *)first->game.next[3] >= begin);
+  ck_assert((const char *)first->game.next[3] < end);
+  ck_assert_int_eq(tetris_pool_release(pool, first), 0);
+  TetrisContext *again = tetris_pool_acquire(pool);
+  ck_assert_ptr_eq(again, first);
+  ck_assert(!again->initialized);
+  ck_assert_ptr_null(again->game.field);
+  ck_assert_int_eq(tetris_pool_release(pool, again), 0);
+  ck_assert_int_eq(tetris_pool_release(pool, second), 0);
+  ck_assert_int_eq(tetris_pool_release(pool, NULL), 0);
+
+  // повторный возврат и чужие контексты не портят пул
+  TetrisPool_t *other = tetris_pool_create(1);
+  TetrisContext *foreign = tetris_create();
+  ck_assert_int_eq(tetris_pool_release(pool, second), 1);
+  ck_assert_int_eq(tetris_pool_release(pool, foreign), 1);
+  ck_assert_int_eq(tetris_pool_release(pool, tetris_pool_acquire(other)), 1);
+  ck_assert_int_eq(
+      tetris_pool_release(pool, (TetrisContext *)((char *)first + 8)), 1);
+  ck_assert_ptr_nonnull(tetris_pool_acquire(pool));
+  ck_assert_ptr_nonnull(tetris_pool_acquire(pool));
+  ck_assert_ptr_null(tetris_pool_acquire(pool));
+  tetris_destroy(foreign);
+  tetris_pool_destroy(other);
+  tetris_pool_destroy(pool);
+  tetris_pool_destroy(NULL);
+}
+END_TEST
+
+START_TEST(test38) {
+  TetrisContext *ctx = tetris_default();
+  init_game(ctx);
+  GameInfo_t *game = set_game_info();
+  int *bottom = game->field[FIELD_HEIGHT - 1];
+  for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+    game->field[15][j] = 1, game->field[17][j] = 2,
+    game->field[FIELD_HEIGHT - 1][j] = 3;
+  }
+  game->field[14][2] = 4, game->field[16][5] = 5, game->field[18][7] = 6;
+  board_load(set_board_info(), game->field);
+  check_field(ctx);
+  int rows[FIELD_HEIGHT] = {0};
+  ck_assert_int_eq(tetris_cleared_rows(ctx, rows), 3);
+  ck_assert_int_eq(tetris_cleared_rows(ctx, NULL), 3);
+  ck_assert_int_eq(rows[0], 15);
+  ck_assert_int_eq(rows[1], 17);
+  ck_assert_int_eq(rows[2], FIELD_HEIGHT - 1);
+  ck_assert_int_eq(ctx->lines, 3);
+  ck_assert_int_eq(game->score, THREE_LINES);
+  ck_assert_int_eq(game->field[19][7], 6);
+  ck_assert_int_eq(game->field[18][5], 5);
+  ck_assert_int_eq(game->field[17][2], 4);
+  Board_t loaded;
+  board_load(&loaded, game->field);
+  int cells = 0;
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    ck_assert_int_eq(loaded.rows[i], set_board_info()->rows[i]);
+    for (int j = 0; j < FIELD_WIDTH; ++j) cells += game->field[i][j] != 0;
+  }
+  ck_assert_int_eq(cells, 3);
+  ck_assert_ptr_eq(game->field[0], bottom);
+  check_field(ctx);
+  ck_assert_int_eq(tetris_cleared_rows(ctx, rows), 0);
+  free_game(game);
+}
+END_TEST
+
+START_TEST(test39) {
+  Board_t board = {0};
+  Features_t features;
+  board.rows[20] = 0x3FF & ~(1u << 4);
+  board.rows[18] = 1u << 4 | 1u << 0;
+  board.rows[17] = 1u << 0;
+  features_load(&features, &board);
+  ck_assert_int_eq(features.fill[20], 9);
+  ck_assert_int_eq(features.fill[18], 2);
+  ck_assert_int_eq(features.height[0], 4);
+  ck_assert_int_eq(features.height[4], 3);
+  ck_assert_int_eq(features.height[9], 1);
+  ck_assert_int_eq(features.height[5], 1);
+  ck_assert_int_eq(features.holes, 3);
+
+  Rng_t rng;
+  rng_seed(&rng, 7, 1);
+  TetrisContext *ctx = tetris_create();
+  tetris_seed(ctx, 7);
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 50);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  static const UserAction_t actions[] = {Up, Left, Right, Action, Left, Down};
+  for (int step = 0; step < 20000 && ctx->game.field; ++step) {
+    tetris_input(ctx, actions[rng_below(&rng, 6)], 0);
+    tetris_step(ctx);
+    features_load(&features, &ctx->board);
+    const Features_t *kept = tetris_features(ctx);
+    ck_assert_mem_eq(kept->fill, features.fill, sizeof(features.fill));
+    ck_assert_mem_eq(kept->height, features.height, sizeof(features.height));
+    ck_assert_int_eq(kept->holes, features.holes);
+  }
+  ck_assert_int_gt(ctx->pieces, 10);
+  tetris_destroy(ctx);
+
+  ctx = tetris_default();
+  init_game(ctx);
+  GameInfo_t *game = set_game_info();
+  for (int i = 17; i < BOARD_FLOOR; ++i) {
+    for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+      game->field[i][j] = j == 4 ? EMPTY_PLACE : 1;
+    }
+  }
+  game->field[16][0] = 2, game->field[15][1] = 3;
+  board_load(set_board_info(), game->field);
+  features_load(&ctx->features, set_board_info());
+  ck_assert_int_eq(tetris_features(ctx)->holes, 1);
+  Figure_position *figure = set_figure_info();
+  figure->figure = 0, figure->rotation = 1, figure->x = 18, figure->y = -1;
+  fix_figure(ctx);
+  check_field(ctx);
+  ck_assert_int_eq(tetris_cleared_rows(ctx, NULL), 4);
+  features_load(&features, set_board_info());
+  const Features_t *kept = tetris_features(ctx);
+  ck_assert_mem_eq(kept->fill, features.fill, sizeof(features.fill));
+  ck_assert_mem_eq(kept->height, features.height, sizeof(features.height));
+  ck_assert_int_eq(kept->holes, 1);
+  ck_assert_int_eq(kept->height[1], 2);
+
+  // новая фигура поверх занятой клетки (конец игры) тоже попадает в признаки
+  game->field[0][4] = 1, game->field[2][5] = 1;
+  board_load(set_board_info(), game->field);
+  features_load(&ctx->features, set_board_info());
+  figure->figure = 0, figure->rotation = 0, figure->x = 0, figure->y = 0;
+  fix_figure(ctx);
+  features_load(&features, set_board_info());
+  ck_assert_int_eq(kept->fill[0], 4);
+  ck_assert_mem_eq(kept->fill, features.fill, sizeof(features.fill));
+  ck_assert_mem_eq(kept->height, features.height, sizeof(features.height));
+  ck_assert_int_eq(kept->holes, features.holes);
+  free_game(game);
+}
+END_TEST
+
+START_TEST(test40) {
+  Rng_t rng;
+  rng_seed(&rng, 11, 1);
+  TetrisContext *ctx = tetris_create();
+  tetris_seed(ctx, 11);
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  int cells[FIGURE_PART][2] = {{0}};
+  ck_assert(!tetris_ghost(ctx, cells));
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  static const UserAction_t actions[] = {Up, Left, Right, Action, Right, Down};
+  for (int step = 0; step < 20000 && ctx->game.field; ++step) {
+    if (ctx->game.pause == no_signal) {
+      TetrisContext copy = *ctx;
+      int distance = 0;
+      while (can_move(&copy, MOVE_DOWN)) {
+        copy.figure.x++;
+        distance++;
+      }
+      ck_assert_int_eq(drop_distance(ctx), distance);
+      ck_assert(tetris_ghost(ctx, cells));
+      const Shape_t *shape =
+          shape_get(ctx->figure.figure, ctx->figure.rotation);
+      ck_assert_int_eq(cells[0][0], copy.figure.x + shape->cells[0][0]);
+      ck_assert_int_eq(cells[0][1], ctx->figure.y + shape->cells[0][1]);
+    }
+    UserAction_t action = actions[rng_below(&rng, 6)];
+    Figure_position before = ctx->figure;
+    int pieces = ctx->pieces, x = before.x + drop_distance(ctx);
+    bool falls = action == Down && ctx->game.pause == no_signal;
+    tetris_input(ctx, action, 0);
+    tetris_step(ctx);
+    if (falls && tetris_cleared_rows(ctx, NULL) == 0 && ctx->game.field) {
+      const Shape_t *shape = shape_get(before.figure, before.rotation);
+      ck_assert_int_eq(ctx->pieces, pieces + 1);
+      for (int i = 0; i < FIGURE_PART; ++i) {
+        ck_assert_int_eq(ctx->game.field[x + shape->cells[i][0]]
+                                        [before.y + shape->cells[i][1]],
+                         before.figure + 1);
+      }
+    }
+  }
+  ck_assert_int_gt(ctx->pieces, 10);
+  int moving = 0;
+  for (int i = 0; ctx->game.field && i < FIELD_HEIGHT; ++i) {
+    for (int j = 0; j < FIELD_WIDTH; ++j) {
+      moving += ctx->game.field[i][j] > COUNT_OF_FIGURES;
+    }
+  }
+  ck_assert_int_eq(moving, 0);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test41) {
+  ck_assert_ptr_null(bot_create(-1, NULL));
+  Bot_t *single = bot_create(0, NULL);
+  Bot_t *parallel = bot_create(3, NULL);
+  ck_assert_ptr_nonnull(single);
+  ck_assert_ptr_nonnull(parallel);
+  TetrisContext *ctx = tetris_create();
+  tetris_seed(ctx, 5);
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 50);
+  for (int step = 0; step < 3000 && ctx->game.pause != game_over; ++step) {
+    UserAction_t action = bot_action(parallel, ctx);
+    if (ctx->game.pause == no_signal && step % 50 == 0) {
+      BotMove_t first = bot_search(single, ctx);
+      BotMove_t second = bot_search(parallel, ctx);
+      ck_assert(first.found);
+      ck_assert_int_eq(first.rotation, second.rotation);
+      ck_assert_int_eq(first.y, second.y);
+      ck_assert_double_eq_tol(first.score, second.score, 1e-9);
+    }
+    tetris_input(ctx, action, 0);
+    tetris_step(ctx);
+  }
+  ck_assert_int_ne(ctx->game.pause, game_over);
+  ck_assert_int_gt(ctx->lines, 10);
+  tetris_destroy(ctx);
+  bot_destroy(single);
+  bot_destroy(parallel);
+  bot_destroy(NULL);
+}
+END_TEST
+
+// одна и та же начальная позиция: фигура на поле, под навесом слева пусто
+static TetrisContext *placement_game(void) {
+  TetrisContext *ctx = tetris_create();
+  tetris_seed(ctx, 3);
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  tetris_advance_time(ctx, ctx->delay);
+  tetris_input(ctx, Up, 0);
+  tetris_step(ctx);
+  for (int j = 0; j < 3; ++j) ctx->game.field[17][j] = 1;
+  for (int j = 5; j < REAL_FIELD_WIDTH; ++j) ctx->game.field[20][j] = 2;
+  Board_t fixed = {0};
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+      if (ctx->game.field[i][j] != EMPTY_PLACE) {
+        fixed.rows[i] |= (uint16_t)(1u << j);
+      }
+    }
+  }
+  ctx->board = fixed;
+  features_load(&ctx->features, &ctx->board);
+  return ctx;
+}
+
+START_TEST(test42) {
+  TetrisContext *ctx = placement_game();
+  static Placement_t placements[PLACEMENT_MAX];
+  int count = placements_find(ctx, placements, PLACEMENT_MAX);
+  ck_assert_int_gt(count, 10);
+  ck_assert_int_eq(placements_find(ctx, placements, 3), 3);
+  count = placements_find(ctx, placements, PLACEMENT_MAX);
+  int figure = ctx->figure.figure, tucked = 0;
+  tetris_destroy(ctx);
+  for (int k = 0; k < count; ++k) {
+    const Placement_t *placement = &placements[k];
+    for (int m = 0; m < k; ++m) {
+      ck_assert(placements[m].x != placement->x ||
+                placements[m].y != placement->y ||
+                placements[m].rotation != placement->rotation);
+    }
+    ctx = placement_game();
+    for (int i = 0; i < placement->length; ++i) {
+      ck_assert_int_eq(ctx->pieces, 0);
+      if (placement->path[i] == Up) {
+        tetris_advance_time(ctx, ctx->delay);
+      }
+      tetris_input(ctx, (UserAction_t)placement->path[i], 0);
+      tetris_step(ctx);
+    }
+    ck_assert_int_eq(ctx->pieces, 1);
+    const Shape_t *shape = shape_get(figure, placement->rotation);
+    for (int i = 0; i < FIGURE_PART; ++i) {
+      int x = placement->x + shape->cells[i][0];
+      int y = placement->y + shape->cells[i][1];
+      ck_assert_int_eq(ctx->game.field[x][y], figure + 1);
+      tucked += x > 17 && y < 3;
+    }
+    tetris_destroy(ctx);
+  }
+  ck_assert_int_gt(tucked, 0);
+}
+END_TEST
+
+// последовательность фигур игры со своим зерном
+static void play_pieces(unsigned long long seed, Randomizer_t randomizer,
+                        int *pieces, int count) {
+  TetrisContext *ctx = tetris_create();
+  tetris_seed(ctx, seed);
+  tetris_set_randomizer(ctx, randomizer);
+  init_game(ctx);
+  pieces[0] = ctx->figure.figure;
+  for (int i = 1; i < count; ++i) {
+    pieces[i] = ctx->figure.next_figure;
+    ctx->figure.next_figure = next_piece(ctx);
+  }
+  free_game(&ctx->game);
+  tetris_destroy(ctx);
+}
+
+START_TEST(test43) {
+  Rng_t first, second;
+  rng_seed(&first, 42, 0);
+  rng_seed(&second, 42, 0);
+  for (int i = 0; i < 1000; ++i) {
+    ck_assert(rng_next(&first) == rng_next(&second));
+    ck_assert_int_lt((int)rng_below(&first, 7), 7);
+    rng_below(&second, 7);
+  }
+  rng_seed(&second, 42, 1);
+  ck_assert(rng_next(&first) != rng_next(&second));
+
+  enum { COUNT = 700 };
+  int a[COUNT], b[COUNT], c[COUNT];
+  play_pieces(9, RANDOMIZER_UNIFORM, a, COUNT);
+  play_pieces(9, RANDOMIZER_UNIFORM, b, COUNT);
+  play_pieces(10, RANDOMIZER_UNIFORM, c, COUNT);
+  ck_assert_mem_eq(a, b, sizeof(a));
+  ck_assert(memcmp(a, c, sizeof(a)) != 0);
+  int seen[COUNT_OF_FIGURES] = {0};
+  for (int i = 0; i < COUNT; ++i) {
+    ck_assert_int_ge(a[i], 0);
+    ck_assert_int_lt(a[i], COUNT_OF_FIGURES);
+    seen[a[i]]++;
+  }
+  for (int k = 0; k < COUNT_OF_FIGURES; ++k) {
+    ck_assert_int_gt(seen[k], COUNT / COUNT_OF_FIGURES / 2);
+  }
+
+  play_pieces(9, RANDOMIZER_BAG, a, COUNT);
+  play_pieces(9, RANDOMIZER_BAG, b, COUNT);
+  ck_assert_mem_eq(a, b, sizeof(a));
+  for (int i = 0; i < COUNT; i += COUNT_OF_FIGURES) {
+    int mask = 0;
+    for (int k = 0; k < COUNT_OF_FIGURES; ++k) {
+      mask |= 1 << a[i + k];
+    }
+    ck_assert_int_eq(mask, (1 << COUNT_OF_FIGURES) - 1);
+  }
+}
+END_TEST
+
+START_TEST(test44) {
+  Replay_t *record = replay_create(77, RANDOMIZER_BAG);
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 20);
+  tetris_record(ctx, record);
+  Rng_t rng;
+  rng_seed(&rng, 77, 1);
+  static const UserAction_t actions[] = {Up,    Up,   Left,   Right, Action,
+                                         Down,  Up,   Pause,  Start, Left};
+  tetris_input(ctx, Start, 0);
+  GameInfo_t info = tetris_step(ctx);
+  int steps = 1;
+  while (info.pause != game_over && info.pause != terminate) {
+    UserAction_t action = actions[rng_below(&rng, 10)];
+    tetris_input(ctx, ++steps < 5000 ? action : Terminate, 0);
+    info = tetris_step(ctx);
+  }
+  tetris_input(ctx, Left, 0);
+  tetris_step(ctx);  // после конца игры шаги не записываются
+  ck_assert_int_eq(replay_count(record), steps);
+  ck_assert_int_eq(replay_duration(record), steps * 20);
+  ck_assert_int_le(replay_size(record), steps + 1);
+  ck_assert_int_eq(replay_save(record, "replay_test.bin"), 0);
+
+  Replay_t *loaded = replay_load("replay_test.bin");
+  ck_assert_ptr_nonnull(loaded);
+  ck_assert_int_eq(replay_count(loaded), steps);
+  ck_assert_int_eq(replay_duration(loaded), steps * 20);
+  ReplayCursor_t first = {0}, second = {0};
+  ReplayEvent_t a, b;
+  while (replay_next(record, &first, &a)) {
+    ck_assert(replay_next(loaded, &second, &b));
+    ck_assert_int_eq(a.time, b.time);
+    ck_assert_int_eq(a.action, b.action);
+  }
+  ck_assert(!replay_next(loaded, &second, &b));
+  TetrisContext *copy = tetris_create();
+  GameInfo_t played = replay_play(loaded, copy);
+  ck_assert_int_eq(played.pause, info.pause);
+  ck_assert_int_eq(played.score, info.score);
+  ck_assert_int_eq(copy->pieces, ctx->pieces);
+  ck_assert_int_eq(copy->lines, ctx->lines);
+  ck_assert_mem_eq(copy->board.rows, ctx->board.rows, sizeof(Board_t));
+  ck_assert_int_gt(ctx->pieces, 5);
+  tetris_destroy(copy);
+  tetris_destroy(ctx);
+  replay_destroy(loaded);
+
+  FILE *file = fopen("replay_test.bin", "wb");
+  fwrite("TRPL\1\0\0\0", 1, 8, file);
+  fclose(file);
+  ck_assert_ptr_null(replay_load("replay_test.bin"));
+  ck_assert_int_eq(replay_add(record, 0, Up), 1);
+  ck_assert_int_eq(replay_save(record, "replay_test.bin"), 1);
+  remove("replay_test.bin");
+  ck_assert_ptr_null(replay_load("replay_test.bin"));
+  replay_destroy(record);
+}
+END_TEST
+
+// игра в отдельном потоке для проверки суммы статистики потоков
+static void *stats_worker(void *arg) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 451);
+  tetris_input(ctx, Start, 0);
+  for (int step = 0; step < 100; ++step) {
+    tetris_step(ctx);
+  }
+  tetris_destroy(ctx);
+  return arg;
+}
+
+START_TEST(test45) {
+  StatsTiming_t timing = {0};
+  stats_time(&timing, 2);
+  stats_time(&timing, 4);
+  stats_time(&timing, 6);
+  ck_assert_int_eq(timing.count, 3);
+  ck_assert_double_eq_tol(timing.total, 12, 1e-9);
+  ck_assert_double_eq_tol(timing.min, 2, 1e-9);
+  ck_assert_double_eq_tol(timing.max, 6, 1e-9);
+
+  stats_reset();
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 45);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 50);
+  tetris_input(ctx, Start, 0);
+  for (int step = 0; step < 2000 && ctx->game.field; ++step) {
+    tetris_input(ctx, step % 3 ? Up : Down, 0);
+    tetris_step(ctx);
+  }
+  const Stats_t *stats = tetris_stats();
+  unsigned long long handled = 0;
+  for (int i = 0; i < STATS_STATES; ++i) {
+    handled += stats->state_time[i].count;
+  }
+  if (stats_enabled()) {
+    ck_assert_int_gt(stats->collisions, 0);
+    ck_assert_int_eq(stats->lines, (unsigned long long)ctx->lines);
+    ck_assert_int_gt(stats->steps.count, 0);
+    ck_assert_int_eq(handled, stats->steps.count);
+  } else {
+    ck_assert_int_eq(stats->collisions, 0);
+    ck_assert_int_eq(handled, 0);
+  }
+  tetris_destroy(ctx);
+
+  // статистика завершившегося потока остается в общей сумме
+  unsigned long long steps = stats->steps.count;
+  pthread_t thread;
+  pthread_create(&thread, NULL, stats_worker, NULL);
+  pthread_join(thread, NULL);
+  Stats_t total;
+  stats_collect(&total);
+  ck_assert_int_eq(total.steps.count, stats_enabled() ? steps + 100 : 0);
+  ck_assert_int_eq(tetris_stats()->steps.count, steps);
+
+  FILE *file = tmpfile();
+  stats_dump(file, true);
+  stats_dump(file, false);
+  rewind(file);
+  static char line[8192];
+  ck_assert_ptr_nonnull(fgets(line, sizeof(line), file));
+  ck_assert_int_eq(line[0], '{');
+  ck_assert_ptr_nonnull(strstr(line, "\"collisions\""));
+  ck_assert_ptr_nonnull(strstr(line, "\"frames\""));
+  ck_assert_ptr_nonnull(fgets(line, sizeof(line), file));
+  ck_assert_ptr_nonnull(strstr(line, "statistics"));
+  fclose(file);
+  stats_reset();
+  ck_assert_int_eq(tetris_stats()->steps.count, 0);
+}
+END_TEST
+
+START_TEST(test46) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 46);
+  tetris_set_tick_rate(ctx, 60);
+  ck_assert_double_eq_tol(ctx->timer.step_ms, 17, 1e-9);
+  tetris_set_tick_rate(ctx, 100);
+  ck_assert_int_eq(tetris_tick_wait(ctx), 10);
+  int ticks = -1;
+  tetris_advance(ctx, 25, 0, &ticks);
+  ck_assert_int_eq(ticks, 2);
+  ck_assert_int_eq(tetris_tick_wait(ctx), 5);
+  tetris_advance(ctx, 5, 0, &ticks);
+  ck_assert_int_eq(ticks, 1);
+  tetris_advance(ctx, 1000, 4, &ticks);  // остановка: лишнее время теряется
+  ck_assert_int_eq(ticks, 4);
+  ck_assert_int_eq(tetris_tick_wait(ctx), 10);
+  ck_assert_double_eq_tol(timer_now(&ctx->timer), 70, 1e-9);
+
+  // ход, совпавший со сдвигом по таймеру, не теряется
+  tetris_input(ctx, Start, 0);
+  tetris_advance(ctx, 10, 0, &ticks);
+  ck_assert_int_eq(ticks, 1);
+  while (tetris_wait_time(ctx) > 10) {
+    tetris_advance(ctx, 10, 0, NULL);
+  }
+  tetris_advance(ctx, 3, 0, NULL);
+  ck_assert_int_le(tetris_wait_time(ctx), 7);
+  int x = ctx->figure.x, y = ctx->figure.y;
+  tetris_input(ctx, Left, 0);
+  tetris_advance(ctx, 7, 0, &ticks);
+  ck_assert_int_eq(ticks, 1);
+  ck_assert_int_eq(ctx->figure.x, x + 1);
+  ck_assert_int_eq(ctx->figure.y, y - 1);
+
+  // без игрока игра идет вперед сколько угодно тактов за один вызов
+  GameInfo_t info = tetris_advance(ctx, 3600000, 0, &ticks);
+  ck_assert_int_eq(info.pause, game_over);
+  ck_assert_int_gt(ticks, 0);
+  ck_assert_int_lt(ticks, 360000);
+  ck_assert_int_gt(ctx->pieces, 5);
+  tetris_destroy(ctx);
+
+  // сон до сдвига по таймеру не считается остановкой и не замедляет игру
+  ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 46);
+  tetris_set_tick_rate(ctx, 100);
+  tetris_input(ctx, Start, 0);
+  tetris_advance(ctx, 10, 25, NULL);
+  int row = ctx->figure.x;
+  double slept = 0;
+  for (int rows = 1; rows <= 5; ++rows) {
+    while (ctx->figure.x == row) {
+      int sleep = tetris_sleep_time(ctx, 25);
+      ck_assert_int_gt(sleep, 0);
+      ck_assert_int_le(sleep, 25 * 10);
+      tetris_advance(ctx, sleep, 25, NULL);
+      slept += sleep;
+    }
+    ck_assert_int_eq(ctx->figure.x, ++row);
+    ck_assert_double_eq_tol(slept, rows * ctx->delay, 10);
+  }
+  tetris_destroy(ctx);
+
+  // игра на тактах с редким вводом повторяется по записи точно
+  Replay_t *record = replay_create(46, RANDOMIZER_UNIFORM);
+  ctx = tetris_create();
+  ctx->headless = true;
+  tetris_set_tick_rate(ctx, 100);
+  tetris_record(ctx, record);
+  Rng_t rng;
+  rng_seed(&rng, 46, 1);
+  static const UserAction_t actions[] = {Left, Right, Action, Down};
+  tetris_input(ctx, Start, 0);
+  for (int i = 0; i < 5000 && ctx->game.field; ++i) {
+    if (ctx->input == Up && rng_below(&rng, 4) == 0) {
+      tetris_input(ctx, actions[rng_below(&rng, 4)], 0);
+    }
+    tetris_advance(ctx, rng_below(&rng, 40), 0, NULL);
+  }
+  TetrisContext *copy = tetris_create();
+  replay_play(record, copy);
+  ck_assert_int_gt(ctx->pieces, 5);
+  ck_assert_int_eq(copy->pieces, ctx->pieces);
+  ck_assert_mem_eq(copy->board.rows, ctx->board.rows, sizeof(Board_t));
+  tetris_destroy(copy);
+  tetris_destroy(ctx);
+  replay_destroy(record);
+}
+END_TEST
+
+// одинаковые случайные действия для копий одной игры
+static void play_random(TetrisContext *ctx, unsigned long long seed,
+                        int steps) {
+  static const UserAction_t actions[] = {Up, Up, Left, Right, Action, Down};
+  Rng_t rng;
+  rng_seed(&rng, seed, 1);
+  for (int i = 0; i < steps && ctx->game.field; ++i) {
+    tetris_input(ctx, actions[rng_below(&rng, 6)], 0);
+    tetris_step(ctx);
+  }
+}
+
+static void assert_same_game(const TetrisContext *a, const TetrisContext *b) {
+  TetrisSnapshot_t first, second;
+  tetris_save(a, &first);
+  tetris_save(b, &second);
+  ck_assert_mem_eq(&first, &second, sizeof(TetrisSnapshot_t));
+  ck_assert_mem_eq(tetris_frame(a)->cells, tetris_frame(b)->cells, FRAME_SIZE);
+}
+
+START_TEST(test47) {
+  TetrisContext *ctx = tetris_create();
+  ctx->headless = true;
+  tetris_seed(ctx, 47);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, 50);
+  Bot_t *bot = bot_create(0, NULL);
+  TetrisSnapshot_t snapshot;
+  for (int i = 0; i < 5000 && ctx->lines < 3; ++i) {
+    tetris_input(ctx, bot_action(bot, ctx), 0);
+    tetris_step(ctx);
+    tetris_save(ctx, &snapshot);
+    ck_assert(tetris_snapshot_valid(&snapshot));
+  }
+  bot_destroy(bot);
+  ck_assert_int_ge(ctx->lines, 3);  // указатели строк уже переставлены
+
+  tetris_save(ctx, &snapshot);
+  TetrisContext *clone = tetris_create(), *restored = tetris_create();
+  tetris_clone(clone, ctx);
+  ck_assert_int_eq(tetris_restore(restored, &snapshot), 0);
+  for (int i = 0; i < FIELD_HEIGHT; ++i) {
+    ck_assert(clone->game.field[i] >= clone->cells[0] &&
+              clone->game.field[i] <= clone->cells[FIELD_HEIGHT - 1]);
+    ck_assert_mem_eq(clone->game.field[i], ctx->game.field[i],
+                     sizeof(int) * FIELD_WIDTH);
+    ck_assert_mem_eq(restored->game.field[i], ctx->game.field[i],
+                     sizeof(int) * FIELD_WIDTH);
+  }
+  assert_same_game(clone, ctx);
+  assert_same_game(restored, ctx);
+
+  play_random(ctx, 7, 600);
+  play_random(clone, 7, 600);
+  play_random(restored, 7, 600);
+  assert_same_game(clone, ctx);
+  assert_same_game(restored, ctx);
+  ck_assert_int_gt(ctx->pieces, snapshot.pieces);
+
+  ck_assert_int_eq(tetris_restore(ctx, &snapshot), 0);  // откат
+  ck_assert_int_eq(ctx->pieces, snapshot.pieces);
+  play_random(ctx, 7, 600);
+  assert_same_game(ctx, clone);
+
+  // испорченный снимок отклоняется, и игра не меняется
+  TetrisSnapshot_t bad[17];
+  for (int i = 0; i < 17; ++i) bad[i] = snapshot;
+  bad[0].figure = COUNT_OF_FIGURES;
+  bad[1].rotation = -1;
+  bad[2].bag_size = COUNT_OF_FIGURES + 1;
+  bad[3].x = FIELD_HEIGHT;
+  bad[4].y = -FIELD_WIDTH;
+  bad[5].board.rows[FIELD_HEIGHT - 2] ^= 1u;  // доска не совпадает с полем
+  bad[6].cells[0][0] = 0xF;
+  bad[7].pause = next_figure + 1;
+  bad[8].level = 0;  // фигура никогда не упала бы
+  bad[9].level = -1;
+  bad[10].level = MAX_SPEED + 2;
+  bad[11].speed = 0;
+  bad[12].delay = INFINITY;
+  bad[13].last_update = -1;
+  bad[14].accumulator = NAN;
+  bad[15].timer.now_ms = INFINITY;
+  bad[16].timer.step_ms = -1;
+  for (int i = 0; i < 17; ++i) {
+    ck_assert(!tetris_snapshot_valid(&bad[i]));
+    ck_assert_int_eq(tetris_restore(ctx, &bad[i]), 1);
+    assert_same_game(ctx, clone);
+  }
+  tetris_destroy(clone);
+  tetris_destroy(restored);
+
+  TetrisContext *empty = tetris_create(), *copy = tetris_create();
+  tetris_save(empty, &snapshot);
+  ck_assert(!snapshot.started);
+  ck_assert_int_eq(tetris_restore(copy, &snapshot), 0);
+  ck_assert_ptr_null(copy->game.field);
+  tetris_clone(copy, empty);
+  ck_assert_ptr_null(copy->game.field);
+  tetris_destroy(empty);
+  tetris_destroy(copy);
+  tetris_destroy(ctx);
+}
+END_TEST
+
+START_TEST(test48) {
+  BotWeights_t weights[2] = {bot_default_weights(), {0, 0, 0, 0}};
+  TuneConfig_t config = {.games = 5, .max_pieces = 25, .seed = 48,
+                         .threads = 1};
+  TuneReport_t single[2], parallel[2];
+  TuneStats_t stats;
+  ck_assert_int_eq(tune_run(&config, weights, 2, single, &stats), 0);
+  ck_assert_int_eq(stats.threads, 1);
+  ck_assert_int_eq(stats.steals, 0);
+  config.threads = 3;
+  ck_assert_int_eq(tune_run(&config, weights, 2, parallel, &stats), 0);
+  ck_assert_int_eq(stats.threads, 3);
+  ck_assert_int_eq(memcmp(single, parallel, sizeof(single)), 0);
+  config.threads = 20;  // работников не больше, чем игр
+  ck_assert_int_eq(tune_run(&config, weights, 2, parallel, &stats), 0);
+  ck_assert_int_eq(stats.threads, 10);
+  ck_assert_int_eq(memcmp(single, parallel, sizeof(single)), 0);
+
+  const TuneReport_t *report = &single[0];
+  ck_assert_int_eq(report->games, 5);
+  ck_assert(report->weights.height == weights[0].height);
+  ck_assert_int_le(report->pieces.max, 25);
+  ck_assert_int_le(report->pieces.min, report->pieces.p10);
+  ck_assert_int_le(report->pieces.p10, report->pieces.median);
+  ck_assert_int_le(report->pieces.median, report->pieces.p90);
+  ck_assert_int_le(report->pieces.p90, report->pieces.max);
+  ck_assert(report->survival >= 0 && report->survival <= 1);
+  ck_assert(report->survival < 1 || report->pieces.min == 25);
+
+  // первая игра набора совпадает с отдельной игрой бота с тем же зерном
+  TetrisContext *ctx = tetris_create();
+  Bot_t *bot = bot_create(0, NULL);
+  ctx->headless = true;
+  tetris_seed(ctx, 48);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, TUNE_STEP_MS);
+  config.games = 1, config.threads = 1;
+  tune_run(&config, weights, 1, single, NULL);
+  tetris_input(ctx, Start, 0);
+  GameInfo_t info = tetris_step(ctx);
+  while (info.pause != game_over && ctx->pieces < config.max_pieces) {
+    tetris_input(ctx, bot_action(bot, ctx), 0);
+    info = tetris_step(ctx);
+  }
+  ck_assert_int_eq(single[0].score.max, info.score);
+  ck_assert_int_eq(single[0].lines.max, ctx->lines);
+  ck_assert_int_eq(single[0].pieces.max, ctx->pieces);
+  bot_destroy(bot);
+  tetris_destroy(ctx);
+
+  config.games = 0;
+  ck_assert_int_eq(tune_run(&config, weights, 1, single, NULL), 1);
+  config.games = 1, config.max_pieces = 0;
+  ck_assert_int_eq(tune_run(&config, weights, 1, single, NULL), 1);
+  config.max_pieces = 1;
+  ck_assert_int_eq(tune_run(&config, weights, 0, single, NULL), 1);
+  ck_assert_int_ge(tune_processors(), 1);
+}
+END_TEST
+
+// игра движка в том же состоянии, что и новая доска пакета
+static void batch_engine(TetrisContext *ctx, unsigned long long seed,
+                         Randomizer_t randomizer) {
+  memset(ctx, 0, sizeof(TetrisContext));
+  ctx->headless = true;
+  tetris_seed(ctx, seed);
+  tetris_set_randomizer(ctx, randomizer);
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+}
+
+static void batch_compare(const TetrisBatch_t *batch, int index,
+                          const TetrisContext *ctx) {
+  BatchBoard_t board;
+  batch_board(batch, index, &board);
+  ck_assert_int_eq(memcmp(board.board.rows, ctx->board.rows,
+                          sizeof(board.board.rows)),
+                   0);
+  ck_assert_int_eq(board.alive, ctx->game.pause != game_over);
+  ck_assert_int_eq(batch_alive(batch, index), board.alive);
+  if (board.alive) {
+    ck_assert_int_eq(board.figure.x, ctx->figure.x);
+    ck_assert_int_eq(board.figure.y, ctx->figure.y);
+    ck_assert_int_eq(board.figure.rotation, ctx->figure.rotation);
+    ck_assert_int_eq(board.figure.figure, ctx->figure.figure);
+  }
+  ck_assert_int_eq(board.figure.next_figure, ctx->figure.next_figure);
+  ck_assert_int_eq(board.score, ctx->game.score);
+  ck_assert_int_eq(board.lines, ctx->lines);
+  ck_assert_int_eq(board.pieces, ctx->pieces);
+  ck_assert_int_eq(board.level, ctx->game.level);
+}
+
+START_TEST(test49) {
+  enum { BOARDS = 37, STEPS = 1500 };  // не кратно BATCH_LANES
+  const UserAction_t moves[] = {Up, Left, Right, Action, Down};
+  TetrisContext *games = (TetrisContext *)calloc(BOARDS, sizeof(TetrisContext));
+  UserAction_t actions[BOARDS];
+  Bot_t *bots[BOARDS];
+  for (int n = 0; n < BOARDS; ++n) {
+    bots[n] = bot_create(0, NULL);
+  }
+  ck_assert_ptr_null(batch_create(0, RANDOMIZER_UNIFORM));
+  for (int mode = 0; mode < 6; ++mode) {
+    Randomizer_t randomizer = mode % 2 ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+    TetrisBatch_t *batch = batch_create(BOARDS, randomizer);
+    ck_assert_ptr_nonnull(batch);
+    ck_assert_int_eq(batch_count(batch), BOARDS);
+    if (!batch_set_kernel(batch, (BatchKernel_t)(mode / 2))) {
+      ck_assert_int_eq(mode / 2, BATCH_AVX2);  // процессор без AVX2
+    } else {
+      ck_assert_int_eq(batch_kernel(batch), mode / 2);
+      Rng_t rng;
+      rng_seed(&rng, 49, mode);
+      unsigned long long seed = BOARDS;
+      for (int n = 0; n < BOARDS; ++n) {
+        batch_engine(&games[n], n, randomizer);
+        batch_compare(batch, n, &games[n]);
+      }
+      for (int step = 0; step < STEPS; ++step) {
+        for (int n = 0; n < BOARDS; ++n) {
+          // каждую третью доску ведет бот, чтобы на досках убирались линии
+          actions[n] = n % 3 ? moves[rng_below(&rng, 5)]
+                             : bot_action(bots[n], &games[n]);
+          // после конца игры действие начало бы новую игру движка
+          if (games[n].game.pause != game_over) {
+            if (actions[n] == Up) {
+              tetris_advance_time(&games[n], 1e6);
+            }
+            tetris_input(&games[n], actions[n], 0);
+            tetris_step(&games[n]);
+          }
+        }
+        batch_step(batch, actions);
+        for (int n = 0; n < BOARDS; ++n) {
+          batch_compare(batch, n, &games[n]);
+          if (games[n].game.pause == game_over && step % 7 == 0) {
+            batch_reset(batch, n, seed);
+            batch_engine(&games[n], seed++, randomizer);
+            batch_compare(batch, n, &games[n]);
+          }
+        }
+      }
+    }
+    batch_destroy(batch);
+  }
+  int lines = 0;
+  for (int n = 0; n < BOARDS; ++n) {
+    lines += games[n].lines;
+    bot_destroy(bots[n]);
+  }
+  ck_assert_int_gt(lines, 0);
+  batch_destroy(NULL);
+  free(games);
+}
+END_TEST
+
+enum { FEED_FRAMES = 20000 };
+
+// кадр писателя теста: все поля выводятся из номера, поэтому читатель видит
+// разорванную копию по несовпадению полей
+static void *feed_writer(void *arg) {
+  FrameFeed_t *feed = (FrameFeed_t *)arg;
+  FeedFrame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  for (int n = 0; n < FEED_FRAMES; ++n) {
+    memset(frame.frame.cells, n % 251, FRAME_SIZE);
+    frame.frame.version = (unsigned long)n;
+    frame.score = n, frame.lines = -n;
+    feed_publish(feed, &frame);
+  }
+  return NULL;
+}
+
+static void *feed_spectator(void *arg) {
+  FrameFeed_t *feed = (FrameFeed_t *)arg;
+  FeedReader_t reader = {0};
+  FeedFrame_t frame;
+  long long bad = 0, last = -1, seen = 0;
+  while (reader.next < FEED_FRAMES) {
+    if (feed_read(feed, &reader, &frame)) {
+      int n = frame.score;
+      bad += (long long)frame.sequence != n || frame.lines != -n ||
+             frame.frame.version != (unsigned long)n || n <= last ||
+             frame.frame.cells[0] != n % 251 ||
+             frame.frame.cells[FRAME_SIZE - 1] != n % 251;
+      last = n, seen++;
+    }
+  }
+  bad += seen + (long long)reader.dropped != FEED_FRAMES;
+  return (void *)(intptr_t)bad;
+}
+
+START_TEST(test50) {
+  ck_assert_ptr_null(feed_create(1));
+  FrameFeed_t *feed = feed_create(5);
+  ck_assert_int_eq(feed_capacity(feed), 8);
+  FeedReader_t reader, late;
+  FeedFrame_t frame;
+  feed_subscribe(feed, &reader);
+  ck_assert(!feed_read(feed, &reader, &frame));
+  ck_assert(!feed_latest(feed, &reader, &frame));
+
+  // каждый кадр игры публикуется после шага, изменившего картинку
+  TetrisContext *ctx = tetris_create();
+  Bot_t *bot = bot_create(0, NULL);
+  ctx->headless = true;
+  tetris_seed(ctx, 50);
+  tetris_publish(ctx, feed);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  unsigned long version = 0;
+  while (ctx->pieces < 10) {
+    ck_assert(feed_read(feed, &reader, &frame));
+    ck_assert_uint_eq(frame.sequence, reader.next - 1);
+    ck_assert(frame.frame.version > version);
+    version = frame.frame.version;
+    ck_assert(!feed_read(feed, &reader, &frame));
+    ck_assert_uint_eq(version, tetris_version(ctx));
+    ck_assert_int_eq(memcmp(frame.frame.cells, tetris_frame(ctx)->cells,
+                            FRAME_SIZE),
+                     0);
+    ck_assert_int_eq(frame.score, ctx->game.score);
+    ck_assert_int_eq(frame.level, ctx->game.level);
+    ck_assert_int_eq(frame.state, ctx->game.pause);
+    ck_assert_int_eq(frame.next_figure, ctx->figure.next_figure);
+    ck_assert_int_eq(frame.pieces, ctx->pieces);
+    unsigned long before = tetris_version(ctx);
+    while (tetris_version(ctx) == before) {
+      tetris_input(ctx, bot_action(bot, ctx), 0);
+      tetris_step(ctx);
+    }
+  }
+  ck_assert_uint_eq(feed_published(feed), reader.next + 1);
+
+  // отставший читатель теряет самые старые кадры, а не останавливает игру
+  feed_subscribe(feed, &late);
+  ck_assert_uint_eq(late.next, feed_published(feed) - 1);
+  for (int i = 0; i < 20; ++i) {
+    feed_publish(feed, &frame);
+  }
+  uint64_t published = feed_published(feed);
+  ck_assert(feed_read(feed, &late, &frame));
+  ck_assert_uint_eq(frame.sequence, published - 8);
+  ck_assert_uint_eq(late.dropped, 21 - 8);
+  ck_assert(feed_latest(feed, &reader, &frame));
+  ck_assert_uint_eq(frame.sequence, published - 1);
+  ck_assert_uint_eq(reader.next, published);
+  ck_assert_uint_eq(reader.dropped, 0);
+
+  TetrisContext *copy = tetris_create();
+  tetris_clone(copy, ctx);
+  ck_assert_ptr_null(copy->feed);
+  tetris_publish(ctx, NULL);
+  tetris_input(ctx, Down, 0);
+  tetris_step(ctx);
+  ck_assert_uint_eq(feed_published(feed), published);
+  tetris_destroy(copy);
+  bot_destroy(bot);
+  tetris_destroy(ctx);
+  feed_destroy(feed);
+
+  // писатель не ждет читателей, а читатели получают только целые кадры
+  feed = feed_create(16);
+  pthread_t writer, spectators[3];
+  for (int i = 0; i < 3; ++i) {
+    pthread_create(&spectators[i], NULL, feed_spectator, feed);
+  }
+  pthread_create(&writer, NULL, feed_writer, feed);
+  pthread_join(writer, NULL);
+  for (int i = 0; i < 3; ++i) {
+    void *bad = NULL;
+    pthread_join(spectators[i], &bad);
+    ck_assert_ptr_null(bad);
+  }
+  ck_assert_uint_eq(feed_published(feed), FEED_FRAMES);
+  feed_destroy(feed);
+  feed_destroy(NULL);
+}
+END_TEST
+
+START_TEST(test51) {
+  ServerConfig_t config = {.path = NULL,
+                           .port = -1,
+                           .threads = 2,
+                           .max_clients = 4,
+                           .step_ms = 10,
+                           .lockstep = true,
+                           .seed = 51,
+                           .randomizer = RANDOMIZER_BAG};
+  ck_assert_ptr_null(server_start(&config));
+  config.path = "/tmp/tetris_test51.sock";
+  config.port = 0;
+  config.max_clients = 0;
+  ck_assert_ptr_null(server_start(&config));
+  config.max_clients = 4;
+
+  // обычный файл на месте сокета не стирается
+  FILE *file = fopen(config.path, "w");
+  ck_assert_ptr_nonnull(file);
+  fclose(file);
+  ck_assert_ptr_null(server_start(&config));
+  file = fopen(config.path, "r");
+  ck_assert_ptr_nonnull(file);
+  fclose(file);
+  remove(config.path);
+  Server_t *server = server_start(&config);
+  ck_assert_ptr_nonnull(server);
+  ck_assert(server_port(server) > 0);
+
+  // второй сервер не забирает путь у работающего
+  ServerConfig_t other = config;
+  other.port = -1;
+  ck_assert_ptr_null(server_start(&other));
+
+  // три игры по Unix-сокету и TCP повторяются локальными копиями движка
+  static ServerClient_t clients[3];
+  TetrisContext *mirrors[3];
+  Bot_t *bot = bot_create(0, NULL);
+  for (int i = 0; i < 3; ++i) {
+    ck_assert_int_eq(i < 2 ? client_connect_unix(&clients[i], config.path)
+                           : client_connect_tcp(&clients[i],
+                                                server_port(server)),
+                     0);
+    ck_assert_uint_eq(clients[i].seed, config.seed + clients[i].game);
+    mirrors[i] = tetris_create();
+    mirrors[i]->headless = true;
+    tetris_seed(mirrors[i], clients[i].seed);
+    tetris_set_randomizer(mirrors[i], RANDOMIZER_BAG);
+    tetris_set_timer(mirrors[i], TIMER_FIXED_STEP, config.step_ms);
+  }
+  ck_assert(clients[0].game != clients[1].game);
+  ck_assert(clients[1].game != clients[2].game);
+  ck_assert_int_eq(server_games(server), 3);
+  for (int step = 0; step < 300; ++step) {
+    for (int i = 0; i < 3; ++i) {
+      UserAction_t action = step ? bot_action(bot, mirrors[i]) : Start;
+      ck_assert_int_eq(client_send(&clients[i], action), 0);
+      tetris_input(mirrors[i], action, 0);
+      tetris_step(mirrors[i]);
+      ck_assert_int_eq(client_receive(&clients[i], 5000), SERVER_FRAME);
+      FeedFrame_t frame;
+      feed_frame(mirrors[i], &frame);
+      const FeedFrame_t *received = &clients[i].frame;
+      ck_assert_uint_eq(received->sequence, step);
+      ck_assert_uint_eq(received->frame.version, frame.frame.version);
+      ck_assert_int_eq(memcmp(received->frame.cells, frame.frame.cells,
+                              FRAME_SIZE),
+                       0);
+      ck_assert_int_eq(received->score, frame.score);
+      ck_assert_int_eq(received->level, frame.level);
+      ck_assert_int_eq(received->state, frame.state);
+      ck_assert_int_eq(received->next_figure, frame.next_figure);
+      ck_assert_int_eq(received->pieces, frame.pieces);
+      ck_assert_int_eq(received->lines, frame.lines);
+    }
+  }
+  ck_assert(mirrors[0]->pieces > 2);
+
+  // лишние соединения и неверные сообщения закрываются сервером
+  static ServerClient_t extra, refused;
+  ck_assert_int_eq(client_connect_tcp(&extra, server_port(server)), 0);
+  ck_assert_int_eq(client_connect_unix(&refused, config.path), 1);
+  ck_assert_int_eq(client_receive(&extra, 10), 0);
+  ck_assert_int_eq(client_send(&extra, (UserAction_t)200), 0);
+  ck_assert_int_eq(client_receive(&extra, 5000), -1);
+  client_close(&extra);
+
+  for (int i = 0; i < 3; ++i) {
+    client_close(&clients[i]);
+    tetris_destroy(mirrors[i]);
+  }
+  bot_destroy(bot);
+  server_stop(server);
+  server_stop(NULL);
+  ck_assert_int_eq(client_connect_unix(&refused, config.path), 1);
+
+  // мертвый сокет заменяется, а остановленный сервер не удаляет сокет того,
+  // кто занял путь после него
+  NetFile_t bound;
+  int fd = net_listen_unix(config.path, &bound);
+  ck_assert_int_ge(fd, 0);
+  net_close(fd);
+  server = server_start(&other);
+  ck_assert_ptr_nonnull(server);
+  remove(config.path);
+  Server_t *second = server_start(&other);
+  ck_assert_ptr_nonnull(second);
+  server_stop(server);
+  static ServerClient_t late;
+  ck_assert_int_eq(client_connect_unix(&late, config.path), 0);
+  client_close(&late);
+  server_stop(second);
+  ck_assert_int_eq(client_connect_unix(&late, config.path), 1);
+}
+END_TEST
+
 int main(void) {
   Suite *s1 = suite_create("Core");
   TCase *tc1_1 = tcase_create("Core");
@@ -624,6 +1944,28 @@ int main(void) {
   tcase_add_test(tc1_1, test27);
   tcase_add_test(tc1_1, test28);
   tcase_add_test(tc1_1, test29);
+  tcase_add_test(tc1_1, test30);
+  tcase_add_test(tc1_1, test31);
+  tcase_add_test(tc1_1, test32);
+  tcase_add_test(tc1_1, test33);
+  tcase_add_test(tc1_1, test34);
+  tcase_add_test(tc1_1, test35);
+  tcase_add_test(tc1_1, test36);
+  tcase_add_test(tc1_1, test37);
+  tcase_add_test(tc1_1, test38);
+  tcase_add_test(tc1_1, test39);
+  tcase_add_test(tc1_1, test40);
+  tcase_add_test(tc1_1, test41);
+  tcase_add_test(tc1_1, test42);
+  tcase_add_test(tc1_1, test43);
+  tcase_add_test(tc1_1, test44);
+  tcase_add_test(tc1_1, test45);
+  tcase_add_test(tc1_1, test46);
+  tcase_add_test(tc1_1, test47);
+  tcase_add_test(tc1_1, test48);
+  tcase_add_test(tc1_1, test49);
+  tcase_add_test(tc1_1, test50);
+  tcase_add_test(tc1_1, test51);
 
   srunner_run_all(sr, CK_ENV);
   nf = srunner_ntests_failed(sr);
@@ -2,6 +2,46 @@
 
 #include "gui/cli/frontend.h"
 
+// показ записанной игры
+static int play_replay(const char *path) {
+  int result = 0;
+  Replay_t *replay = replay_load(path);
+  if (replay) {
+    replay_loop(replay);
+  } else {
+    fprintf(stderr, "%s: cannot read the replay\n", path);
+    result = 1;
+  }
+  replay_destroy(replay);
+  return result;
+}
+
+// игры друг за другом, пока игрок не выйдет; записывается только одна игра
+static int play_games(bool demo, const char *record_path, double tick_rate) {
+  int result = 0;
+  TetrisContext *ctx = tetris_default();
+  unsigned long long seed = (unsigned long long)time(NULL);
+  tetris_seed(ctx, seed);
+  tetris_set_tick_rate(ctx, tick_rate);
+  Bot_t *bot = demo ? bot_create(DEMO_THREADS, NULL) : NULL;
+  Replay_t *record = NULL;
+  if (record_path) {
+    record = replay_create(seed, RANDOMIZER_UNIFORM);
+    tetris_record(ctx, record);
+  }
+  bool continue_game = TRUE;
+  while (continue_game) {
+    continue_game = game_loop(bot) && !record;  // запуск игры
+  }
+  if (record && replay_save(record, record_path)) {
+    fprintf(stderr, "%s: cannot write the replay\n", record_path);
+    result = 1;
+  }
+  replay_destroy(record);
+  bot_destroy(bot);
+  return result;
+}
+
 /**
  * @brief The main function of the program, managing the game's lifecycle.
  *
@@ -9,7 +49,7 @@
  * the following actions:
  *  - Initializes the `ncurses` library for console interface interaction.
  *  - Configures input and output, hides the cursor.
- *  - Initializes the random number generator.
+ *  - Seeds the generator of figures of the game with the current time.
  *  - Enables handling of special keys (arrow keys, etc.).
  *  - Sets up non-blocking input.
  *  - Initializes the color system.
@@ -17,13 +57,63 @@
  * continues as long as `game_loop()` returns `TRUE`.
  *  - Terminates the `ncurses` library.
  *
- * @return 0 if the program completes successfully.
+ * Arguments:
+ *  - `-d`: The demo mode: the game is played by the bot (`bot_action`).
+ *  - `-r file`: The game is recorded to the replay file (see `Replay_t`) and
+ * the program exits when it ends.
+ *  - `-p file`: The recorded game is shown at the speed it was played instead
+ * of a new game.
+ *  - `-t rate`: The number of game ticks per second (`TICK_RATE` by
+ * default).
+ *  - `-s file`: The statistics (`Stats_t`) are written to the file every
+ * `STATS_DUMP_PERIOD` ms and when the program exits; `-j` writes them as
+ * JSON. The statistics are collected only in builds with `STATS=1`.
+ *
+ * @return 0 if the program completes successfully, 1 if the arguments are
+ * wrong or the replay cannot be read or written.
  */
-int main(void) {
-  srand(time(NULL));
-  bool continue_game = TRUE;
-  while (continue_game) {
-    continue_game = game_loop();  // запуск игры
+int main(int argc, char **argv) {
+  const char *record_path = NULL, *play_path = NULL, *stats_path = NULL;
+  bool demo = FALSE, json = FALSE;
+  double tick_rate = TICK_RATE;
+  int result = 0;
+  for (int i = 1; i < argc && !result; ++i) {
+    if (!strcmp(argv[i], "-d")) {
+      demo = TRUE;
+    } else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (!strcmp(argv[i], "-p") && i + 1 < argc) {
+      play_path = argv[++i];
+    } else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      stats_path = argv[++i];
+    } else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+      tick_rate = atof(argv[++i]);
+      result = tick_rate <= 0;
+    } else if (!strcmp(argv[i], "-j")) {
+      json = TRUE;
+    } else {
+      result = 1;
+    }
+  }
+  FILE *stats = NULL;
+  if (!result && stats_path) {
+    stats = fopen(stats_path, "w");
+    result = stats == NULL;
+  }
+  if (result) {
+    fprintf(stderr,
+            "usage: %s [-d] [-r replay_file] [-p replay_file] "
+            "[-t ticks_per_second] [-s stats_file [-j]]\n",
+            argv[0]);
+  } else {
+    stats_set_dump(stats, json, STATS_DUMP_PERIOD);
+    result = play_path ? play_replay(play_path)
+                       : play_games(demo, record_path, tick_rate);
+  }
+  if (stats) {
+    stats_set_dump(NULL, json, 0);
+    stats_dump(stats, json);
+    fclose(stats);
   }
-  return 0;
+  return result;
 }
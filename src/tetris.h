@@ -16,7 +16,6 @@
 #define INFO_START_POSITION 23
 #define INFO_WIDTH 19
 #define FIGURE_PART 4
-#define MOVING_PLACE 8
 #define EMPTY_PLACE 0
 #define FIXED_PLACE 9
 #define MOVE_LEFT 1
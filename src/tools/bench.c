@@ -0,0 +1,513 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../brick_game/tetris/backend.h"
+#include "../brick_game/tetris/batch.h"
+#include "../brick_game/tetris/feed.h"
+#include "../brick_game/tetris/snapshot.h"
+
+#define BENCH_SAMPLES 25
+#define BENCH_SAMPLE_MS 2.0
+#define BENCH_MAX_SAMPLES 1000
+#define BENCH_SEED 2024
+#define BENCH_TOLERANCE 10.0
+#define BENCH_BASELINE_SIZE 65536
+#define BENCH_BATCH 256
+
+/**
+ * @brief Settings of a benchmark run.
+ *
+ * @var samples    The number of timed batches of every benchmark.
+ * @var sample_ms  The shortest time of one batch (ms); the number of
+ * operations in a batch is doubled until it takes that long.
+ * @var filter     Only benchmarks whose names contain it are run, or `NULL`.
+ * @var json       `true` to print the results as JSON.
+ * @var baseline   The JSON results of an earlier run to compare with or
+ * `NULL`.
+ * @var tolerance  The slowdown against the baseline that is not a
+ * regression (%).
+ */
+typedef struct {
+  int samples;
+  double sample_ms;
+  const char *filter;
+  bool json;
+  const char *baseline;
+  double tolerance;
+} Bench_t;
+
+/**
+ * @brief Result of one benchmark.
+ *
+ * @var mean    The mean time of one operation (ns).
+ * @var ci      The half-width of the 95% confidence interval of `mean` (ns).
+ * @var stddev  The standard deviation of the samples (ns).
+ * @var min     The fastest sample (ns per operation).
+ * @var ops     The number of operations in one sample.
+ */
+typedef struct {
+  double mean;
+  double ci;
+  double stddev;
+  double min;
+  long ops;
+} Result_t;
+
+/**
+ * @brief A benchmark: a fixture and the operation measured on it.
+ *
+ * Operations that change the game restore the fixture before every call;
+ * the time of as many restores alone is measured right after every sample and
+ * subtracted from it.
+ *
+ * @var name     The name of the benchmark.
+ * @var fixture  The board of the fixture, `NULL` for a game in progress.
+ * @var run      Makes `count` operations on the context.
+ * @var restore  `true` if the fixture is restored before every operation.
+ */
+typedef struct {
+  const char *name;
+  const char *const *fixture;
+  void (*run)(TetrisContext *ctx, const TetrisContext *fixture, long count);
+  bool restore;
+} Benchmark_t;
+
+// результат, который компилятор не может выбросить
+static volatile long sink;
+
+// доски фикстур сверху вниз до нижнего ряда поля, '#' - занятая клетка
+static const char *const empty_board[] = {NULL};
+static const char *const midgame_board[] = {
+    "..........", "....#.....", "#...##....", "##..###..#", "##.####.##",
+    "###.#.####", "#.######.#", "####.#####", "#.########", NULL};
+static const char *const full_lines_board[] = {
+    "..........", "#.........", "##.#......", "####...##.", "#########.",
+    "##########", "##########", "##########", "##########", NULL};
+
+static double now_ns(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec * 1e9 + (double)time.tv_nsec;
+}
+
+// игра с фигурой, уже видной на поле, и заданными нижними рядами
+static void load_fixture(TetrisContext *ctx, const char *const *board) {
+  memset(ctx, 0, sizeof(TetrisContext));
+  ctx->headless = true;
+  tetris_seed(ctx, BENCH_SEED);
+  tetris_set_timer(ctx, TIMER_VIRTUAL, 0);
+  tetris_input(ctx, Start, 0);
+  tetris_step(ctx);
+  for (int i = 0; i < 2; ++i) {
+    tetris_advance_time(ctx, ctx->delay);
+    tetris_input(ctx, Up, 0);
+    tetris_step(ctx);
+  }
+  int count = 0;
+  while (board[count]) count++;
+  for (int k = 0; k < count; ++k) {
+    int i = BOARD_FLOOR - count + k;
+    for (int j = 0; j < REAL_FIELD_WIDTH; ++j) {
+      bool filled = board[k][j] == '#';
+      ctx->game.field[i][j] = filled ? j % COUNT_OF_FIGURES + 1 : EMPTY_PLACE;
+      if (filled) ctx->board.rows[i] |= (uint16_t)(1u << j);
+    }
+  }
+  features_load(&ctx->features, &ctx->board);
+}
+
+static void run_restore(TetrisContext *ctx, const TetrisContext *fixture,
+                        long count) {
+  for (long i = 0; i < count; ++i) {
+    tetris_clone(ctx, fixture);
+  }
+}
+
+static void run_save(TetrisContext *ctx, const TetrisContext *fixture,
+                     long count) {
+  (void)fixture;
+  TetrisSnapshot_t snapshot;
+  for (long i = 0; i < count; ++i) {
+    tetris_save(ctx, &snapshot);
+  }
+  sink = snapshot.pieces;
+}
+
+static void run_load(TetrisContext *ctx, const TetrisContext *fixture,
+                     long count) {
+  TetrisSnapshot_t snapshot;
+  tetris_save(fixture, &snapshot);
+  for (long i = 0; i < count; ++i) {
+    tetris_restore(ctx, &snapshot);
+  }
+  sink = ctx->pieces;
+}
+
+static void run_can_move(TetrisContext *ctx, const TetrisContext *fixture,
+                         long count) {
+  (void)fixture;
+  long moves = 0;
+  for (long i = 0; i < count; ++i) {
+    moves += can_move(ctx, (int)(i & 3) + MOVE_LEFT);
+  }
+  sink = moves;
+}
+
+static void run_drop_distance(TetrisContext *ctx,
+                              const TetrisContext *fixture, long count) {
+  (void)fixture;
+  long rows = 0;
+  for (long i = 0; i < count; ++i) {
+    rows += drop_distance(ctx);
+  }
+  sink = rows;
+}
+
+// четыре поворота возвращают фигуру в исходное положение
+static void run_rotate(TetrisContext *ctx, const TetrisContext *fixture,
+                       long count) {
+  (void)fixture;
+  for (long i = 0; i < count; ++i) {
+    rotate(ctx);
+  }
+  sink = ctx->figure.rotation;
+}
+
+static void run_shift_figure(TetrisContext *ctx, const TetrisContext *fixture,
+                             long count) {
+  long shifts = 0;
+  for (long i = 0; i < count; ++i) {
+    tetris_clone(ctx, fixture);
+    shifts += shift_figure(ctx);
+  }
+  sink = shifts;
+}
+
+static void run_fall_figure(TetrisContext *ctx, const TetrisContext *fixture,
+                            long count) {
+  for (long i = 0; i < count; ++i) {
+    tetris_clone(ctx, fixture);
+    fall_figure(ctx);
+    fix_figure(ctx);  // сброс вместе с фиксацией, как на шаге игры
+  }
+  sink = ctx->board.rows[BOARD_FLOOR - 1];
+}
+
+static void run_check_field(TetrisContext *ctx, const TetrisContext *fixture,
+                            long count) {
+  for (long i = 0; i < count; ++i) {
+    tetris_clone(ctx, fixture);
+    check_field(ctx);
+  }
+  sink = ctx->lines;
+}
+
+static void run_clear_lines(TetrisContext *ctx, const TetrisContext *fixture,
+                            long count) {
+  uint32_t lines = board_full_rows(&fixture->board);
+  for (long i = 0; i < count; ++i) {
+    tetris_clone(ctx, fixture);
+    clear_lines(ctx, lines);
+  }
+  sink = ctx->board.rows[BOARD_FLOOR - 1];
+}
+
+// полный такт игры по умолчанию со случайным вводом, после конца игры
+// начинается новая
+static void run_update(TetrisContext *ctx, const TetrisContext *fixture,
+                       long count) {
+  (void)ctx, (void)fixture;
+  static const UserAction_t actions[] = {Up, Up, Up, Left, Right, Action, Down};
+  static Rng_t rng;
+  static bool started = false;
+  if (!started) {
+    tetris_default()->headless = true;
+    tetris_seed(tetris_default(), BENCH_SEED);
+    tetris_set_timer(tetris_default(), TIMER_FIXED_STEP, 10);
+    rng_seed(&rng, BENCH_SEED, 1);
+    started = true;
+  }
+  for (long i = 0; i < count; ++i) {
+    UserAction_t action = actions[rng_below(&rng, 7)];
+    if (tetris_default()->game.pause == ready_to_start ||
+        !tetris_default()->game.field) {
+      action = Start;
+    }
+    userInput(action, 0);
+    sink = updateCurrentState().score;
+  }
+}
+
+// публикация кадра в кольцо без читателей
+static void run_feed_publish(TetrisContext *ctx, const TetrisContext *fixture,
+                             long count) {
+  (void)fixture;
+  static FrameFeed_t *feed;
+  if (!feed) {
+    feed = feed_create(64);
+  }
+  ctx->feed = feed;
+  for (long i = 0; i < count; ++i) {
+    feed_publish_step(ctx);
+  }
+  ctx->feed = NULL;
+  sink = (long)feed_published(feed);
+}
+
+// шаг пакета из BENCH_BATCH досок одним ядром; действия берутся из заранее
+// заполненной случайной таблицы со сдвигом, доски, где игра окончена,
+// сразу начинаются заново
+static void run_batch(BatchKernel_t kernel, long count) {
+  static const UserAction_t moves[] = {Up, Up, Up, Left, Right, Action, Down};
+  static TetrisBatch_t *batches[BATCH_AVX2 + 1];
+  static UserAction_t actions[BENCH_BATCH * 4];
+  TetrisBatch_t *batch = batches[kernel];
+  if (!batch) {
+    Rng_t rng;
+    rng_seed(&rng, BENCH_SEED, 2);
+    for (int n = 0; n < BENCH_BATCH * 4; ++n) {
+      actions[n] = moves[rng_below(&rng, 7)];
+    }
+    batch = batches[kernel] = batch_create(BENCH_BATCH, RANDOMIZER_UNIFORM);
+    batch_set_kernel(batch, kernel);  // без AVX2 остается векторное ядро
+  }
+  for (long i = 0; i < count; ++i) {
+    batch_step(batch, &actions[i * 7 % (BENCH_BATCH * 3)]);
+    for (int n = 0; n < BENCH_BATCH; ++n) {
+      if (!batch_alive(batch, n)) {
+        batch_reset(batch, n, BENCH_SEED + (unsigned long long)i);
+      }
+    }
+  }
+  BatchBoard_t board;
+  batch_board(batch, 0, &board);
+  sink = board.score;
+}
+
+static void run_batch_scalar(TetrisContext *ctx, const TetrisContext *fixture,
+                             long count) {
+  (void)ctx, (void)fixture;
+  run_batch(BATCH_SCALAR, count);
+}
+
+static void run_batch_vector(TetrisContext *ctx, const TetrisContext *fixture,
+                             long count) {
+  (void)ctx, (void)fixture;
+  run_batch(BATCH_VECTOR, count);
+}
+
+static void run_batch_avx2(TetrisContext *ctx, const TetrisContext *fixture,
+                           long count) {
+  (void)ctx, (void)fixture;
+  run_batch(BATCH_AVX2, count);
+}
+
+static const Benchmark_t benchmarks[] = {
+    {"can_move/empty", empty_board, run_can_move, false},
+    {"can_move/midgame", midgame_board, run_can_move, false},
+    {"drop_distance/midgame", midgame_board, run_drop_distance, false},
+    {"rotate/empty", empty_board, run_rotate, false},
+    {"rotate/midgame", midgame_board, run_rotate, false},
+    {"shift_figure/midgame", midgame_board, run_shift_figure, true},
+    {"fall_figure/empty", empty_board, run_fall_figure, true},
+    {"fall_figure/midgame", midgame_board, run_fall_figure, true},
+    {"check_field/midgame", midgame_board, run_check_field, true},
+    {"check_field/4_lines", full_lines_board, run_check_field, true},
+    {"clear_lines/4_lines", full_lines_board, run_clear_lines, true},
+    {"tetris_clone/midgame", midgame_board, run_restore, false},
+    {"tetris_save/midgame", midgame_board, run_save, false},
+    {"tetris_restore/midgame", midgame_board, run_load, false},
+    {"feed_publish/midgame", midgame_board, run_feed_publish, false},
+    {"updateCurrentState/random", NULL, run_update, false},
+    {"batch_step/256_scalar", NULL, run_batch_scalar, false},
+    {"batch_step/256_vector", NULL, run_batch_vector, false},
+    {"batch_step/256_avx2", NULL, run_batch_avx2, false},
+};
+
+// квантиль распределения Стьюдента для 95% интервала
+static double student_t(int df) {
+  static const double table[] = {12.706, 4.303, 2.776, 2.571, 2.447, 2.365,
+                                 2.306,  2.262, 2.228, 2.201, 2.179, 2.160,
+                                 2.145,  2.131, 2.120, 2.110, 2.101, 2.093,
+                                 2.086,  2.080, 2.074, 2.069, 2.064, 2.060,
+                                 2.056,  2.052, 2.048, 2.045, 2.042};
+  int size = (int)(sizeof(table) / sizeof(table[0]));
+  return df <= 0 ? 0 : df <= size ? table[df - 1] : 1.96;
+}
+
+// число операций в выборке удваивается, пока выборка не займет sample_ms;
+// у операций, восстанавливающих фикстуру, из каждой выборки вычитается
+// восстановление, замеренное сразу после нее
+static Result_t measure(const Bench_t *bench, const Benchmark_t *benchmark) {
+  static TetrisContext ctx, fixture;
+  void (*run)(TetrisContext *, const TetrisContext *, long) = benchmark->run;
+  if (benchmark->fixture) {
+    load_fixture(&fixture, benchmark->fixture);
+    tetris_clone(&ctx, &fixture);
+  }
+  Result_t result = {.ops = 1};
+  double elapsed = 0;
+  while (elapsed < bench->sample_ms * 1e6 && result.ops < (1L << 40)) {
+    result.ops *= 2;
+    double start = now_ns();
+    run(&ctx, &fixture, result.ops);
+    elapsed = now_ns() - start;
+  }
+  double samples[BENCH_MAX_SAMPLES], sum = 0;
+  for (int i = 0; i < bench->samples; ++i) {
+    double start = now_ns();
+    run(&ctx, &fixture, result.ops);
+    double spent = now_ns() - start;
+    if (benchmark->restore) {
+      start = now_ns();
+      run_restore(&ctx, &fixture, result.ops);
+      spent -= now_ns() - start;
+    }
+    samples[i] = spent / (double)result.ops;
+    sum += samples[i];
+    if (i == 0 || samples[i] < result.min) result.min = samples[i];
+  }
+  result.mean = sum / bench->samples;
+  double squares = 0;
+  for (int i = 0; i < bench->samples; ++i) {
+    squares += (samples[i] - result.mean) * (samples[i] - result.mean);
+  }
+  if (bench->samples > 1) {
+    result.stddev = sqrt(squares / (bench->samples - 1));
+    result.ci = student_t(bench->samples - 1) * result.stddev /
+                sqrt((double)bench->samples);
+  }
+  return result;
+}
+
+static void print_result(const Bench_t *bench, const Benchmark_t *benchmark,
+                         const Result_t *result, bool first) {
+  if (bench->json) {
+    printf("%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"ci95\": %.3f, "
+           "\"stddev\": %.3f, \"min\": %.3f, \"samples\": %d, "
+           "\"ops_per_sample\": %ld}",
+           first ? "" : ",", benchmark->name, result->mean, result->ci,
+           result->stddev, result->min, bench->samples, result->ops);
+  } else {
+    double relative = result->mean > 0 ? 100.0 * result->ci / result->mean : 0;
+    printf("%-28s %10.2f ns/op  +- %7.2f (%5.1f%%)  min %10.2f\n",
+           benchmark->name, result->mean, result->ci, relative, result->min);
+  }
+}
+
+// результат теста в JSON предыдущего запуска, false если его там нет
+static bool find_baseline(const char *json, const char *name,
+                          Result_t *result) {
+  char key[128];
+  snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+  const char *entry = strstr(json, key);
+  return entry && sscanf(entry + strlen(key),
+                         ", \"ns_per_op\": %lf, \"ci95\": %lf",
+                         &result->mean, &result->ci) == 2;
+}
+
+// замедление считается регрессией, только если интервалы не пересекаются и
+// разница больше допуска
+static bool is_regression(const Bench_t *bench, const Result_t *base,
+                          const Result_t *result) {
+  return result->mean - result->ci > base->mean + base->ci &&
+         result->mean > base->mean * (1 + bench->tolerance / 100);
+}
+
+static int load_baseline(const char *path, char *json) {
+  int result = 1;
+  FILE *file = fopen(path, "r");
+  if (file) {
+    size_t size = fread(json, 1, BENCH_BASELINE_SIZE - 1, file);
+    json[size] = '\0';
+    result = ferror(file) != 0;
+    fclose(file);
+  }
+  return result;
+}
+
+static void print_usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-n samples] [-t sample_ms] [-f filter] [-j] "
+          "[-c baseline.json] [-r tolerance]\n"
+          "-j: the results are printed as JSON\n"
+          "-c: the results are compared with the JSON results of an earlier "
+          "run;\n    the exit code is 2 if a benchmark is slower by more "
+          "than the tolerance\n    (%.0f%% by default) beyond the confidence "
+          "intervals\n",
+          name, BENCH_TOLERANCE);
+}
+
+static int parse_args(int argc, char **argv, Bench_t *bench) {
+  int result = 0;
+  for (int i = 1; i < argc && !result; ++i) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!strcmp(argv[i], "-j")) {
+      bench->json = true;
+    } else if (!value) {
+      result = 1;
+    } else if (!strcmp(argv[i], "-n")) {
+      bench->samples = atoi(value), ++i;
+    } else if (!strcmp(argv[i], "-t")) {
+      bench->sample_ms = atof(value), ++i;
+    } else if (!strcmp(argv[i], "-f")) {
+      bench->filter = value, ++i;
+    } else if (!strcmp(argv[i], "-c")) {
+      bench->baseline = value, ++i;
+    } else if (!strcmp(argv[i], "-r")) {
+      bench->tolerance = atof(value), ++i;
+    } else {
+      result = 1;
+    }
+  }
+  if (bench->samples < 2 || bench->samples > BENCH_MAX_SAMPLES ||
+      bench->sample_ms <= 0 || bench->tolerance < 0) {
+    result = 1;
+  }
+  return result;
+}
+
+/**
+ * @brief Measures the time of the hot paths of the engine on fixed boards and
+ * prints it in nanoseconds per operation with 95% confidence intervals.
+ *
+ * With a baseline (`-c`) the regressions are reported to `stderr` and the exit
+ * code is 2 if there are any, so the benchmarks can gate a release.
+ */
+int main(int argc, char **argv) {
+  Bench_t bench = {.samples = BENCH_SAMPLES,
+                   .sample_ms = BENCH_SAMPLE_MS,
+                   .tolerance = BENCH_TOLERANCE};
+  static char baseline[BENCH_BASELINE_SIZE];
+  int result = parse_args(argc, argv, &bench);
+  if (result) {
+    print_usage(argv[0]);
+  } else if (bench.baseline && load_baseline(bench.baseline, baseline)) {
+    fprintf(stderr, "%s: cannot read the baseline\n", bench.baseline);
+    result = 1;
+  } else {
+    if (bench.json) printf("{\n  \"benchmarks\": [");
+    bool first = true;
+    int count = (int)(sizeof(benchmarks) / sizeof(benchmarks[0]));
+    for (int i = 0; i < count; ++i) {
+      if (!bench.filter || strstr(benchmarks[i].name, bench.filter)) {
+        Result_t measured = measure(&bench, &benchmarks[i]);
+        print_result(&bench, &benchmarks[i], &measured, first);
+        first = false;
+        Result_t base;
+        if (bench.baseline &&
+            find_baseline(baseline, benchmarks[i].name, &base) &&
+            is_regression(&bench, &base, &measured)) {
+          fprintf(stderr, "regression: %s %.2f ns/op, baseline %.2f ns/op\n",
+                  benchmarks[i].name, measured.mean, base.mean);
+          result = 2;
+        }
+      }
+    }
+    if (bench.json) printf("\n  ]\n}\n");
+  }
+  return result;
+}
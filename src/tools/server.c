@@ -0,0 +1,88 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../brick_game/tetris/server.h"
+
+static void print_usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-u path] [-p port] [-j threads] [-c max_clients] "
+          "[-t step_ms] [-s seed]\n"
+          "       [-r uniform|bag] [-l]\n"
+          "-u: the path of the Unix domain socket\n"
+          "-p: the TCP port on 127.0.0.1, 0 - any free port (default), "
+          "-1 - no TCP\n"
+          "-j: worker threads, 0 - one per processor (default)\n"
+          "-c: the largest number of games at once\n"
+          "-t: the time of one step of the games (ms)\n"
+          "-l: every input makes one step of its game at once (lockstep)\n",
+          name);
+}
+
+static int parse_args(int argc, char **argv, ServerConfig_t *config) {
+  int result = 0;
+  for (int i = 1; i < argc && !result; ++i) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!strcmp(argv[i], "-l")) {
+      config->lockstep = true;
+      --i;  // у ключа нет значения
+    } else if (!value) {
+      result = 1;
+    } else if (!strcmp(argv[i], "-u")) {
+      config->path = value;
+    } else if (!strcmp(argv[i], "-p")) {
+      config->port = atoi(value);
+    } else if (!strcmp(argv[i], "-j")) {
+      config->threads = atoi(value);
+    } else if (!strcmp(argv[i], "-c")) {
+      config->max_clients = atoi(value);
+    } else if (!strcmp(argv[i], "-t")) {
+      config->step_ms = atof(value);
+    } else if (!strcmp(argv[i], "-s")) {
+      config->seed = strtoull(value, NULL, 10);
+    } else if (!strcmp(argv[i], "-r")) {
+      bool bag = !strcmp(value, "bag");
+      config->randomizer = bag ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+      result = !bag && strcmp(value, "uniform");
+    } else {
+      result = 1;
+    }
+    ++i;
+  }
+  return result;
+}
+
+/**
+ * @brief Runs a game server until SIGINT or SIGTERM.
+ */
+int main(int argc, char **argv) {
+  ServerConfig_t config = {
+      .port = 0, .max_clients = 1024, .step_ms = 1000.0 / 60, .seed = 1};
+  int result = parse_args(argc, argv, &config);
+  Server_t *server = NULL;
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  // сигналы ждет только главный поток, работники сервера их не получают
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+  if (!result) {
+    server = server_start(&config);
+    result = server == NULL;
+  }
+  if (result) {
+    print_usage(argv[0]);
+  } else {
+    if (config.path) printf("unix: %s\n", config.path);
+    if (config.port >= 0) printf("tcp:  127.0.0.1:%d\n", server_port(server));
+    fflush(stdout);
+    int signal = 0;
+    sigwait(&signals, &signal);
+    printf("games: %d\n", server_games(server));
+    server_stop(server);
+  }
+  return result;
+}
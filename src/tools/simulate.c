@@ -0,0 +1,297 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../brick_game/tetris/backend.h"
+#include "../brick_game/tetris/bot.h"
+#include "../brick_game/tetris/pool.h"
+#include "../brick_game/tetris/replay.h"
+#include "../brick_game/tetris/stats.h"
+
+#define SIM_STEP_MS 10
+#define SIM_MAX_STEPS 1000000
+#define SIM_SCRIPT_SIZE 4096
+
+/**
+ * @brief Settings of a batch of simulated games.
+ *
+ * @var games      The number of games to play.
+ * @var max_steps  The limit of steps of one game (the game is terminated when
+ * it is reached).
+ * @var seed       The seed of the random inputs and figures; game `i` is
+ * seeded with `seed + i`.
+ * @var bag        `true` if the figures are chosen with `RANDOMIZER_BAG`.
+ * @var script     Actions to repeat in a loop; random actions are used if it
+ * is empty.
+ * @var threads    The number of search threads of the bot, -1 if the games
+ * are not played by the bot.
+ * @var bot        The bot playing the games or `NULL`.
+ * @var record     The path of the replay file of the first game or `NULL`.
+ * @var replay     The replay to play in every game instead of new games or
+ * `NULL`.
+ * @var stats      `true` to print the statistics of the engine (`Stats_t`).
+ */
+typedef struct {
+  int games;
+  int max_steps;
+  unsigned seed;
+  bool bag;
+  char script[SIM_SCRIPT_SIZE];
+  int threads;
+  Bot_t *bot;
+  const char *record;
+  Replay_t *replay;
+  bool stats;
+} Simulation_t;
+
+/**
+ * @brief Totals of a batch of simulated games.
+ */
+typedef struct {
+  long long steps;
+  long long pieces;
+  long long lines;
+  long long score;
+} Totals_t;
+
+// символ сценария в действие пользователя
+static UserAction_t script_action(char symbol) {
+  UserAction_t action = Up;
+  switch (symbol) {
+    case 'l':
+      action = Left;
+      break;
+    case 'r':
+      action = Right;
+      break;
+    case 'd':
+      action = Down;
+      break;
+    case 'a':
+      action = Action;
+      break;
+    case 's':
+      action = Start;
+      break;
+    case 'p':
+      action = Pause;
+      break;
+  }
+  return action;
+}
+
+// случайное действие: чаще всего ожидание и сдвиги, реже сброс фигуры
+static UserAction_t random_action(Rng_t *rng) {
+  static const UserAction_t actions[] = {Up,    Up,     Up,     Up,   Left,
+                                         Left,  Right,  Right,  Action,
+                                         Action, Up,    Down};
+  return actions[rng_below(rng, sizeof(actions) / sizeof(actions[0]))];
+}
+
+static int load_script(const char *path, char *script) {
+  int result = 0;
+  FILE *file = fopen(path, "r");
+  if (file) {
+    int length = 0, symbol;
+    while ((symbol = fgetc(file)) != EOF && length < SIM_SCRIPT_SIZE - 1) {
+      if (strchr("lrdasp.", symbol)) {
+        script[length++] = (char)symbol;
+      }
+    }
+    script[length] = '\0';
+    fclose(file);
+  } else {
+    result = 1;
+  }
+  return result;
+}
+
+// одна игра: каждый шаг продвигает время игры на SIM_STEP_MS, фигуры и
+// случайные действия зависят только от зерна игры
+static void play_game(const Simulation_t *sim, TetrisContext *ctx,
+                      unsigned long long seed, Replay_t *record,
+                      Totals_t *totals) {
+  int length = (int)strlen(sim->script), steps = 0;
+  Rng_t rng;
+  rng_seed(&rng, seed, 1);
+  ctx->headless = true;
+  tetris_seed(ctx, seed);
+  tetris_set_randomizer(ctx, sim->bag ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM);
+  tetris_record(ctx, record);
+  tetris_set_timer(ctx, TIMER_FIXED_STEP, SIM_STEP_MS);
+  tetris_input(ctx, Start, 0);
+  GameInfo_t info = tetris_step(ctx);
+  while (info.pause != game_over && info.pause != terminate) {
+    UserAction_t action = Up;
+    if (sim->bot) {
+      action = bot_action(sim->bot, ctx);
+    } else {
+      action = length ? script_action(sim->script[steps % length])
+                      : random_action(&rng);
+    }
+    if (++steps >= sim->max_steps) {
+      action = Terminate;
+    }
+    tetris_input(ctx, action, 0);
+    info = tetris_step(ctx);
+  }
+  totals->steps += steps;
+  totals->pieces += ctx->pieces;
+  totals->lines += ctx->lines;
+  totals->score += info.score;
+}
+
+// повтор записанной игры без задержек
+static void replay_game(const Simulation_t *sim, TetrisContext *ctx,
+                        Totals_t *totals) {
+  GameInfo_t info = replay_play(sim->replay, ctx);
+  totals->steps += replay_count(sim->replay);
+  totals->pieces += ctx->pieces;
+  totals->lines += ctx->lines;
+  totals->score += info.score;
+}
+
+// первая игра пакета записывается в файл
+static int run_games(const Simulation_t *sim, TetrisPool_t *pool,
+                     Totals_t *totals) {
+  int result = 0;
+  for (int i = 0; i < sim->games && !result; ++i) {
+    TetrisContext *ctx = tetris_pool_acquire(pool);
+    if (sim->replay) {
+      replay_game(sim, ctx, totals);
+    } else {
+      unsigned long long seed = (unsigned long long)sim->seed + i;
+      Replay_t *record = NULL;
+      if (i == 0 && sim->record) {
+        record = replay_create(
+            seed, sim->bag ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM);
+        result = record == NULL;
+      }
+      play_game(sim, ctx, seed, record, totals);
+      if (record) {
+        result = replay_save(record, sim->record);
+        replay_destroy(record);
+      }
+    }
+    tetris_pool_release(pool, ctx);
+  }
+  return result;
+}
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void print_usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-n games] [-s seed] [-m max_steps] [-a actions] "
+          "[-f script_file] [-b bot_threads] [-r uniform|bag]\n"
+          "       [-w replay_file] [-p replay_file] [-S]\n"
+          "actions: l - left, r - right, d - fall, a - rotate, s - start, "
+          "p - pause, . - wait\n"
+          "-b: the games are played by the bot with the given number of "
+          "search threads\n"
+          "-r: the way the figures are chosen (uniform by default)\n"
+          "-w: the first game is recorded to the replay file\n"
+          "-p: every game replays the recorded game\n"
+          "-S: the statistics of the engine are printed (builds with "
+          "STATS=1)\n",
+          name);
+}
+
+static int parse_args(int argc, char **argv, Simulation_t *sim) {
+  int result = 0;
+  for (int i = 1; i < argc && !result; ++i) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!strcmp(argv[i], "-S")) {
+      sim->stats = true;
+      --i;  // у ключа нет значения
+    } else if (!value) {
+      result = 1;
+    } else if (!strcmp(argv[i], "-n")) {
+      sim->games = atoi(value);
+    } else if (!strcmp(argv[i], "-s")) {
+      sim->seed = (unsigned)strtoul(value, NULL, 10);
+    } else if (!strcmp(argv[i], "-m")) {
+      sim->max_steps = atoi(value);
+    } else if (!strcmp(argv[i], "-a")) {
+      snprintf(sim->script, SIM_SCRIPT_SIZE, "%s", value);
+    } else if (!strcmp(argv[i], "-f")) {
+      result = load_script(value, sim->script);
+    } else if (!strcmp(argv[i], "-b")) {
+      sim->threads = atoi(value);
+      result = sim->threads < 0;
+    } else if (!strcmp(argv[i], "-w")) {
+      sim->record = value;
+    } else if (!strcmp(argv[i], "-p")) {
+      replay_destroy(sim->replay);
+      sim->replay = replay_load(value);
+      result = sim->replay == NULL;
+    } else if (!strcmp(argv[i], "-r")) {
+      sim->bag = !strcmp(value, "bag");
+      result = !sim->bag && strcmp(value, "uniform");
+    } else {
+      result = 1;
+    }
+    ++i;
+  }
+  if (sim->games <= 0 || sim->max_steps <= 0) {
+    result = 1;
+  }
+  return result;
+}
+
+/**
+ * @brief Plays a batch of games without the interface and reports the engine
+ * throughput.
+ */
+int main(int argc, char **argv) {
+  Simulation_t sim = {
+      .games = 1000, .max_steps = SIM_MAX_STEPS, .seed = 1, .threads = -1};
+  int result = parse_args(argc, argv, &sim);
+  if (result) {
+    print_usage(argv[0]);
+  } else {
+    Totals_t totals = {0};
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // все игры по очереди используют один контекст из пула
+    TetrisPool_t *pool = tetris_pool_create(1);
+    if (sim.threads >= 0) {
+      sim.bot = bot_create(sim.threads, NULL);
+    }
+    result = pool == NULL || (sim.threads >= 0 && sim.bot == NULL);
+    if (!result) {
+      result = run_games(&sim, pool, &totals);
+    }
+    tetris_pool_destroy(pool);
+    bot_destroy(sim.bot);
+    double elapsed = seconds_since(&start);
+    if (elapsed <= 0) elapsed = 1e-9;
+    printf("games:   %d\n", sim.games);
+    printf("steps:   %lld\n", totals.steps);
+    printf("pieces:  %lld\n", totals.pieces);
+    printf("lines:   %lld\n", totals.lines);
+    printf("score:   %.1f per game\n", (double)totals.score / sim.games);
+    printf("time:    %.3f s\n", elapsed);
+    printf("games/s  %.1f\n", sim.games / elapsed);
+    printf("pieces/s %.1f\n", totals.pieces / elapsed);
+    printf("lines/s  %.1f\n", totals.lines / elapsed);
+    printf("steps/s  %.1f\n", totals.steps / elapsed);
+    if (sim.replay) {
+      // во сколько раз повтор быстрее игры в настоящем времени
+      printf("speedup  %.1f\n",
+             replay_duration(sim.replay) / 1000.0 * sim.games / elapsed);
+    }
+    if (sim.stats) {
+      printf("\n");
+      stats_dump(stdout, false);
+    }
+  }
+  replay_destroy(sim.replay);
+  return result;
+}
@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../brick_game/tetris/tune.h"
+
+#define TUNE_MAX_SETS 256
+#define TUNE_LINE_SIZE 256
+
+/**
+ * @brief Settings of the tuning program.
+ *
+ * @var config   The settings of the evaluation.
+ * @var weights  The weight sets to evaluate.
+ * @var count    The number of weight sets.
+ * @var json     `true` to print the reports in JSON.
+ */
+typedef struct {
+  TuneConfig_t config;
+  BotWeights_t weights[TUNE_MAX_SETS];
+  int count;
+  bool json;
+} Tuning_t;
+
+// набор весов из строки "высота,линии,дыры,неровность"
+static int parse_weights(const char *text, Tuning_t *tuning) {
+  BotWeights_t weights;
+  int result = tuning->count >= TUNE_MAX_SETS ||
+               sscanf(text, "%lf ,%lf ,%lf ,%lf", &weights.height,
+                      &weights.lines, &weights.holes,
+                      &weights.bumpiness) != 4;
+  if (!result) {
+    tuning->weights[tuning->count++] = weights;
+  }
+  return result;
+}
+
+// по одному набору весов в строке, пустые строки и строки с # пропускаются
+static int load_weights(const char *path, Tuning_t *tuning) {
+  int result = 0;
+  FILE *file = fopen(path, "r");
+  if (file) {
+    char line[TUNE_LINE_SIZE];
+    while (!result && fgets(line, sizeof(line), file)) {
+      const char *text = line + strspn(line, " \t");
+      if (*text != '#' && *text != '\n' && *text != '\0') {
+        result = parse_weights(text, tuning);
+      }
+    }
+    fclose(file);
+  } else {
+    result = 1;
+  }
+  return result;
+}
+
+static void print_usage(const char *name) {
+  fprintf(stderr,
+          "usage: %s [-n games] [-m max_pieces] [-s seed] [-j threads] "
+          "[-r uniform|bag]\n"
+          "       [-w height,lines,holes,bumpiness]... [-f weights_file] "
+          "[-J]\n"
+          "-n: games played with every weight set\n"
+          "-m: a game is stopped and counted as survived after this number "
+          "of figures\n"
+          "-j: worker threads, 0 - one per processor (default)\n"
+          "-w: a weight set of the bot, may be repeated; the default "
+          "weights are used\n"
+          "    if no set is given\n"
+          "-f: a file with one weight set per line\n"
+          "-J: the reports are printed in JSON\n",
+          name);
+}
+
+static int parse_args(int argc, char **argv, Tuning_t *tuning) {
+  TuneConfig_t *config = &tuning->config;
+  int result = 0;
+  for (int i = 1; i < argc && !result; ++i) {
+    const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (!strcmp(argv[i], "-J")) {
+      tuning->json = true;
+      --i;  // у ключа нет значения
+    } else if (!value) {
+      result = 1;
+    } else if (!strcmp(argv[i], "-n")) {
+      config->games = atoi(value);
+    } else if (!strcmp(argv[i], "-m")) {
+      config->max_pieces = atoi(value);
+    } else if (!strcmp(argv[i], "-s")) {
+      config->seed = strtoull(value, NULL, 10);
+    } else if (!strcmp(argv[i], "-j")) {
+      config->threads = atoi(value);
+    } else if (!strcmp(argv[i], "-r")) {
+      bool bag = !strcmp(value, "bag");
+      config->randomizer = bag ? RANDOMIZER_BAG : RANDOMIZER_UNIFORM;
+      result = !bag && strcmp(value, "uniform");
+    } else if (!strcmp(argv[i], "-w")) {
+      result = parse_weights(value, tuning);
+    } else if (!strcmp(argv[i], "-f")) {
+      result = load_weights(value, tuning);
+    } else {
+      result = 1;
+    }
+    ++i;
+  }
+  if (config->games <= 0 || config->max_pieces <= 0 || config->threads < 0) {
+    result = 1;
+  }
+  if (!result && tuning->count == 0) {
+    tuning->weights[tuning->count++] = bot_default_weights();
+  }
+  return result;
+}
+
+static void print_summary(const char *name, const TuneSummary_t *summary,
+                          bool json, bool last) {
+  if (json) {
+    printf(
+        "\"%s\": {\"mean\": %.3f, \"stddev\": %.3f, \"min\": %d, "
+        "\"p10\": %d, \"median\": %d, \"p90\": %d, \"max\": %d}%s",
+        name, summary->mean, summary->deviation, summary->min, summary->p10,
+        summary->median, summary->p90, summary->max, last ? "" : ", ");
+  } else {
+    printf("  %-7s mean %10.1f  sd %10.1f  min %7d  p10 %7d  median %7d  "
+           "p90 %7d  max %7d\n",
+           name, summary->mean, summary->deviation, summary->min,
+           summary->p10, summary->median, summary->p90, summary->max);
+  }
+}
+
+static void print_report(const TuneReport_t *report, bool json) {
+  const BotWeights_t *weights = &report->weights;
+  if (json) {
+    printf("{\"weights\": [%g, %g, %g, %g], \"games\": %d, "
+           "\"survival\": %.4f, ",
+           weights->height, weights->lines, weights->holes,
+           weights->bumpiness, report->games, report->survival);
+  } else {
+    printf("weights %g,%g,%g,%g: %d games, survival %.1f%%\n",
+           weights->height, weights->lines, weights->holes,
+           weights->bumpiness, report->games, report->survival * 100);
+  }
+  print_summary("score", &report->score, json, false);
+  print_summary("lines", &report->lines, json, false);
+  print_summary("pieces", &report->pieces, json, true);
+  printf(json ? "}\n" : "\n");
+}
+
+static double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) +
+         (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Evaluates weight sets of the bot on many games played in parallel.
+ */
+int main(int argc, char **argv) {
+  static Tuning_t tuning = {
+      .config = {.games = 1000, .max_pieces = 500, .seed = 1}};
+  static TuneReport_t reports[TUNE_MAX_SETS];
+  int result = parse_args(argc, argv, &tuning);
+  if (result) {
+    print_usage(argv[0]);
+  } else {
+    TuneStats_t stats = {0};
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = tune_run(&tuning.config, tuning.weights, tuning.count, reports,
+                      &stats);
+    double elapsed = seconds_since(&start);
+    if (elapsed <= 0) elapsed = 1e-9;
+    for (int i = 0; i < tuning.count && !result; ++i) {
+      print_report(&reports[i], tuning.json);
+    }
+    if (!result && !tuning.json) {
+      long long games = (long long)tuning.config.games * tuning.count;
+      printf("games:   %lld\n", games);
+      printf("threads: %d\n", stats.threads);
+      printf("steals:  %lld\n", stats.steals);
+      printf("time:    %.3f s\n", elapsed);
+      printf("games/s  %.1f\n", games / elapsed);
+    }
+  }
+  return result;
+}